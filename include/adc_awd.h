@@ -0,0 +1,199 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Analog watchdog triggered ADC capture with pre-trigger history
+\descrptn
+    Oscilloscope like single channel trigger. The ADC converts one input
+    continuously, the DMA writes it into a circular ring and only the
+    window around a trigger is shipped:
+    - ARMING - the ring fills; at the first half (>= pre samples of
+      history) the analog watchdog interrupt is enabled
+    - ARMED - a sample outside <low, high> raises AWD; its interrupt takes
+      the ring position of the trigger sample and DWT CYCCNT, disables AWD
+    - POST - the next half / full transfer interrupt after post samples
+      stops the conversions - the ring is frozen
+    - FROZEN - adc_awd_read() copies pre + post samples into the user's
+      buffer in time order and arms again
+    Sample k of the window (trigger sample k = pre) was converted at about
+        t - (pre - k) * ADC_AWD_CYC
+    t being taken a few cycles after the end of the trigger conversion.
+    The post window ends on a half boundary, so pre + post < n / 2 keeps
+    the history from being overwritten before the freeze.
+        static uint16_t ring[1024], win[128];
+        S_adcAwdEvent ev;
+        dma_alloc(DMA_REQ_ADC2, &s);
+        // PA1, trigger out of 1000..3000, 32 before and 96 after
+        INIT_adcAwd(&trig, ADC2, &s, 1, 1000, 3000, ring, 1024, 32, 96);
+        adc_awd_arm(&trig);
+        void dma2_stream2_isr(void){ adc_awd_irq(&trig); }
+        void adc_isr(void){ adc_awd_adc_irq(&trig); }
+        ...
+        if( adc_awd_read(&trig, &ev, win) ) send(&ev, win, ev.n);
+    The ADC prescaler is common to all ADCs (ADC_CCR) and set by the user,
+    ADC_AWD_PRE has to match it. Analog pin is set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef ADC_AWD_H_INCLUDED
+#define ADC_AWD_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// sample time, ADC_AWD_SMP_CLK ADC clocks must match ADC_AWD_SMP
+#define ADC_AWD_SMP         ADC_SMPR_SMP_15CYC
+#define ADC_AWD_SMP_CLK     15
+// APB2 / ADCCLK (ADC_CCR ADCPRE set by the user)
+#define ADC_AWD_PRE         4
+// SYSCLK / APB2
+#define ADC_AWD_CPU_APB2    2
+// ADC and stream interrupt priority
+#define ADC_AWD_PRIORITY    0x30
+//____________________________________________________
+//constants (do not change)
+// core cycles per sample, 12-bit conversion + sampling
+// 216 - 778 kS/s at APB2 84 MHz, ADCCLK 21 MHz
+#define ADC_AWD_CYC         ((ADC_AWD_SMP_CLK + 12) * ADC_AWD_PRE \
+                            * ADC_AWD_CPU_APB2)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief Trigger state
+ ****************/
+typedef enum _E_adcAwdState{
+    ADC_AWD_IDLE = 0,       // stopped
+    ADC_AWD_ARMING,         // filling the pre-trigger history
+    ADC_AWD_ARMED,          // waiting for the watchdog
+    ADC_AWD_POST,           // triggered, filling the post-trigger window
+    ADC_AWD_FROZEN          // conversions stopped, window ready
+} E_adcAwdState;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief One shipped trigger event
+ ****************/
+typedef struct _S_adcAwdEvent{
+    uint32_t t;             // DWT CYCCNT of the trigger
+    uint32_t seq;           // events since INIT, gaps - lost events
+    uint16_t level;         // trigger sample
+    uint16_t n;             // window samples, pre + post
+} S_adcAwdEvent;
+
+/****************
+ \brief Capture counters
+ ****************/
+typedef struct _S_adcAwdStats{
+    uint32_t events;        // windows read out
+    uint32_t lost;          // history overwritten before the freeze
+    uint32_t overruns;      // ADC OVR, armed again
+    uint32_t errors;        // DMA TEIF
+} S_adcAwdStats;
+
+/****************
+ \brief Capture state
+ ****************/
+typedef struct _S_adcAwd{
+    uint32_t adc;
+    S_dmaStream s;
+    uint16_t *ring;
+    uint32_t n;             // ring samples, even
+    uint32_t pre;
+    uint32_t post;
+    volatile E_adcAwdState state;
+    uint32_t trig;          // ring index of the trigger sample
+    uint32_t t;
+    uint8_t seen;           // half boundaries since the trigger
+    uint32_t seq;
+    S_adcAwdStats stats;
+} S_adcAwd;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Sets up the ADC, the watchdog window and the interrupts, stays idle
+ \param a capture state
+ \param adc ADC1..3
+ \param s stream from dma_alloc(DMA_REQ_ADCx)
+ \param channel ADC input 0..18
+ \param low lower threshold, a sample below it triggers
+ \param high upper threshold, a sample above it triggers
+ \param ring DMA ring
+ \param n samples in ring, even, at most 65534
+ \param pre samples before the trigger sample
+ \param post samples from the trigger sample on, pre + post < n / 2
+ ****************/
+void INIT_adcAwd(S_adcAwd *a, uint32_t adc, const S_dmaStream *s,
+                 uint8_t channel, uint16_t low, uint16_t high,
+                 uint16_t *ring, uint32_t n, uint32_t pre, uint32_t post);
+
+/****************
+ \brief Starts the conversions and arms the trigger once the history is in
+ \param a capture state
+ ****************/
+void adc_awd_arm(S_adcAwd *a);
+
+/****************
+ \brief Stops the conversions and the DMA
+ \param a capture state
+ ****************/
+void adc_awd_stop(S_adcAwd *a);
+
+/****************
+ \brief Ships a frozen window and arms again
+ \param a capture state
+ \param ev event header
+ \param dst pre + post samples, dst[pre] is the trigger sample
+ \retval 1 - new event in ev and dst, 0 - none
+ ****************/
+uint8_t adc_awd_read(S_adcAwd *a, S_adcAwdEvent *ev, uint16_t *dst);
+
+/****************
+ \brief Stream interrupt body - call it from dmaX_streamY_isr
+ \param a capture state
+ ****************/
+void adc_awd_irq(S_adcAwd *a);
+
+/****************
+ \brief ADC interrupt body (watchdog, overrun) - call it from adc_isr
+ \param a capture state
+ ****************/
+void adc_awd_adc_irq(S_adcAwd *a);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // ADC_AWD_H_INCLUDED
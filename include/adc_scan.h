@@ -0,0 +1,184 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timer triggered ADC scan with per channel CIC decimation
+\descrptn
+    The update event of TIM2 / TIM3 / TIM8 (TRGO) starts one scan of the
+    regular sequence, the DMA moves every result into a circular ring of
+    whole scans (channel interleaved: ch0 ch1 .. chN ch0 ch1 ..). Each
+    finished half of the ring is decimated in the stream interrupt:
+    - every channel has its CIC filter - order 1 (moving average, boxcar)
+      to 3 and ratio R; gain R^order is divided out, so the output has the
+      ADC scale (12-bit); R^order * 4095 has to fit 32 bits
+    - every `frame` scans the last output of each channel goes into one
+      S_adcFrame; R of every channel divides `frame`, so all values of a
+      frame end at the same scan - R = frame is a plain CIC decimation, a
+      shorter R a shorter window (faster, less alias rejection)
+    The main loop reads whole frames from a frame ring by adc_scan_read(),
+    never a half updated one, at 1 / frame of the scan rate.
+        static S_adcScanCh ch[3] = {
+            { .ch = 1, .order = 3, .ratio = 64 },   // temperature
+            { .ch = 2, .order = 1, .ratio = 16 },   // current
+            { .ch = 8, .order = 2, .ratio = 64 },   // battery
+        };
+        static uint16_t ring[2 * 32 * 3];
+        static S_adcFrame fr[16];
+        dma_alloc(DMA_REQ_ADC1, &s);
+        // 84 MHz / 8400 = 10 kHz scans, frames at 156 Hz
+        INIT_adcScan(&sens, ADC1, &s, TIM3, 8400, ch, 3, ring, 64, 64,
+                     fr, 16);
+        void dma2_stream0_isr(void){ adc_scan_irq(&sens); }
+        ...
+        while( adc_scan_read(&sens, &f) ) use(f.val[0], f.val[1], f.val[2]);
+    adc_scan_read() also restarts the scan after an ADC overrun. ADC and
+    timer clocks and the analog pins are set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef ADC_SCAN_H_INCLUDED
+#define ADC_SCAN_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// sample time of every channel - slow sensors, high source impedance
+#define ADC_SCAN_SMP        ADC_SMPR_SMP_56CYC
+// stream interrupt priority
+#define ADC_SCAN_PRIORITY   0x60
+//____________________________________________________
+//constants (do not change)
+#define ADC_SCAN_MAX_CH     16
+#define ADC_SCAN_MAX_ORDER  3
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief One channel of the scan and its CIC decimator
+ ****************/
+typedef struct _S_adcScanCh{
+    uint8_t ch;             // ADC input 0..18
+    uint8_t order;          // 1..ADC_SCAN_MAX_ORDER, 1 - moving average
+    uint16_t ratio;         // R, divides the frame length
+    // filled in by INIT_adcScan()
+    uint32_t gain;          // R^order
+    uint32_t n;             // inputs since the last output
+    uint32_t integ[ADC_SCAN_MAX_ORDER];
+    uint32_t comb[ADC_SCAN_MAX_ORDER];
+    uint16_t out;           // last output
+} S_adcScanCh;
+
+/****************
+ \brief One decimated frame
+ ****************/
+typedef struct _S_adcFrame{
+    uint32_t scan;          // index of the last scan in the frame
+    uint16_t val[ADC_SCAN_MAX_CH];  // in the order of the channel list
+} S_adcFrame;
+
+/****************
+ \brief Scan counters
+ ****************/
+typedef struct _S_adcScanStats{
+    uint32_t frames;
+    uint32_t dropped;       // frame ring full
+    uint32_t late;          // ring halves overwritten before decimation
+    uint32_t overruns;      // ADC OVR, scan restarted
+} S_adcScanStats;
+
+/****************
+ \brief Scan state
+ ****************/
+typedef struct _S_adcScan{
+    uint32_t adc;
+    S_dmaStream s;
+    uint32_t tim;
+    S_adcScanCh *ch;
+    uint8_t nch;
+    uint16_t *ring;
+    uint32_t scans;         // scans in the ring, even
+    uint32_t frame;         // scans per frame
+    uint32_t k;             // scans into the current frame
+    uint32_t scan;          // scans since the start
+    uint32_t halves;        // ring halves since the start
+    S_adcFrame *fr;
+    uint32_t fmask;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    S_adcScanStats stats;
+} S_adcScan;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Sets up the ADC scan, the DMA ring and the trigger timer, starts
+ \param s scan state
+ \param adc ADC1..3
+ \param dma stream from dma_alloc(DMA_REQ_ADCx)
+ \param tim trigger timer TIM2 / TIM3 / TIM8 (TRGO on update)
+ \param ticks timer clocks per scan; above 65536 the prescaler takes the
+        rest and the period is rounded down to a multiple of it
+ \param ch channel list, ch/order/ratio filled in by the user
+ \param nch channels, 1..ADC_SCAN_MAX_CH
+ \param ring DMA ring of scans * nch samples
+ \param scans scans in ring, even, scans * nch at most 65535
+ \param frame scans per frame, a multiple of every ratio
+ \param fr frame ring
+ \param nfr frames in fr, power of two
+ \retval 0 started, -1 bad timer or parameters
+ ****************/
+int INIT_adcScan(S_adcScan *s, uint32_t adc, const S_dmaStream *dma,
+                 uint32_t tim, uint32_t ticks, S_adcScanCh *ch, uint8_t nch,
+                 uint16_t *ring, uint32_t scans, uint32_t frame,
+                 S_adcFrame *fr, uint32_t nfr);
+
+/****************
+ \brief Takes the oldest decimated frame, restarts after an ADC overrun
+ \param s scan state
+ \param out frame
+ \retval 1 - out is a new frame, 0 - none
+ ****************/
+uint8_t adc_scan_read(S_adcScan *s, S_adcFrame *out);
+
+/****************
+ \brief Stream interrupt body (decimation) - call it from dmaX_streamY_isr
+ \param s scan state
+ ****************/
+void adc_scan_irq(S_adcScan *s);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // ADC_SCAN_H_INCLUDED
@@ -0,0 +1,173 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Triple interleaved ADC1/2/3 capture of one input, DMA halves
+\descrptn
+    ADC1, ADC2 and ADC3 convert the same channel in turn (triple
+    interleaved mode), each started ADC_TRIPLE_DELAY ADC clocks after the
+    previous one. DMA mode 2 moves two 12-bit results in one 32-bit word
+    from ADC_CDR, so the buffer read as uint16_t holds the samples in time
+    order. The DMA runs circular over two halves; each finished half is
+    handed to the callback from the stream interrupt together with the
+    index of its first sample and that sample's time:
+        t(k) = t0 + k * ADC_TRIPLE_CYC     (DWT CYCCNT time line)
+    t0 is CYCCNT at the software start. ADCCLK comes from the same PLL as
+    the core, so the sample spacing is exactly ADC_TRIPLE_CYC core cycles
+    and t(k) never drifts from the DWT clock (k and t wrap together).
+    Rate = ADCCLK / ADC_TRIPLE_DELAY (12-bit, 3 cycles sampling):
+    - ADCCLK 36 MHz (SYSCLK 144 MHz, APB2 72 MHz, /2): 7.2 MS/s
+    - this board, APB2 84 MHz: /4 - 21 MHz, 4.2 MS/s in the datasheet
+      limit; /2 - 42 MHz, 8.4 MS/s over the 36 MHz limit (worse ENOB)
+        static uint16_t cap[2 * 4096];
+        S_dmaStream s;
+        dma_alloc(DMA_REQ_ADC1, &s);
+        INIT_adcTriple(&scope, &s, 0, cap, 2 * 4096, on_half, 0);  // PA0
+        adc_triple_start(&scope);
+        void dma2_stream0_isr(void){ adc_triple_irq(&scope); }
+        void adc_isr(void){ adc_triple_adc_irq(&scope); }
+    The callback has one half of the buffer time (4096 samples - 975 us at
+    4.2 MS/s) before its half is overwritten; a late one skips a half
+    (stats.late, the index shows the gap). An overrun of the ADCs (the DMA
+    did not keep up) stops the capture, adc_triple_start() restarts it
+    with a new t0. ADC clocks and the analog pin are set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef ADC_TRIPLE_H_INCLUDED
+#define ADC_TRIPLE_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// ADCCLK = APB2 / ADC_TRIPLE_PRE, ADC_CCR_ADCPRE_BYx must match
+#define ADC_TRIPLE_PRE      4
+#define ADC_TRIPLE_ADCPRE   ADC_CCR_ADCPRE_BY4
+// SYSCLK / APB2
+#define ADC_TRIPLE_CPU_APB2 2
+// ADC clocks between two samples, 3 cycles sampling + 12-bit = 15 / 3
+#define ADC_TRIPLE_DELAY    5
+#define ADC_TRIPLE_CCR_DLY  ADC_CCR_DELAY_5ADCCLK
+// ADC and stream interrupt priority
+#define ADC_TRIPLE_PRIORITY 0x20
+//____________________________________________________
+//constants (do not change)
+// core cycles between two samples
+#define ADC_TRIPLE_CYC      (ADC_TRIPLE_DELAY * ADC_TRIPLE_PRE \
+                            * ADC_TRIPLE_CPU_APB2)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief A finished half - from the stream interrupt
+ \param arg given to INIT_adcTriple()
+ \param smp samples in time order
+ \param n samples
+ \param first index of smp[0] since the start
+ \param t DWT CYCCNT of smp[0]
+ ****************/
+typedef void (*F_adcTripleHalf)(void *arg, const uint16_t *smp, uint32_t n,
+                                uint32_t first, uint32_t t);
+
+/****************
+ \brief Capture counters
+ ****************/
+typedef struct _S_adcTripleStats{
+    uint32_t halves;        // delivered
+    uint32_t late;          // halves overwritten before delivery
+    uint32_t overruns;      // ADC OVR - capture stopped
+    uint32_t errors;        // DMA TEIF
+} S_adcTripleStats;
+
+/****************
+ \brief Capture state
+ ****************/
+typedef struct _S_adcTriple{
+    S_dmaStream s;
+    uint8_t channel;
+    uint16_t *buf;
+    uint32_t half;          // samples per half
+    F_adcTripleHalf cb;
+    void *arg;
+    uint32_t halves;        // halves finished since the start
+    uint32_t t0;            // DWT CYCCNT of the start
+    volatile uint8_t running;
+    S_adcTripleStats stats;
+} S_adcTriple;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Sets up ADC1/2/3 for triple interleaved conversion of one channel
+        and powers them on (takes all three ADCs and the common register)
+ \param a capture state
+ \param s stream from dma_alloc(DMA_REQ_ADC1)
+ \param channel input common to the three ADCs (ADC123_INx: 0..3, 10..13)
+ \param buf two halves, 32-bit aligned
+ \param n samples in buf, multiple of 4, at most 131070
+ \param cb finished half callback
+ \param arg passed to cb
+ ****************/
+void INIT_adcTriple(S_adcTriple *a, const S_dmaStream *s, uint8_t channel,
+                    uint16_t *buf, uint32_t n, F_adcTripleHalf cb, void *arg);
+
+/****************
+ \brief Starts the capture, sample 0 at t0 = now
+ \param a capture state
+ ****************/
+void adc_triple_start(S_adcTriple *a);
+
+/****************
+ \brief Stops the conversions and the DMA
+ \param a capture state
+ ****************/
+void adc_triple_stop(S_adcTriple *a);
+
+/****************
+ \brief Stream interrupt body - call it from the dmaX_streamY_isr
+ \param a capture state
+ ****************/
+void adc_triple_irq(S_adcTriple *a);
+
+/****************
+ \brief ADC interrupt body (overrun) - call it from adc_isr
+ \param a capture state
+ ****************/
+void adc_triple_adc_irq(S_adcTriple *a);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // ADC_TRIPLE_H_INCLUDED
@@ -0,0 +1,178 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Streaming COBS framing with a hardware CRC-32 trailer
+\descrptn
+    Frame on the wire:  COBS( payload | CRC-32/MPEG-2(payload), big-endian )
+                        0x00
+    Consistent Overhead Byte Stuffing removes every zero from the data (one
+    code byte per <= 254 bytes), so 0x00 delimits frames and a receiver
+    resynchronises on the next zero after any error.
+    - encoder: cobs_enc_begin() / cobs_enc_feed() any number of spans /
+      cobs_enc_end(); it writes straight into the caller's TX (DMA) buffer.
+      Zero-free words are found and copied 4 bytes at a time, the CRC runs
+      on the CRC unit (crc_hw.h) - about 2 cycles per byte in total
+    - decoder: cobs_dec_feed() takes whatever span is at hand, typically the
+      USART RX ring in place (no copy into a line buffer first):
+          const uint8_t *p;
+          uint32_t n;
+          while( (n = usart_buf_rx_span(&u1, &p)) )
+          {
+              cobs_dec_feed(&dec, p, n);
+              usart_buf_rx_consume(&u1, n);
+          }
+      frame(arg, payload, len) is called for every frame whose CRC matches
+    The CRC of a payload followed by its CRC is 0, which is what the decoder
+    checks. scripts/cobs_frame.py is the host side reference.
+    The CRC unit clock must be on (INIT_crcHw()).
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef COBS_H_INCLUDED
+#define COBS_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+//____________________________________________________
+//constants (do not change)
+#define COBS_CRC_BYTES      4
+//____________________________________________________
+// macro functions (do not use often!)
+// worst case encoded frame size of a len byte payload, delimiter included
+#define COBS_ENC_MAX(len)   ((len) + COBS_CRC_BYTES \
+                            + ((len) + COBS_CRC_BYTES) / 254 + 2)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief Encoder state
+ ****************/
+typedef struct _S_cobsEnc{
+    uint8_t *out;
+    uint32_t size;
+    uint32_t n;             // bytes written, the open code byte included
+    uint32_t code_at;       // index of the open code byte
+    uint32_t code;          // 1 + data bytes in the open block
+    uint32_t crc;
+    uint32_t err;           // out too small
+} S_cobsEnc;
+
+typedef void (*F_cobsFrame)(void *arg, const uint8_t *payload, uint32_t len);
+
+/****************
+ \brief Decoder counters
+ ****************/
+typedef struct _S_cobsDecStats{
+    uint32_t frames;        // good frames delivered
+    uint32_t crc_errors;
+    uint32_t runts;         // shorter than the CRC
+    uint32_t overflows;     // longer than the frame buffer
+    uint32_t truncated;     // delimiter inside a block
+} S_cobsDecStats;
+
+/****************
+ \brief Decoder state
+ ****************/
+typedef struct _S_cobsDec{
+    uint8_t *buf;           // decoded payload + CRC
+    uint32_t size;
+    uint32_t n;
+    uint32_t left;          // data bytes left in the block, 0 - code next
+    uint32_t zero;          // a zero is due before the next block
+    uint32_t skip;          // overflowed, dropping until the delimiter
+    F_cobsFrame frame;
+    void *arg;
+    S_cobsDecStats stats;
+} S_cobsDec;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Starts a frame in out
+ \param e encoder state
+ \param out frame buffer, COBS_ENC_MAX(payload length) is always enough
+ \param size out bytes
+ ****************/
+void cobs_enc_begin(S_cobsEnc *e, uint8_t *out, uint32_t size);
+
+/****************
+ \brief Appends len payload bytes
+ \param e encoder state
+ \param p payload span
+ \param len bytes
+ \retval 0, -1 when out is too small (the frame is lost)
+ ****************/
+int cobs_enc_feed(S_cobsEnc *e, const void *p, uint32_t len);
+
+/****************
+ \brief Appends the CRC and the delimiter
+ \param e encoder state
+ \retval frame length in out, 0 when out was too small
+ ****************/
+uint32_t cobs_enc_end(S_cobsEnc *e);
+
+/****************
+ \brief One-shot encoder
+ \param p payload
+ \param len payload bytes
+ \param out frame buffer
+ \param size out bytes
+ \retval frame length, 0 when out is too small
+ ****************/
+uint32_t cobs_encode(const void *p, uint32_t len, uint8_t *out,
+                     uint32_t size);
+
+/****************
+ \brief Prepares a decoder
+ \param d decoder state
+ \param buf frame buffer - largest payload + COBS_CRC_BYTES
+ \param size buf bytes
+ \param frame called from cobs_dec_feed() for every good frame
+ \param arg passed to frame
+ ****************/
+void INIT_cobsDec(S_cobsDec *d, uint8_t *buf, uint32_t size,
+                  F_cobsFrame frame, void *arg);
+
+/****************
+ \brief Decodes a received span, frames may start and end anywhere in it
+ \param d decoder state
+ \param p received bytes
+ \param len bytes
+ ****************/
+void cobs_dec_feed(S_cobsDec *d, const uint8_t *p, uint32_t len);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // COBS_H_INCLUDED
@@ -0,0 +1,196 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Byte stream CRC-32/MPEG-2 on the hardware CRC unit
+\descrptn
+    The F4 CRC unit takes only whole 32-bit words (MSB first, poly
+    0x04C11DB7, init 0xFFFFFFFF, no reflection, no final xor) and cannot be
+    loaded with a start value. crc_hw_update() makes it usable for byte
+    streams split into arbitrary spans:
+    - words are fed byte-swapped (REV), so the result equals the standard
+      CRC-32/MPEG-2 of the bytes ("123456789" -> 0x0376E6E7)
+    - unaligned head and tail bytes go through a 16-entry nibble table
+    - a running CRC is restored after the unit reset by feeding one word
+      computed backwards from it (32 inverse shift steps)
+    Each call owns the unit only with interrupts masked, so the CRC can be
+    shared between interrupt and thread contexts; long spans are fed
+    CRC_HW_MASK_WORDS at a time with the running CRC carried over, so the
+    masked time stays bounded (the unit is reloaded only when another
+    context used it in between).
+    The CRC of data followed by its own CRC (big-endian) is 0.
+    crc_hw_crc32() is the standard CRC-32 (zlib, Ethernet, PNG) on the same
+    unit. The reflected CRC is the mirror image of the MSB first one, so
+    the words are fed bit reversed (RBIT) and the register is read back
+    bit reversed; the call convention is the one of zlib crc32():
+        crc = crc_hw_crc32(0, "123456789", 9);     // 0xCBF43926
+        crc = crc_hw_crc32(crc, more, n);
+    S_crcHwDma lets DMA2 feed CRC_DR (memory-to-memory, CRC_DR fixed) and
+    leaves the CPU free; the FIFO packs byte reads into words, so any
+    alignment goes. The DMA can neither swap nor reverse bits, so the
+    result is the unit's native word CRC: little-endian 32-bit words MSB
+    first - the same as libopencm3 crc_calculate_block() and the ST tools;
+    a last partial word is padded with zero bytes.
+        dma_alloc(DMA_REQ_MEM, &s);
+        INIT_crcHwDma(&img, &s);
+        void dma2_stream3_isr(void){ crc_hw_dma_irq(&img); }
+        crc_hw_dma_begin(&img);
+        crc_hw_dma_update(&img, (void *)0x08020000, 128 * 1024, 0, 0);
+        ... other work, more spans after img.busy is 0 ...
+        crc = crc_hw_dma_final(&img);
+    While a DMA job holds the unit, the CPU functions compute in software.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef CRC_HW_H_INCLUDED
+#define CRC_HW_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// bytes below which crc_hw_dma_update() feeds the unit by the CPU
+#define CRC_HW_DMA_MIN      256
+// stream interrupt priority
+#define CRC_HW_DMA_PRIORITY 0xC0
+// words fed by the CPU per interrupts masked section (256 - a few us)
+#define CRC_HW_MASK_WORDS   256
+//____________________________________________________
+//constants (do not change)
+// start value of a new CRC
+#define CRC_HW_INIT         0xFFFFFFFFu
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief End of a crc_hw_dma_update() span
+ \param arg given to crc_hw_dma_update()
+ ****************/
+typedef void (*F_crcHwDone)(void *arg);
+
+/****************
+ \brief DMA CRC counters
+ ****************/
+typedef struct _S_crcHwDmaStats{
+    uint32_t dma_jobs;
+    uint32_t cpu_jobs;      // short spans, or the unit was taken
+    uint32_t errors;        // TEIF (e.g. CCM RAM) - redone by the CPU
+} S_crcHwDmaStats;
+
+/****************
+ \brief Incremental word CRC fed by DMA
+ ****************/
+typedef struct _S_crcHwDma{
+    S_dmaStream s;
+    uint32_t crc;           // running word CRC of the whole words
+    uint8_t tail[4];        // bytes of an unfinished word
+    uint8_t ntail;
+    const uint8_t *start;   // running job
+    uint32_t len;
+    const uint8_t *p;       // next chunk
+    uint32_t left;
+    F_crcHwDone done;
+    void *arg;
+    volatile uint8_t busy;
+    S_crcHwDmaStats stats;
+} S_crcHwDma;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Enables the CRC unit clock
+ ****************/
+void INIT_crcHw(void);
+
+/****************
+ \brief Continues a CRC-32/MPEG-2 over len more bytes
+ \param crc CRC_HW_INIT or the value returned for the previous span
+ \param p data, any alignment
+ \param len bytes
+ \retval running CRC
+ ****************/
+uint32_t crc_hw_update(uint32_t crc, const void *p, uint32_t len);
+
+/****************
+ \brief Continues a standard (zlib) CRC-32 over len more bytes
+ \param crc 0 or the value returned for the previous span
+ \param p data, any alignment
+ \param len bytes
+ \retval CRC-32 of all the spans so far, final xor included
+ ****************/
+uint32_t crc_hw_crc32(uint32_t crc, const void *p, uint32_t len);
+
+/****************
+ \brief Binds a DMA CRC context to a memory-to-memory stream, begins it
+ \param c context
+ \param s stream from dma_alloc(DMA_REQ_MEM) (DMA2)
+ ****************/
+void INIT_crcHwDma(S_crcHwDma *c, const S_dmaStream *s);
+
+/****************
+ \brief Starts a new word CRC
+ \param c context, not busy
+ ****************/
+void crc_hw_dma_begin(S_crcHwDma *c);
+
+/****************
+ \brief Adds a span; from CRC_HW_DMA_MIN bytes on the DMA feeds the unit
+ \param c context
+ \param p data, any alignment, valid until done
+ \param len bytes
+ \param done called at the end - from the stream interrupt, or before
+        the return for a span done by the CPU; may be 0
+ \param arg passed to done
+ \retval 0 - accepted, -1 - the previous span still runs
+ ****************/
+int crc_hw_dma_update(S_crcHwDma *c, const void *p, uint32_t len,
+                      F_crcHwDone done, void *arg);
+
+/****************
+ \brief Word CRC of all spans, a partial last word padded with zeros
+ \param c context, not busy (it is not changed)
+ \retval word CRC
+ ****************/
+uint32_t crc_hw_dma_final(const S_crcHwDma *c);
+
+/****************
+ \brief Stream interrupt body - call it from the dma2_streamY_isr
+ \param c context
+ ****************/
+void crc_hw_dma_irq(S_crcHwDma *c);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // CRC_HW_H_INCLUDED
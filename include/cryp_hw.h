@@ -0,0 +1,189 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Asynchronous AES / TDES on the CRYP unit, DMA in and out
+\descrptn
+    cryp_hw_queue() queues a job and returns at once; DMA2 feeds CRYP_DIN
+    (DMA_REQ_CRYP_IN) and empties CRYP_DOUT (DMA_REQ_CRYP_OUT) at the pace
+    of the unit, done(arg, err) is called from the out stream interrupt.
+    A job names its context - mode, direction, key and the running IV:
+        S_crypHwCtx tx;
+        INIT_crypHw();
+        void dma2_stream5_isr(void){ cryp_hw_irq(); }  // CRYP_OUT
+        void dma2_stream6_isr(void){ cryp_hw_irq(); }  // CRYP_IN
+        cryp_hw_ctx(&tx, CRYP_HW_AES_CTR, 0, key, 16, nonce);
+        cryp_hw_queue(&tx, frame, enc, 256, sent, &frame_no);
+        cryp_hw_queue(&tx, frame2, enc2, 256, sent, &frame_no2);
+    - CBC and CTR run on across the jobs of one context: the IV registers
+      are read back at the end of a job, so buffers of a stream need not
+      be contiguous (CTR counts in the last 32 bits of the IV)
+    - the key is loaded (and prepared for AES ECB/CBC decryption) only when
+      the context differs from the one of the previous job
+    - lengths are whole blocks (16 bytes AES, 8 bytes TDES), any alignment;
+      buffers must not be in CCM RAM, in and out may be the same
+    - keys/IVs are byte strings as in FIPS-197 / SP800-38A
+    cryp_hw_selftest() runs the FIPS-197, SP800-38A and SP800-67 known
+    answers through the queue, split in two jobs to check the IV chaining.
+    The CRYP unit exists on the STM32F415/417 only - the F407 of this board
+    has none, set CRYP_HW_UNIT for those chips.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef CRYP_HW_H_INCLUDED
+#define CRYP_HW_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// 1 - STM32F415/417 with the CRYP unit, 0 - none (F405/407)
+#ifndef CRYP_HW_UNIT
+#define CRYP_HW_UNIT        0
+#endif
+// jobs waiting for the unit
+#define CRYP_HW_QUEUE       8
+// stream interrupt priority
+#define CRYP_HW_PRIORITY    0xC0
+//____________________________________________________
+//constants (do not change)
+// done callback err values
+#define CRYP_HW_OK          0
+#define CRYP_HW_ERR_TRANSFER 1  // TEIF - the output is not valid
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief Cipher and chaining
+ ****************/
+typedef enum _E_crypHwMode{
+    CRYP_HW_AES_ECB = 0,
+    CRYP_HW_AES_CBC,
+    CRYP_HW_AES_CTR,
+    CRYP_HW_TDES_ECB,
+    CRYP_HW_TDES_CBC
+} E_crypHwMode;
+
+//____________________________________________________
+// structs
+
+typedef void (*F_crypHwDone)(void *arg, int err);
+
+/****************
+ \brief Key and running IV of one stream
+ ****************/
+typedef struct _S_crypHwCtx{
+    uint32_t cr;            // CRYP_CR, CRYPEN off
+    uint8_t block;          // bytes
+    uint8_t chain;          // CBC / CTR - the IV runs on
+    uint8_t prep;           // AES decryption key schedule needed
+    uint32_t key[8];        // K0LR..K3RR
+    uint32_t iv[4];         // IV0LR..IV1RR
+} S_crypHwCtx;
+
+/****************
+ \brief Service counters
+ ****************/
+typedef struct _S_crypHwStats{
+    uint32_t jobs;
+    uint32_t bytes;
+    uint32_t chunks;        // NDTR reloads (jobs over 256 KB)
+    uint32_t rekeys;        // key loads - context changes
+    uint32_t errors;
+    uint32_t full;          // calls refused on a full queue
+} S_crypHwStats;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Enables the unit, claims the in/out streams, enables their
+        interrupts
+ \retval 0 - ok, -1 - no unit (CRYP_HW_UNIT 0) or no free stream
+ ****************/
+int INIT_crypHw(void);
+
+/****************
+ \brief Sets up a context, the next job of it loads the key
+ \param x context, no job of it queued
+ \param mode CRYP_HW_*
+ \param decrypt 0 - encryption, 1 - decryption
+ \param key 16 / 24 / 32 bytes AES, 24 bytes TDES (K1 K2 K3)
+ \param klen key bytes
+ \param iv 16 bytes AES, 8 bytes TDES; 0 - zeros (ECB)
+ \retval 0 - ok, -1 - bad key length
+ ****************/
+int cryp_hw_ctx(S_crypHwCtx *x, E_crypHwMode mode, uint8_t decrypt,
+                const uint8_t *key, uint8_t klen, const uint8_t *iv);
+
+/****************
+ \brief Queues a job, the buffers must stay untouched until done
+ \param x context, valid until done
+ \param in data
+ \param out result, may be in
+ \param len bytes, whole blocks
+ \param done called from the out stream interrupt (may be 0)
+ \param arg passed to done
+ \retval 0 queued, -1 queue full, no unit or bad length
+ ****************/
+int cryp_hw_queue(S_crypHwCtx *x, const void *in, void *out, uint32_t len,
+                  F_crypHwDone done, void *arg);
+
+/****************
+ \brief Stream interrupt body - call it from both dma2_streamY_isr
+ ****************/
+void cryp_hw_irq(void);
+
+/****************
+ \brief Number of jobs not finished yet
+ ****************/
+uint32_t cryp_hw_busy(void);
+
+/****************
+ \brief Waits until every queued job is finished
+ ****************/
+void cryp_hw_wait(void);
+
+/****************
+ \brief Service counters
+ ****************/
+const S_crypHwStats *cryp_hw_stats(void);
+
+/****************
+ \brief Encrypts and decrypts the known answer vectors through the queue
+ \retval number of failed vectors, -1 - no unit
+ ****************/
+int cryp_hw_selftest(void);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // CRYP_HW_H_INCLUDED
@@ -0,0 +1,193 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timer triggered DAC waveform playback by DMA, one or two channels
+\descrptn
+    The update event of a timer (TRGO) moves the holding register of the
+    DAC to its output, the DAC then asks the DMA for the next sample. No
+    CPU per sample - 1 MS/s is 84 timer clocks per sample.
+    Outputs:
+    - DAC_PLAY_CH1 / DAC_PLAY_CH2: uint16_t samples (12-bit, right aligned)
+      into DHR12R1 / DHR12R2
+    - DAC_PLAY_DUAL: uint32_t samples, ch1 in bits 0..11, ch2 in 16..27
+      (DAC_PLAY_DUAL_SMP()), into DHR12RD - both channels have the same
+      trigger and change in the same DAC clock; only channel 1 asks the DMA
+    Modes of dac_play_start() as in tim_burst.h:
+    - DAC_PLAY_ONCE: the table plays once, the last sample stays
+    - DAC_PLAY_LOOP: the table repeats (circular DMA) - arbitrary waveform
+    - DAC_PLAY_STREAM: two halves, the half the DMA has just left is
+      refilled by fill() from the stream interrupt; when fill() returns 0
+      its half is the last one, the other half is padded with the last
+      sample and the playback stops after the last half
+        static uint32_t tab[2 * 256];
+        dma_alloc(DMA_REQ_DAC1, &s);
+        // TIM6 at 84 MHz / 84 = 1 MS/s, PA4 + PA5 analog
+        INIT_dacPlay(&stim, DAC_PLAY_DUAL, TIM6, 84, &s);
+        dac_play_start(&stim, tab, 2 * 256, DAC_PLAY_STREAM, gen, &g);
+        void dma1_stream5_isr(void){ dac_play_irq(&stim); }
+        void tim6_dac_isr(void){ dac_play_dac_irq(&stim); }
+    A DMA that does not deliver within one sample period raises the DAC
+    underrun - the DAC stops asking, the playback is stopped and counted.
+    The DAC clock and the analog pins are set up by the user, the timer is
+    taken by the engine (its update event only).
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef DAC_PLAY_H_INCLUDED
+#define DAC_PLAY_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// stream and DAC underrun interrupt priority
+#define DAC_PLAY_PRIORITY   0x40
+//____________________________________________________
+//constants (do not change)
+//____________________________________________________
+// macro functions (do not use often!)
+// one DAC_PLAY_DUAL sample
+#define DAC_PLAY_DUAL_SMP(ch1, ch2) \
+    ((uint32_t)((ch1) & 0xFFF) | ((uint32_t)((ch2) & 0xFFF) << 16))
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief Driven outputs
+ ****************/
+typedef enum _E_dacPlayOut{
+    DAC_PLAY_CH1 = 0,       // PA4
+    DAC_PLAY_CH2,           // PA5
+    DAC_PLAY_DUAL           // both, synchronous
+} E_dacPlayOut;
+
+/****************
+ \brief Playback mode
+ ****************/
+typedef enum _E_dacPlayMode{
+    DAC_PLAY_ONCE = 0,
+    DAC_PLAY_LOOP,
+    DAC_PLAY_STREAM
+} E_dacPlayMode;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief Refill of a stream half
+ \param arg given to dac_play_start()
+ \param half samples to fill, uint16_t or uint32_t (DAC_PLAY_DUAL)
+ \param samples samples in the half
+ \retval 1 - more follows, 0 - this half is the last one
+ ****************/
+typedef uint8_t (*F_dacPlayFill)(void *arg, void *half, uint32_t samples);
+
+/****************
+ \brief Playback counters
+ ****************/
+typedef struct _S_dacPlayStats{
+    uint32_t plays;
+    uint32_t refills;
+    uint32_t late;          // both halves done before the refill - glitch
+    uint32_t underruns;     // DAC DMAUDR - stopped
+    uint32_t errors;        // TEIF
+} S_dacPlayStats;
+
+/****************
+ \brief Playback engine state
+ ****************/
+typedef struct _S_dacPlay{
+    E_dacPlayOut out;
+    uint32_t tim;
+    S_dmaStream s;
+    uint8_t item;           // bytes per sample, 2 / 4
+    E_dacPlayMode mode;
+    uint8_t *buf;
+    uint32_t half;          // samples per stream half
+    F_dacPlayFill fill;
+    void *arg;
+    uint8_t ending;         // stream: 1 - last half queued, 2 - padded
+    volatile uint8_t busy;
+    S_dacPlayStats stats;
+} S_dacPlay;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Sets up the DAC channel(s) and the trigger timer, which starts
+ \param p engine state
+ \param out DAC_PLAY_*
+ \param tim TIM2, TIM4..TIM8 (DAC triggers)
+ \param ticks timer clocks per sample; above 65536 the prescaler takes
+        the rest and the period is rounded down to a multiple of it
+ \param s stream from dma_alloc(DMA_REQ_DAC1) (DAC_PLAY_CH1 / DUAL) or
+        DMA_REQ_DAC2 (DAC_PLAY_CH2)
+ \retval 0 - ok, -1 - no DAC trigger from tim
+ ****************/
+int INIT_dacPlay(S_dacPlay *p, E_dacPlayOut out, uint32_t tim,
+                 uint32_t ticks, const S_dmaStream *s);
+
+/****************
+ \brief Starts a table - the first sample goes out at the next update
+ \param p engine state
+ \param buf samples, must stay valid while playing
+ \param samples samples in buf (even for DAC_PLAY_STREAM), at most 65535
+ \param mode DAC_PLAY_*
+ \param fill stream refill, called for both halves before the start
+        (DAC_PLAY_STREAM only, 0 otherwise)
+ \param arg passed to fill
+ \retval 0 started, -1 busy or bad size
+ ****************/
+int dac_play_start(S_dacPlay *p, void *buf, uint32_t samples,
+                   E_dacPlayMode mode, F_dacPlayFill fill, void *arg);
+
+/****************
+ \brief Stops the DMA, the outputs keep the last sample
+ \param p engine state
+ ****************/
+void dac_play_stop(S_dacPlay *p);
+
+/****************
+ \brief Stream interrupt body - call it from the dmaX_streamY_isr
+ \param p engine state
+ ****************/
+void dac_play_irq(S_dacPlay *p);
+
+/****************
+ \brief DAC underrun interrupt body - call it from tim6_dac_isr
+ \param p engine state
+ ****************/
+void dac_play_dac_irq(S_dacPlay *p);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // DAC_PLAY_H_INCLUDED
@@ -0,0 +1,153 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      DMA stream/channel allocator for the STM32F40x request mapping
+\descrptn
+    A peripheral request (E_dmaReq) can be served only by fixed
+    DMA controller/stream/channel triples (RM0090 tables 42 and 43).
+    dma_alloc() picks the first free stream able to serve the request, so
+    modules do not hard-code streams and collide. The returned S_dmaStream
+    carries everything for dma_configure() and the stream interrupt:
+        S_dmaStream tx;
+        struct dma_stream_desc d = {0};
+        if( dma_alloc(DMA_REQ_SPI2_TX, &tx) ) fail;
+        d.channel = tx.channel; ... ;
+        dma_configure(tx.dma, tx.stream, &d);
+        nvic_enable_irq(tx.irqn);
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef DMA_ALLOC_H_INCLUDED
+#define DMA_ALLOC_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+#include <libopencm3/stm32/dma.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+//____________________________________________________
+//constants (do not change)
+// 2 controllers x 8 streams
+#define DMA_STREAM_COUNT    16
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief DMA requests of the STM32F40x peripherals
+ ****************/
+typedef enum _E_dmaReq{
+    DMA_REQ_MEM = 0,        // memory to memory (DMA2 only)
+    DMA_REQ_ADC1, DMA_REQ_ADC2, DMA_REQ_ADC3,
+    DMA_REQ_DAC1, DMA_REQ_DAC2,
+    DMA_REQ_SPI1_RX, DMA_REQ_SPI1_TX,
+    DMA_REQ_SPI2_RX, DMA_REQ_SPI2_TX,
+    DMA_REQ_SPI3_RX, DMA_REQ_SPI3_TX,
+    DMA_REQ_I2C1_RX, DMA_REQ_I2C1_TX,
+    DMA_REQ_I2C2_RX, DMA_REQ_I2C2_TX,
+    DMA_REQ_I2C3_RX, DMA_REQ_I2C3_TX,
+    DMA_REQ_USART1_RX, DMA_REQ_USART1_TX,
+    DMA_REQ_USART2_RX, DMA_REQ_USART2_TX,
+    DMA_REQ_USART3_RX, DMA_REQ_USART3_TX,
+    DMA_REQ_UART4_RX, DMA_REQ_UART4_TX,
+    DMA_REQ_UART5_RX, DMA_REQ_UART5_TX,
+    DMA_REQ_USART6_RX, DMA_REQ_USART6_TX,
+    DMA_REQ_SDIO, DMA_REQ_DCMI,
+    DMA_REQ_CRYP_IN, DMA_REQ_CRYP_OUT, DMA_REQ_HASH_IN,
+    DMA_REQ_TIM1_UP, DMA_REQ_TIM1_CH1, DMA_REQ_TIM1_CH2, DMA_REQ_TIM1_CH3,
+    DMA_REQ_TIM1_CH4, DMA_REQ_TIM1_TRIG, DMA_REQ_TIM1_COM,
+    DMA_REQ_TIM2_UP, DMA_REQ_TIM2_CH1, DMA_REQ_TIM2_CH2, DMA_REQ_TIM2_CH3,
+    DMA_REQ_TIM2_CH4,
+    DMA_REQ_TIM3_UP, DMA_REQ_TIM3_CH1, DMA_REQ_TIM3_CH2, DMA_REQ_TIM3_CH3,
+    DMA_REQ_TIM3_CH4, DMA_REQ_TIM3_TRIG,
+    DMA_REQ_TIM4_UP, DMA_REQ_TIM4_CH1, DMA_REQ_TIM4_CH2, DMA_REQ_TIM4_CH3,
+    DMA_REQ_TIM5_UP, DMA_REQ_TIM5_CH1, DMA_REQ_TIM5_CH2, DMA_REQ_TIM5_CH3,
+    DMA_REQ_TIM5_CH4, DMA_REQ_TIM5_TRIG,
+    DMA_REQ_TIM6_UP, DMA_REQ_TIM7_UP,
+    DMA_REQ_TIM8_UP, DMA_REQ_TIM8_CH1, DMA_REQ_TIM8_CH2, DMA_REQ_TIM8_CH3,
+    DMA_REQ_TIM8_CH4, DMA_REQ_TIM8_TRIG, DMA_REQ_TIM8_COM,
+    DMA_REQ_COUNT
+} E_dmaReq;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief An allocated stream
+ ****************/
+typedef struct _S_dmaStream{
+    uint32_t dma;           // DMA1 or DMA2
+    uint8_t stream;         // DMA_STREAM0..7
+    uint8_t irqn;           // NVIC_DMAx_STREAMy_IRQ
+    uint8_t req;            // E_dmaReq it serves
+    uint32_t channel;       // DMA_SxCR_CHSEL_n - for dma_stream_desc.channel
+} S_dmaStream;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Claims the first free stream that can serve req, enables the
+        controller clock and resets the stream
+ \param req peripheral request
+ \param out filled on success
+ \retval 0 on success, -1 if every matching stream is taken
+ ****************/
+int dma_alloc(E_dmaReq req, S_dmaStream *out);
+
+/****************
+ \brief Claims one particular stream (e.g. to keep a known pin-out free)
+ \param req peripheral request
+ \param dma DMA1 or DMA2
+ \param stream DMA_STREAM0..7
+ \param out filled on success
+ \retval 0 on success, -1 if taken or the stream cannot serve req
+ ****************/
+int dma_alloc_stream(E_dmaReq req, uint32_t dma, uint8_t stream,
+                     S_dmaStream *out);
+
+/****************
+ \brief Stops and releases a stream claimed by dma_alloc*()
+ \param s allocated stream
+ ****************/
+void dma_free(const S_dmaStream *s);
+
+/****************
+ \brief Owner of a stream
+ \param dma DMA1 or DMA2
+ \param stream DMA_STREAM0..7
+ \retval E_dmaReq + 1 of the owner, 0 when free
+ ****************/
+uint32_t dma_stream_owner(uint32_t dma, uint8_t stream);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // DMA_ALLOC_H_INCLUDED
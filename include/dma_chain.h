@@ -0,0 +1,170 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Software scatter-gather on the F4 DMA double buffer mode
+\descrptn
+    Sends/receives a list of (address, count) segments to/from a peripheral
+    as one logical transfer, without copying them into a bounce buffer.
+    The stream runs in double buffer mode and the TC interrupt refills the
+    target the DMA just left:
+    - next segment of the same length -> queued into the idle target, the
+      hardware switches without any gap
+    - next segment longer (NDTR is shared by both targets) or the last one
+      -> the idle target points to it anyway, the TC interrupt stops the
+      stream and restarts it with the right count, continuing after the
+      items that already went through - the gap is the restart time
+    - next segment shorter, or none -> the run has no idle target (DBM off)
+      and stops by itself at TC; a late interrupt can then never move items
+      past a segment - the next one starts from the TC interrupt
+    - the last segment always runs without DBM, so nothing is sent or
+      received after it
+    Segment counts are in peripheral data items (NDTR units), memory and
+    peripheral sizes must match. Memory-to-memory cannot use double buffer
+    mode, so only peripheral transfers can be chained.
+    The gaps and the TC-to-refill latency are measured with DWT CYCCNT.
+    dma_chain_selftest() runs a list of unequal segments to DMA_CHAIN_OK
+    (it takes TIM6 and the TIM6_UP stream for the time of the test).
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef DMA_CHAIN_H_INCLUDED
+#define DMA_CHAIN_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+//____________________________________________________
+//constants (do not change)
+// done callback err values
+#define DMA_CHAIN_OK            0
+#define DMA_CHAIN_ERR_TRANSFER  1   // TEIF - bus error on an address
+#define DMA_CHAIN_ERR_LATE      2   // TC serviced after the next segment ended
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief One piece of the logical transfer
+ ****************/
+typedef struct _S_dmaSeg{
+    volatile void *addr;
+    uint16_t count;         // data items, > 0
+} S_dmaSeg;
+
+/****************
+ \brief Timing of the chained transfers (DWT cycles)
+ ****************/
+typedef struct _S_dmaChainStats{
+    uint32_t segments;      // segments completed
+    uint32_t switches;      // hardware target switches (no gap)
+    uint32_t restarts;      // stream restarts on a length change
+    uint32_t gap_min;       // restart gap, TC interrupt entry to EN
+    uint32_t gap_max;
+    uint32_t gap_sum;
+    uint32_t refill_max;    // TC interrupt entry to idle target refilled
+    uint32_t slipped;       // items moved into the next segment before a stop
+    uint32_t late;          // chains aborted by DMA_CHAIN_ERR_LATE
+} S_dmaChainStats;
+
+typedef void (*F_dmaChainDone)(void *arg, int err);
+
+/****************
+ \brief Chain engine state, one per stream
+ ****************/
+typedef struct _S_dmaChain{
+    S_dmaStream s;
+    struct dma_stream_desc desc;    // template - direction, sizes, PAR..
+    const S_dmaSeg *seg;
+    uint32_t nseg;
+    uint32_t act;           // segment being transferred
+    uint32_t len;           // NDTR reload of the current run
+    uint32_t idle;          // DMA_CHAIN_IDLE_* in the idle target
+    uint32_t item;          // bytes per data item
+    F_dmaChainDone done;
+    void *arg;
+    volatile uint32_t busy;
+    S_dmaChainStats stats;
+} S_dmaChain;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Binds a chain to an allocated stream
+ \param c chain state
+ \param s stream from dma_alloc() (peripheral request, not DMA_REQ_MEM)
+ \param tmpl direction, sizes, priority, bursts, fifo and periph_address;
+        addresses, count, DBM/CIRC and interrupts are managed by the chain
+ \retval 0 on success, -1 on memory-to-memory or mismatched sizes
+ ****************/
+int INIT_dmaChain(S_dmaChain *c, const S_dmaStream *s,
+                  const struct dma_stream_desc *tmpl);
+
+/****************
+ \brief Starts a chained transfer, seg[] must stay valid until done
+ \param c chain state
+ \param seg segment list
+ \param nseg number of segments
+ \param done called from the DMA interrupt at the end (may be 0)
+ \param arg passed to done
+ \retval 0 started, -1 busy or empty list
+ ****************/
+int dma_chain_start(S_dmaChain *c, const S_dmaSeg *seg, uint32_t nseg,
+                    F_dmaChainDone done, void *arg);
+
+/****************
+ \brief Stream interrupt body - call it from the dmaX_streamY_isr
+ \param c chain state
+ ****************/
+void dma_chain_irq(S_dmaChain *c);
+
+/****************
+ \brief Stops a running chain (done is not called)
+ \param c chain state
+ ****************/
+void dma_chain_abort(S_dmaChain *c);
+
+/****************
+ \brief Runs a list of unequal segments (TIM6 CNT -> memory, TIM6 update
+        as the request) through every path of dma_chain_irq()
+ \retval 0 - DMA_CHAIN_OK and every item in place, -1 - no free stream,
+        -2 - an item missing or written outside the segments,
+        -3 - not finished in 10 ms, DMA_CHAIN_ERR_* - the chain failed
+ ****************/
+int dma_chain_selftest(void);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // DMA_CHAIN_H_INCLUDED
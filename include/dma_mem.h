@@ -0,0 +1,199 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Asynchronous memcpy/memset on a DMA2 memory-to-memory stream
+\descrptn
+    dma_memcpy()/dma_memset() queue a job and return at once, the CPU goes
+    on with other work while DMA2 moves the data; done(arg) is called from
+    the stream interrupt when the job is finished.
+    - jobs below the threshold are done by the CPU right in the call (done
+      is called before the function returns) - the DMA setup + interrupt
+      costs more than copying a few bytes; dma_mem_bench() measures where
+      the crossover is on the running clock/memory setup
+    - the data item is the widest of word/halfword/byte the addresses and
+      the length are aligned to, the FIFO is always on; 16-byte aligned
+      jobs use 16-byte bursts (INCR4 words, never crossing a 1 KB boundary)
+    - memset reads a fixed pattern word (PINC off)
+    - CCM RAM (0x10000000) is not reachable by DMA - such jobs go to CPU;
+      behind queued jobs the call first waits for them to finish, from an
+      interrupt (or with interrupts masked) it is refused instead
+    Usage:
+        INIT_dmaMem();
+        void dma2_stream1_isr(void){ dma_mem_irq(); }   // see dma_mem_stream()
+        dma_memcpy(dst, src, 4096, tx_ready, &pkt);
+        ... other work ...
+        dma_mem_wait();
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef DMA_MEM_H_INCLUDED
+#define DMA_MEM_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// jobs waiting for the stream
+#define DMA_MEM_QUEUE           8
+// bytes below which the CPU does the job, until dma_mem_bench() runs
+#define DMA_MEM_THRESHOLD       128
+//____________________________________________________
+//constants (do not change)
+// done callback err values
+#define DMA_MEM_OK              0
+#define DMA_MEM_ERR_TRANSFER    1   // TEIF - bus error on an address
+// dma_mem_bench() sizes: 16, 32, .. 16 << (DMA_MEM_BENCH_STEPS - 1)
+#define DMA_MEM_BENCH_STEPS     9
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+typedef void (*F_dmaMemDone)(void *arg, int err);
+
+/****************
+ \brief Service counters
+ ****************/
+typedef struct _S_dmaMemStats{
+    uint32_t dma_jobs;      // jobs moved by DMA
+    uint32_t cpu_jobs;      // jobs under the threshold / unreachable memory
+    uint32_t dma_bytes;
+    uint32_t cpu_bytes;
+    uint32_t chunks;        // NDTR reloads (jobs over 65535 items)
+    uint32_t bursts;        // jobs run with 16-byte bursts
+    uint32_t errors;
+    uint32_t full;          // calls refused on a full queue
+    uint32_t ccm_refused;   // CCM jobs refused behind queued ones
+    uint32_t irq_max;       // longest interrupt (DWT cycles)
+} S_dmaMemStats;
+
+/****************
+ \brief One benchmark point (DWT cycles, dst/src word aligned)
+ ****************/
+typedef struct _S_dmaMemBenchPoint{
+    uint32_t size;          // bytes
+    uint32_t cpu;           // memcpy() in the caller
+    uint32_t issue;         // dma_memcpy() call + its interrupt - CPU cost
+    uint32_t latency;       // dma_memcpy() call to done
+} S_dmaMemBenchPoint;
+
+/****************
+ \brief Benchmark result
+ ****************/
+typedef struct _S_dmaMemBench{
+    S_dmaMemBenchPoint p[DMA_MEM_BENCH_STEPS];
+    uint32_t steps;         // valid points (limited by the scratch size)
+    uint32_t crossover;     // chosen threshold, bytes
+} S_dmaMemBench;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Claims a DMA2 memory-to-memory stream and enables its interrupt
+ \retval 0 on success, -1 when no DMA2 stream is free (all jobs go to CPU)
+ ****************/
+int INIT_dmaMem(void);
+
+/****************
+ \brief The claimed stream - its dmaX_streamY_isr must call dma_mem_irq()
+ \retval stream from dma_alloc(), 0 before INIT_dmaMem()
+ ****************/
+const S_dmaStream *dma_mem_stream(void);
+
+/****************
+ \brief Stream interrupt body - call it from the dmaX_streamY_isr
+ ****************/
+void dma_mem_irq(void);
+
+/****************
+ \brief Copies len bytes, buffers must stay untouched until done
+ \param dst destination
+ \param src source
+ \param len bytes
+ \param done called at the end, from the interrupt or from this call (may be 0)
+ \param arg passed to done
+ \retval 0 queued or copied, -1 queue full or a CCM job that cannot wait
+        for the queue (nothing done)
+ ****************/
+int dma_memcpy(void *dst, const void *src, uint32_t len,
+               F_dmaMemDone done, void *arg);
+
+/****************
+ \brief Fills len bytes with c, dst must stay untouched until done
+ \param dst destination
+ \param c fill byte
+ \param len bytes
+ \param done called at the end, from the interrupt or from this call (may be 0)
+ \param arg passed to done
+ \retval 0 queued or filled, -1 queue full or a CCM job that cannot wait
+        for the queue (nothing done)
+ ****************/
+int dma_memset(void *dst, uint8_t c, uint32_t len,
+               F_dmaMemDone done, void *arg);
+
+/****************
+ \brief Number of jobs not finished yet
+ ****************/
+uint32_t dma_mem_busy(void);
+
+/****************
+ \brief Waits until every queued job is finished
+ ****************/
+void dma_mem_wait(void);
+
+/****************
+ \brief Sets the size below which the CPU does the job
+ \param bytes new threshold
+ ****************/
+void dma_mem_set_threshold(uint32_t bytes);
+
+/****************
+ \brief Service counters
+ ****************/
+const S_dmaMemStats *dma_mem_stats(void);
+
+/****************
+ \brief Times CPU memcpy against dma_memcpy over growing sizes and sets the
+        threshold to the first size where the CPU cost of a DMA job (call +
+        interrupt) is lower than the CPU copy itself
+ \param scratch word aligned buffer, not in CCM, split in src/dst halves
+ \param size scratch bytes - sizes up to size/2 are measured
+ \param out results (may be 0)
+ \retval chosen threshold in bytes
+ ****************/
+uint32_t dma_mem_bench(void *scratch, uint32_t size, S_dmaMemBench *out);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // DMA_MEM_H_INCLUDED
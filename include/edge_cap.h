@@ -0,0 +1,144 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Edge records from timer input capture and DMA (edge_rec source)
+\descrptn
+    The pin is a TIM2 / TIM5 input capture channel on both edges; every
+    edge latches the free running 32-bit counter into CCRx and the CCx DMA
+    request moves it into a circular ring - no CPU per edge, the stamp has
+    the resolution of one timer clock and no interrupt latency in it.
+    edge_read() drains the ring into S_edge records:
+    - counter -> DWT time line: t = CCR * EDGE_CAP_MUL + offset, the offset
+      is measured at INIT (CNT and CYCCNT read back to back, a few cycles);
+      both run from the same PLL so it never drifts, and a counter wrap
+      is a whole number of CYCCNT wraps
+    - the edge direction comes from the pin level sampled together with
+      the ring position (the last edge left the pin at its current level,
+      the ones before alternate) - a lost edge cannot shift it; the position
+      is read EDGE_CAP_SETTLE after the level, when an edge seen on the pin
+      is surely through the input filter and the DMA, and the level is
+      checked again (edges closer than that make edge_read() wait)
+    - the ring position is counted across wraps by the transfer complete
+      interrupt (one per ring, not per edge); a reader more than a ring
+      behind skips to the newest ring's worth and flags EDGE_LOST, so does
+      a capture overrun of the DMA (CCxOF)
+        static uint32_t raw[64];
+        S_dmaStream s;
+        dma_alloc(DMA_REQ_TIM5_CH1, &s);
+        INIT_edgeCap(&enc_a, &edges, 1, TIM5, 1, &s, raw, 64, GPIOA, GPIO0);
+        void dma1_stream2_isr(void){ edge_cap_dma_irq(&enc_a); }
+    The TIMx clock and the pin (AF1 TIM2 / AF2 TIM5) are set up by the user.
+    The ring has to be drained (edge_read()) at least once per
+    n edges' worth of time.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef EDGE_CAP_H_INCLUDED
+#define EDGE_CAP_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "edge_rec.h"
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// SYSCLK / timer clock - 168 MHz / 84 MHz (APB1 x2, prescaler 1)
+#define EDGE_CAP_MUL        2
+// input filter, enum tim_ic_filter
+#define EDGE_CAP_FILTER     TIM_IC_CK_INT_N_4
+// DWT cycles from the pin level to the ring position in edge_read() -
+// above the filter (4 timer clocks = 8 cycles) + the DMA request latency
+// behind the other DMA1 streams
+#define EDGE_CAP_SETTLE     168
+//____________________________________________________
+//constants (do not change)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief Capture source counters
+ ****************/
+typedef struct _S_edgeCapStats{
+    uint32_t edges;
+    uint32_t lapped;        // edges overwritten before they were drained
+    uint32_t overcaptures;  // CCxOF - the DMA was late
+} S_edgeCapStats;
+
+/****************
+ \brief Capture source state
+ ****************/
+typedef struct _S_edgeCap{
+    S_edgeSrc src;
+    uint32_t tim;           // TIM2 or TIM5
+    uint8_t ch;             // 1..4
+    S_dmaStream s;
+    uint32_t port;
+    uint16_t pin;
+    const uint32_t *raw;    // DMA ring of CCR values
+    uint32_t n;             // entries, power of two
+    volatile uint32_t wraps;
+    uint32_t done;          // entries drained so far
+    uint32_t offset;        // CYCCNT - CNT * EDGE_CAP_MUL
+    S_edgeCapStats stats;
+} S_edgeCap;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Starts capturing both edges of a timer channel into a ring
+ \param c source state
+ \param r edge ring it is drained into
+ \param id S_edge.src of its records
+ \param tim TIM2 or TIM5 - started free running if it is not running yet
+ \param ch channel 1..4
+ \param s stream from dma_alloc(DMA_REQ_TIMx_CHy)
+ \param raw DMA ring
+ \param n raw entries, power of two
+ \param port GPIOx of the channel pin
+ \param pin GPIOn of the channel pin
+ ****************/
+void INIT_edgeCap(S_edgeCap *c, S_edgeRing *r, uint8_t id, uint32_t tim,
+                  uint8_t ch, const S_dmaStream *s, uint32_t *raw, uint32_t n,
+                  uint32_t port, uint16_t pin);
+
+/****************
+ \brief Stream interrupt body (ring wraps) - call it from dmaX_streamY_isr
+ \param c source state
+ ****************/
+void edge_cap_dma_irq(S_edgeCap *c);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // EDGE_CAP_H_INCLUDED
@@ -0,0 +1,181 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timestamped edge records of digital inputs, EXTI source
+\descrptn
+    Every edge of a watched input becomes one S_edge record - time, source
+    id and the level after the edge - in a ring read by edge_read(). The
+    time line is the DWT cycle counter (SYSCLK cycles) for every source, so
+    records of different sources can be compared directly.
+    Sources:
+    - EXTI (this module): one interrupt per edge, the stamp is CYCCNT at
+      the start of edge_exti_irq() - it includes the interrupt latency and
+      its jitter (tail chaining, masked sections, higher priorities)
+    - timer input capture (edge_cap.h): the timer latches the edge, DMA
+      moves the stamp, no CPU per edge; the records are converted in
+      batches when edge_read() drains the source
+    Both are S_edgeSrc on the same ring, a signal is moved from one to the
+    other by changing only its initialisation.
+        static S_edge eb[256];
+        INIT_edgeRing(&edges, eb, 256);
+        INIT_edgeExti(&btn, &edges, 0, GPIOA, GPIO0);
+        void exti0_isr(void){ edge_exti_irq(&btn); }
+        ...
+        S_edge e[16];
+        n = edge_read(&edges, e, 16);
+    Records of one source are in time order, records of different sources
+    are in the order they were pushed / drained.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef EDGE_REC_H_INCLUDED
+#define EDGE_REC_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// EXTI interrupt priority - the higher, the lower the stamp jitter
+#define EDGE_EXTI_PRIORITY  0x10
+//____________________________________________________
+//constants (do not change)
+// S_edge.flags
+#define EDGE_LOST           (1 << 0)    // edges were lost before this one
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief One edge
+ ****************/
+typedef struct _S_edge{
+    uint32_t t;             // DWT CYCCNT time line
+    uint8_t src;            // id given to the source
+    uint8_t level;          // 1 - rising edge, 0 - falling edge
+    uint16_t flags;         // EDGE_*
+} S_edge;
+
+struct _S_edgeSrc;
+typedef void (*F_edgeDrain)(struct _S_edgeSrc *s);
+
+/****************
+ \brief Ring the sources push records into
+ ****************/
+typedef struct _S_edgeRing{
+    S_edge *buf;
+    uint32_t mask;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t lost;          // a record was dropped, flag the next one
+    uint32_t drops;
+    struct _S_edgeSrc *srcs;
+} S_edgeRing;
+
+/****************
+ \brief Common part of a source - the first member of every source
+ ****************/
+typedef struct _S_edgeSrc{
+    S_edgeRing *ring;
+    uint8_t id;
+    F_edgeDrain drain;      // batch sources, called by edge_read(); 0 - no
+    struct _S_edgeSrc *next;
+} S_edgeSrc;
+
+/****************
+ \brief EXTI source
+ ****************/
+typedef struct _S_edgeExti{
+    S_edgeSrc src;
+    uint32_t port;
+    uint16_t pin;           // GPIOn = EXTIn
+} S_edgeExti;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Prepares an empty ring and starts the DWT cycle counter
+ \param r ring
+ \param buf records
+ \param size records in buf, power of two
+ ****************/
+void INIT_edgeRing(S_edgeRing *r, S_edge *buf, uint32_t size);
+
+/****************
+ \brief Attaches a source to a ring (done by the INIT_edge* functions)
+ \param r ring
+ \param s source
+ \param id S_edge.src of its records
+ \param drain batch conversion called by edge_read(), may be 0
+ ****************/
+void edge_src_add(S_edgeRing *r, S_edgeSrc *s, uint8_t id, F_edgeDrain drain);
+
+/****************
+ \brief Appends a record - from any context
+ \param s source
+ \param t DWT CYCCNT time line
+ \param level level after the edge
+ \param flags EDGE_*
+ ****************/
+void edge_push(S_edgeSrc *s, uint32_t t, uint8_t level, uint16_t flags);
+
+/****************
+ \brief Drains the batch sources and takes the oldest records
+ \param r ring
+ \param out records
+ \param max out size
+ \retval records copied
+ ****************/
+uint32_t edge_read(S_edgeRing *r, S_edge *out, uint32_t max);
+
+/****************
+ \brief Watches a pin by its EXTI line, both edges
+ \param e source state
+ \param r ring
+ \param id S_edge.src of its records
+ \param port GPIOx, pin already an input
+ \param pin GPIOn
+ ****************/
+void INIT_edgeExti(S_edgeExti *e, S_edgeRing *r, uint8_t id, uint32_t port,
+                   uint16_t pin);
+
+/****************
+ \brief EXTI interrupt body - call it from the exti isr of the line, a
+        shared vector (9_5, 15_10) calls it for each of its sources
+ \param e source state
+ ****************/
+void edge_exti_irq(S_edgeExti *e);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // EDGE_REC_H_INCLUDED
@@ -0,0 +1,119 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Fault capture into the 4 KB backup SRAM followed by system reset
+\descrptn
+    hard_fault_handler, mem_manage_handler, bus_fault_handler and
+    usage_fault_handler replace the hanging libopencm3 stubs. They switch to
+    a private stack (the faulting one may be the broken thing), snapshot the
+    stacked + callee saved registers, CFSR/HFSR/MMFAR/BFAR and the top of the
+    faulting stack into BKPSRAM and reset the chip.
+    After reset INIT_faultDump() hands over the record until fault_dump_ack().
+    Read it with gdb and decode it against the same ELF:
+        dump binary memory fault.bin 0x40024000 0x40025000
+        scripts/fault_decode.py bin/project.elf fault.bin
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef FAULT_DUMP_H_INCLUDED
+#define FAULT_DUMP_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// words copied from the faulting SP upwards
+#define FAULT_STACK_WORDS   256
+// private stack of the fault handlers in bytes
+#define FAULT_ISTACK_BYTES  512
+//____________________________________________________
+//constants (do not change)
+// "FLT1" in little endian memory dump
+#define FAULT_MAGIC         0x31544C46u
+// bump when S_faultDump layout changes (fault_decode.py)
+#define FAULT_VERSION       1u
+// S_faultDump.flags
+#define FAULT_FRAME_VALID   (1 << 0)    // stacked frame lies in RAM
+#define FAULT_FRAME_FPU     (1 << 1)    // extended (FPU) frame was stacked
+#define FAULT_FRAME_PSP     (1 << 2)    // fault happened on process stack
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief Record at the start of BKPSRAM - parsed by scripts/fault_decode.py
+ ****************/
+typedef struct _S_faultDump{
+    uint32_t magic;         // FAULT_MAGIC
+    uint32_t version;       // FAULT_VERSION
+    uint32_t size;          // sizeof(S_faultDump)
+    uint32_t checksum;      // ~sum of the others - all words sum to ~0
+    uint32_t count;         // faults since the backup domain lost power
+    uint32_t acked;         // nonzero after fault_dump_ack()
+    uint32_t exc_number;    // IPSR in the handler (3 hard, 4 mem, 5 bus, 6 usage)
+    uint32_t exc_return;    // LR in the handler
+    uint32_t frame[8];      // stacked r0 r1 r2 r3 r12 lr pc xpsr
+    uint32_t r4_r11[8];     // callee saved registers
+    uint32_t sp;            // SP of the faulting code (before stacking)
+    uint32_t msp;
+    uint32_t psp;
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint32_t shcsr;
+    uint32_t cycle;         // DWT CYCCNT (0 if not running)
+    uint32_t tick;          // system_tick
+    uint32_t flags;         // FAULT_FRAME_*
+    uint32_t stack_words;   // valid words in stack[]
+    uint32_t stack[FAULT_STACK_WORDS];
+} S_faultDump;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Powers the backup SRAM (kept on VBAT), enables the configurable
+        fault handlers so they do not escalate to HardFault
+ \retval record of the last fault if it was not acknowledged yet, else 0
+ ****************/
+const volatile S_faultDump *INIT_faultDump(void);
+
+/****************
+ \brief Marks the stored record as handled (it stays readable)
+ ****************/
+void fault_dump_ack(void);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // FAULT_DUMP_H_INCLUDED
@@ -0,0 +1,158 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Frequency and duty cycle measurement on TIM2 CH1 / ETR
+\descrptn
+    The signal goes to the TIM2_CH1_ETR pin (PA0, PA5 or PA15, AF1) - the
+    same pin is TI1 for the period range and ETR for the counting range,
+    so switching the range needs no rewiring. Neither range has an
+    interrupt, freq_meas_poll() only reads the timer at the report rate.
+    - FREQ_RANGE_PERIOD (low f): PWM input mode - the rising edge resets
+      the counter (slave reset mode, TI1FP1) and latches the period into
+      CCR1, the falling edge latches the high time into CCR2.
+        f = FREQ_MEAS_TIM_HZ / CCR1, duty = CCR2 / CCR1
+      +-1 timer tick of the last period, err = f / 84 MHz (12 ppm at 1 kHz)
+    - FREQ_RANGE_COUNT (high f): external clock mode 2 - every ETR edge
+      (prescaled by 1 or 8) counts, the gate is the time between two
+      reports measured by the DWT cycle counter.
+        f = dCNT * psc * FREQ_MEAS_SYSCLK_HZ / dCYCCNT
+      +-1 prescaled count per gate, err = psc / (f * gate) (10 ppm at
+      1 MHz, 100 ms). No duty cycle in this range (FREQ_NO_DUTY).
+    The errors meet at fx = sqrt(FREQ_MEAS_TIM_HZ / gate) (29 kHz at
+    100 ms); the range goes up above 2 fx and back down below fx / 2. The
+    ETR prescaler goes to 8 above FREQ_MEAS_ETR_UP (the ETR input has to
+    stay below 84 MHz / 4 after the prescaler), the pad limits the input
+    to a few tens of MHz. The figures are quantisation only - the HSE
+    tolerance adds to both ranges.
+        INIT_freqMeas(&fm, 100);
+        ...
+        if( freq_meas_poll(&fm) && !(fm.rep.flags & FREQ_NO_SIGNAL) )
+            hz = fm.rep.hz;     // +- fm.rep.err_ppm
+    The TIM2 clock and the pin are set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef FREQ_MEAS_H_INCLUDED
+#define FREQ_MEAS_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// TIM2 clock (APB1 x2) and SYSCLK (DWT)
+#define FREQ_MEAS_TIM_HZ    84000000
+#define FREQ_MEAS_SYSCLK_HZ 168000000
+// TI1 filter of the period range, enum tim_ic_filter - a slow filter can
+// swallow a fast signal completely and the range would never go up
+#define FREQ_MEAS_FILTER    TIM_IC_OFF
+// ETR prescaler hysteresis [Hz] - 1 below, 8 above
+#define FREQ_MEAS_ETR_UP    12000000
+#define FREQ_MEAS_ETR_DOWN  6000000
+//____________________________________________________
+//constants (do not change)
+#define FREQ_MEAS_TIM       TIM2
+// S_freqReport.flags
+#define FREQ_NO_SIGNAL      (1 << 0)    // no edge for two periods / 51 s
+#define FREQ_NO_DUTY        (1 << 1)    // counting range, duty not valid
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+typedef enum _E_freqRange{
+    FREQ_RANGE_PERIOD = 0,  // PWM input, one period
+    FREQ_RANGE_COUNT        // ETR edges per gate
+} E_freqRange;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief One report
+ ****************/
+typedef struct _S_freqReport{
+    uint32_t hz;
+    uint16_t mhz;           // fraction of hz, 1/1000 Hz
+    uint16_t duty;          // high time, 1/100 %
+    uint32_t err_ppm;       // +- quantisation error of the frequency
+    uint32_t t;             // DWT CYCCNT of the report
+    uint32_t seq;           // reports so far
+    E_freqRange range;
+    uint16_t flags;         // FREQ_*
+} S_freqReport;
+
+/****************
+ \brief Measurement counters
+ ****************/
+typedef struct _S_freqMeasStats{
+    uint32_t switches;      // range changes
+    uint32_t psc_switches;  // ETR prescaler changes
+    uint32_t lost;          // signal stopped
+} S_freqMeasStats;
+
+/****************
+ \brief Measurement state
+ ****************/
+typedef struct _S_freqMeas{
+    uint32_t rate;          // report period [ms]
+    uint32_t due;           // system_tick of the next report
+    E_freqRange range;
+    uint8_t psc;            // ETR prescaler 1 / 8
+    uint8_t primed;         // captures since the period range started
+    uint32_t up;            // period -> count [Hz]
+    uint32_t down;          // count -> period [Hz]
+    uint32_t last;          // last period [timer ticks]
+    uint32_t cnt0;          // gate start, counting range
+    uint32_t cyc0;
+    S_freqReport rep;
+    S_freqMeasStats stats;
+} S_freqMeas;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Takes over TIM2 and starts in the period range
+ \param f measurement state
+ \param rate_ms report period = counting gate [ms], 1..20000
+ ****************/
+void INIT_freqMeas(S_freqMeas *f, uint32_t rate_ms);
+
+/****************
+ \brief Makes a report when the report period is over, switches the range
+        when the result is outside it - call it from the main loop
+ \param f measurement state
+ \retval 1 - f->rep is new, 0 - not yet
+ ****************/
+uint8_t freq_meas_poll(S_freqMeas *f);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // FREQ_MEAS_H_INCLUDED
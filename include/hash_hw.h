@@ -0,0 +1,241 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Incremental SHA-1 / MD5 / HMAC on the HASH unit, DMA input
+\descrptn
+    A message is hashed in spans of any length and alignment:
+        S_hashHw h;
+        hash_hw_begin(&h, HASH_HW_SHA1);
+        hash_hw_update(&h, hdr, 5);
+        hash_hw_update(&h, body, n);
+        hash_hw_final(&h, digest);              // 20 bytes, big-endian
+    hash_hw_hmac_begin() starts a keyed HMAC instead (RFC 2104, key of any
+    length, it has to stay valid until the digest).
+    The unit takes whole 32-bit words (8-bit data type - byte order of the
+    memory), bytes of an unfinished word wait in the context; the valid
+    bits of the last word go to NBLW before the digest calculation.
+    hash_hw_finish() ends a message with a long last span fed by DMA2
+    (DMA_REQ_HASH_IN) and reports the digest from the stream interrupt.
+    The F41x unit starts the digest calculation by itself at the DMA
+    terminal count, so a DMA span is always the last one of the message:
+        INIT_hashHw(&s);                        // dma_alloc(DMA_REQ_HASH_IN)
+        void dma2_stream7_isr(void){ hash_hw_irq(); }
+        hash_hw_begin(&img, HASH_HW_SHA1);
+        hash_hw_finish(&img, (void *)0x08020000, 128 * 1024, dig, ok, 0);
+    The DMA reads the last word whole - up to 3 bytes after the span are
+    read (never hashed), they have to be readable memory.
+    The unit holds one message at a time; a message begun while it is
+    taken (or with HASH_HW_UNIT 0) runs in software with the same results.
+    Every begun message has to be ended by hash_hw_final/finish().
+    The HASH unit exists on the STM32F415/417 only - the F407 of this
+    board has none, set HASH_HW_UNIT for those chips.
+    hash_hw_bench() compares the software SHA-1 with the unit.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef HASH_HW_H_INCLUDED
+#define HASH_HW_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// 1 - STM32F415/417 with the HASH unit, 0 - software only (F405/407)
+#ifndef HASH_HW_UNIT
+#define HASH_HW_UNIT        0
+#endif
+// bytes below which hash_hw_finish() feeds the unit by the CPU
+#define HASH_HW_DMA_MIN     256
+// stream interrupt priority
+#define HASH_HW_PRIORITY    0xC0
+//____________________________________________________
+//constants (do not change)
+#define HASH_HW_SHA1_LEN    20
+#define HASH_HW_MD5_LEN     16
+#define HASH_HW_BLOCK       64
+// done callback err values
+#define HASH_HW_OK          0
+#define HASH_HW_ERR_TRANSFER 1  // TEIF - the digest is not valid
+//____________________________________________________
+// macro functions (do not use often!)
+// digest bytes of an algorithm
+#define HASH_HW_LEN(algo) \
+    ((algo) == HASH_HW_SHA1 ? HASH_HW_SHA1_LEN : HASH_HW_MD5_LEN)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief Hash algorithm
+ ****************/
+typedef enum _E_hashHwAlgo{
+    HASH_HW_SHA1 = 0,
+    HASH_HW_MD5
+} E_hashHwAlgo;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief End of a hash_hw_finish() by DMA
+ \param arg given to hash_hw_finish()
+ \param err HASH_HW_OK / HASH_HW_ERR_*
+ ****************/
+typedef void (*F_hashHwDone)(void *arg, int err);
+
+/****************
+ \brief Software engine state (also the fallback of the unit)
+ ****************/
+typedef struct _S_hashSw{
+    E_hashHwAlgo algo;
+    uint32_t h[5];
+    uint8_t blk[HASH_HW_BLOCK]; // bytes of an unfinished block
+    uint32_t len;           // message bytes so far
+} S_hashSw;
+
+/****************
+ \brief One message being hashed
+ ****************/
+typedef struct _S_hashHw{
+    E_hashHwAlgo algo;
+    uint8_t hmac;
+    uint8_t hw;             // 1 - on the unit, 0 - in software
+    uint8_t part[4];        // unit: bytes of an unfinished word
+    uint8_t npart;
+    const uint8_t *key;     // HMAC key
+    uint32_t klen;
+    S_hashSw sw;
+    uint8_t *out;           // running hash_hw_finish()
+    F_hashHwDone done;
+    void *arg;
+    volatile uint8_t busy;
+} S_hashHw;
+
+/****************
+ \brief Message counters
+ ****************/
+typedef struct _S_hashHwStats{
+    uint32_t hw;            // messages on the unit
+    uint32_t sw;            // in software - no unit, or it was taken
+    uint32_t dma;           // hash_hw_finish() spans by DMA
+    uint32_t errors;        // TEIF
+} S_hashHwStats;
+
+/****************
+ \brief hash_hw_bench() result in DWT cycles, 0 - not measured
+ ****************/
+typedef struct _S_hashHwBench{
+    uint32_t len;           // bytes
+    uint32_t sw;            // software SHA-1
+    uint32_t cpu;           // the unit fed by the CPU
+    uint32_t dma;           // hash_hw_finish() call to done
+} S_hashHwBench;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Enables the unit clock and binds the input stream
+ \param s stream from dma_alloc(DMA_REQ_HASH_IN), 0 - no DMA
+ ****************/
+void INIT_hashHw(const S_dmaStream *s);
+
+/****************
+ \brief Starts a message, takes the unit if it is free
+ \param c context
+ \param algo HASH_HW_*
+ ****************/
+void hash_hw_begin(S_hashHw *c, E_hashHwAlgo algo);
+
+/****************
+ \brief Starts a HMAC message, takes the unit if it is free
+ \param c context
+ \param algo HASH_HW_*
+ \param key key, valid until the digest
+ \param klen key bytes, any
+ ****************/
+void hash_hw_hmac_begin(S_hashHw *c, E_hashHwAlgo algo,
+                        const void *key, uint32_t klen);
+
+/****************
+ \brief Adds a span
+ \param c context
+ \param p data, any alignment
+ \param len bytes
+ \retval 0 - ok, -1 - a hash_hw_finish() runs
+ ****************/
+int hash_hw_update(S_hashHw *c, const void *p, uint32_t len);
+
+/****************
+ \brief Ends the message, releases the unit
+ \param c context
+ \param digest HASH_HW_LEN(algo) bytes
+ \retval 0 - ok, -1 - a hash_hw_finish() runs
+ ****************/
+int hash_hw_final(S_hashHw *c, uint8_t *digest);
+
+/****************
+ \brief Ends the message with a last span; from HASH_HW_DMA_MIN bytes on
+        the unit is fed by DMA and the digest is ready in done
+ \param c context
+ \param p data, any alignment, valid until done; by DMA the last word is
+        read whole - up to 3 bytes after p + len must be readable
+ \param len bytes
+ \param digest HASH_HW_LEN(algo) bytes, written before done
+ \param done called at the end - from the stream interrupt, or before
+        the return for a span done by the CPU; may be 0 (poll c->busy)
+ \param arg passed to done
+ \retval 0 - accepted, -1 - a hash_hw_finish() runs
+ ****************/
+int hash_hw_finish(S_hashHw *c, const void *p, uint32_t len,
+                   uint8_t *digest, F_hashHwDone done, void *arg);
+
+/****************
+ \brief Stream interrupt body - call it from dma2_stream7_isr
+ ****************/
+void hash_hw_irq(void);
+
+/****************
+ \brief Message counters
+ ****************/
+const S_hashHwStats *hash_hw_stats(void);
+
+/****************
+ \brief SHA-1 of len bytes in software, on the unit by the CPU and by DMA
+ \param p data
+ \param len bytes
+ \param out results (may be 0)
+ \retval 0 - the digests agree, -1 - they differ or the unit is taken
+ ****************/
+int hash_hw_bench(const void *p, uint32_t len, S_hashHwBench *out);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // HASH_HW_H_INCLUDED
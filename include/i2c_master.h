@@ -0,0 +1,235 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Interrupt driven I2C master with a transaction queue and DMA
+\descrptn
+    Transactions (S_i2cXfer) are queued by i2c_master_submit() and run by
+    the event / error interrupts, nothing busy-polls SR1/SR2:
+    - write, read or write-then-read with a repeated START (register reads)
+    - writes of I2C_MASTER_DMA_MIN bytes and more go through the TX stream,
+      shorter ones (register address) byte by byte on TXE
+    - reads of 2 bytes and more go through the RX stream with
+      i2c_set_dma_last_transfer() - the peripheral NACKs the last byte
+      itself, the STOP is set from the RX transfer complete; single byte
+      reads use the ACK=0/STOP sequence of the reference manual
+    - NACK (AF) ends the transaction with I2C_MASTER_ERR_NACK
+    - arbitration loss (ARLO) restarts it up to I2C_MASTER_RETRIES times,
+      the START is issued again once the bus is free
+    - bus error, overrun, a STOP that never completes and a transaction
+      running longer than I2C_MASTER_TIMEOUT_MS stop the queue; the next
+      i2c_master_poll() then recovers the bus outside the interrupts:
+      up to 9 SCL pulses until the slave releases SDA, a STOP, SWRST and
+      the timing programmed again - then the queue continues
+    The queue is an intrusive list - S_i2cXfer is owned by the caller and
+    must stay valid until done() is called (from an interrupt, or from
+    i2c_master_poll() on timeout).
+        S_dmaStream rx, tx;
+        S_i2cPins pins = { GPIOB, GPIO6, GPIOB, GPIO7 };
+        dma_alloc(DMA_REQ_I2C1_RX, &rx);
+        dma_alloc(DMA_REQ_I2C1_TX, &tx);
+        INIT_i2cMaster(&i2c1, I2C1, 400000, &rx, &tx, &pins);
+        void i2c1_ev_isr(void){ i2c_master_ev_irq(&i2c1); }
+        void i2c1_er_isr(void){ i2c_master_er_irq(&i2c1); }
+        void dma1_stream0_isr(void){ i2c_master_dma_irq(&i2c1); } // rx
+        void dma1_stream6_isr(void){ i2c_master_dma_irq(&i2c1); } // tx
+        i2c_master_submit(&i2c1, &baro_read);
+        while(1){ i2c_master_poll(&i2c1); ... }
+    Clocks and the pins (AF4, open drain) are set up by the user, the pins
+    are only borrowed as GPIOs during a recovery.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef I2C_MASTER_H_INCLUDED
+#define I2C_MASTER_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// I2C kernel clock = APB1 after INIT_clk() [MHz]
+#define I2C_MASTER_PCLK_MHZ     42
+// shortest write that is worth setting up the TX stream for
+#define I2C_MASTER_DMA_MIN      4
+// restarts of a transaction after an arbitration loss
+#define I2C_MASTER_RETRIES      3
+// longest transaction [ms] (clock stretching included)
+#define I2C_MASTER_TIMEOUT_MS   20
+// event, error and both stream interrupts - one level, so that they
+// never preempt each other
+#define I2C_MASTER_PRIORITY     0x40
+//____________________________________________________
+//constants (do not change)
+// done callback err values
+#define I2C_MASTER_OK           0
+#define I2C_MASTER_ERR_NACK     1   // address or data not acknowledged
+#define I2C_MASTER_ERR_ARLO     2   // arbitration lost, retries used up
+#define I2C_MASTER_ERR_BUS      3   // misplaced START/STOP, overrun
+#define I2C_MASTER_ERR_DMA      4   // TEIF on one of the streams
+#define I2C_MASTER_ERR_TIMEOUT  5
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+/****************
+ \brief Where the running transaction is
+ ****************/
+typedef enum _E_i2cState{
+    I2C_MASTER_IDLE = 0,
+    I2C_MASTER_START,       // START set, waiting for SB
+    I2C_MASTER_ADDR,        // address sent, waiting for ADDR
+    I2C_MASTER_TX,          // writing, ends with BTF
+    I2C_MASTER_RX,          // reading, ends with RXNE / RX stream TC
+    I2C_MASTER_RECOVER      // queue stopped until i2c_master_poll()
+} E_i2cState;
+
+//____________________________________________________
+// structs
+
+typedef void (*F_i2cDone)(void *arg, int err);
+
+/****************
+ \brief One transaction - wlen bytes written, then rlen bytes read
+ ****************/
+typedef struct _S_i2cXfer{
+    uint8_t addr;           // 7-bit slave address
+    const uint8_t *wr;
+    uint16_t wlen;          // 0 - read only
+    uint8_t *rd;
+    uint16_t rlen;          // 0 - write only (both 0 - address probe)
+    F_i2cDone done;         // may be 0
+    void *arg;
+    struct _S_i2cXfer *next;    // queue link, used by the master
+} S_i2cXfer;
+
+/****************
+ \brief SCL and SDA pins, driven as GPIOs during a bus recovery
+ ****************/
+typedef struct _S_i2cPins{
+    uint32_t scl_port;
+    uint16_t scl;
+    uint32_t sda_port;
+    uint16_t sda;
+} S_i2cPins;
+
+/****************
+ \brief Master counters
+ ****************/
+typedef struct _S_i2cMasterStats{
+    uint32_t xfers;
+    uint32_t bytes;
+    uint32_t dma_xfers;     // phases that went through a stream
+    uint32_t nacks;
+    uint32_t arlo;          // arbitration losses (retried ones included)
+    uint32_t bus_errors;
+    uint32_t timeouts;
+    uint32_t recoveries;
+    uint32_t sda_stuck;     // recoveries that needed SCL pulses
+} S_i2cMasterStats;
+
+/****************
+ \brief Master state, one per I2C
+ ****************/
+typedef struct _S_i2cMaster{
+    uint32_t i2c;
+    S_dmaStream rxs;
+    S_dmaStream txs;
+    S_i2cPins pins;
+    uint32_t speed;         // SCL [Hz]
+    S_i2cXfer *volatile head;   // running
+    S_i2cXfer *tail;
+    volatile E_i2cState state;
+    uint32_t reading;       // the address phase is a read
+    uint32_t dma;           // the running phase uses a stream
+    uint32_t n;             // bytes written by the CPU
+    uint32_t tries;         // arbitration losses of the running xfer
+    uint32_t started;       // system_tick of the first START
+    volatile uint32_t recover;  // recovery requested
+    S_i2cMasterStats stats;
+} S_i2cMaster;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Makes the I2C an interrupt driven master and enables its IRQs
+ \param m master state
+ \param i2c I2C1..I2C3 (clock and pins already set up)
+ \param speed SCL [Hz], up to 100000 standard mode, up to 400000 fast mode
+ \param rx stream from dma_alloc(DMA_REQ_I2Cx_RX)
+ \param tx stream from dma_alloc(DMA_REQ_I2Cx_TX)
+ \param pins SCL / SDA for the bus recovery
+ ****************/
+void INIT_i2cMaster(S_i2cMaster *m, uint32_t i2c, uint32_t speed,
+                    const S_dmaStream *rx, const S_dmaStream *tx,
+                    const S_i2cPins *pins);
+
+/****************
+ \brief Queues a transaction, starts it when the bus is idle
+ \param m master state
+ \param x transaction, untouched by the caller until done
+ ****************/
+void i2c_master_submit(S_i2cMaster *m, S_i2cXfer *x);
+
+/****************
+ \brief Event interrupt body - call it from i2cX_ev_isr
+ \param m master state
+ ****************/
+void i2c_master_ev_irq(S_i2cMaster *m);
+
+/****************
+ \brief Error interrupt body - call it from i2cX_er_isr
+ \param m master state
+ ****************/
+void i2c_master_er_irq(S_i2cMaster *m);
+
+/****************
+ \brief RX/TX stream interrupt body - call it from both dmaX_streamY_isr
+ \param m master state
+ ****************/
+void i2c_master_dma_irq(S_i2cMaster *m);
+
+/****************
+ \brief Times out a hung transaction and recovers the bus - main loop
+ \param m master state
+ ****************/
+void i2c_master_poll(S_i2cMaster *m);
+
+/****************
+ \brief Nonzero while transactions are queued, running or waiting for
+        a recovery
+ \param m master state
+ ****************/
+uint32_t i2c_master_busy(const S_i2cMaster *m);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // I2C_MASTER_H_INCLUDED
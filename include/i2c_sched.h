@@ -0,0 +1,185 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Periodic I2C read scheduler with batching and double buffers
+\descrptn
+    Sensors are described once by a periodic read (S_i2cRead: address,
+    register, length, period) and i2c_sched_add()ed. i2c_sched_tick() then
+    does all the polling:
+    - every read that is due is queued on the I2C master (i2c_master.h) in
+      one go, with the interrupts masked, so the batch runs back to back -
+      the next START follows the previous STOP from the interrupt, not
+      from the main loop
+    - due times advance by whole periods from a common time line, reads
+      with commensurate periods fall into the same tick and share a batch;
+      phase (the first due time) spreads a heavy bus
+    - a read still in flight at its next due time is skipped, not queued
+      twice; a late tick catches up by one sample, not by a burst
+    - the data lands by DMA straight into the back half of a 2 * len
+      buffer; only a good transaction flips the halves (seq++), so
+      i2c_sched_get() always copies the latest complete sample without
+      locking - it repeats the copy if a new sample was published
+      meanwhile
+    - latency (queued -> done) and sample interval (jitter) are measured
+      per read with DWT CYCCNT, batch length per scheduler
+        static uint8_t acc_buf[2 * 6];
+        static S_i2cRead acc = { .addr = 0x1D, .reg = 0x28 | 0x80, .len = 6,
+                                 .period = 5, .buf = acc_buf };
+        INIT_i2cSched(&sched, &i2c1);
+        i2c_sched_add(&sched, &acc);
+        while(1)
+        {
+            i2c_sched_tick(&sched);
+            if( i2c_sched_get(&acc, xyz, 0) != last ) ...
+        }
+    i2c_sched_tick() also calls i2c_master_poll(), so it belongs into the
+    main loop (called at least once per ms).
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef I2C_SCHED_H_INCLUDED
+#define I2C_SCHED_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "i2c_master.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+//____________________________________________________
+//constants (do not change)
+// S_i2cRead.flags
+#define I2C_READ_NOREG      (1 << 0)    // plain read, no register write
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+typedef void (*F_i2cSample)(void *arg, const uint8_t *p, uint16_t len);
+
+/****************
+ \brief Counters of one periodic read (latencies in DWT cycles)
+ ****************/
+typedef struct _S_i2cReadStats{
+    uint32_t samples;       // good reads published
+    uint32_t errors;
+    int last_err;           // I2C_MASTER_ERR_*
+    uint32_t skipped;       // due times missed (in flight / late tick)
+    uint32_t lat_last;      // queued -> done
+    uint32_t lat_avg;       // running average, 1/16 weight
+    uint32_t lat_max;
+    uint32_t ival_min;      // between two published samples
+    uint32_t ival_max;
+} S_i2cReadStats;
+
+/****************
+ \brief One periodic read - fill the first block, the rest is scheduler's
+ ****************/
+typedef struct _S_i2cRead{
+    uint8_t addr;           // 7-bit slave address
+    uint8_t reg;            // register written before the read
+    uint8_t flags;          // I2C_READ_*
+    uint16_t len;           // bytes per sample
+    uint16_t period;        // [ms], 0 - paused
+    uint16_t phase;         // first due time after i2c_sched_add() [ms]
+    uint8_t *buf;           // 2 * len bytes
+    F_i2cSample sample;     // new sample, from the interrupt; may be 0
+    void *arg;
+
+    S_i2cXfer x;
+    struct _S_i2cSched *sched;
+    uint32_t due;           // system_tick
+    volatile uint32_t seq;  // samples published, front half = seq & 1
+    volatile uint32_t stamp[2];     // DWT CYCCNT of each half's read
+    volatile uint32_t busy;
+    uint32_t t_queued;
+    S_i2cReadStats stats;
+    struct _S_i2cRead *next;
+} S_i2cRead;
+
+/****************
+ \brief Scheduler counters (DWT cycles)
+ ****************/
+typedef struct _S_i2cSchedStats{
+    uint32_t batches;
+    uint32_t reads;
+    uint32_t batch_max;     // most reads in one batch
+    uint32_t busy_last;     // first queued -> last done of a batch
+    uint32_t busy_max;
+} S_i2cSchedStats;
+
+/****************
+ \brief Scheduler state, one per I2C master
+ ****************/
+typedef struct _S_i2cSched{
+    S_i2cMaster *m;
+    S_i2cRead *list;
+    volatile uint32_t inflight;
+    uint32_t t_batch;
+    S_i2cSchedStats stats;
+} S_i2cSched;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Prepares an empty scheduler
+ \param s scheduler state
+ \param m initialised I2C master the reads are queued on
+ ****************/
+void INIT_i2cSched(S_i2cSched *s, S_i2cMaster *m);
+
+/****************
+ \brief Registers a periodic read, the first one is due after d->phase
+ \param s scheduler state
+ \param d read, owned by the scheduler from now on
+ ****************/
+void i2c_sched_add(S_i2cSched *s, S_i2cRead *d);
+
+/****************
+ \brief Queues every due read as one batch, runs the master's recovery
+ \param s scheduler state
+ \retval reads queued
+ ****************/
+uint32_t i2c_sched_tick(S_i2cSched *s);
+
+/****************
+ \brief Copies the latest published sample
+ \param d read
+ \param out d->len bytes
+ \param stamp DWT CYCCNT the sample was read at, may be 0
+ \retval sample number, 0 - nothing read yet (out untouched)
+ ****************/
+uint32_t i2c_sched_get(const S_i2cRead *d, void *out, uint32_t *stamp);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // I2C_SCHED_H_INCLUDED
@@ -0,0 +1,133 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      MPU region presets - stack guard, no-execute RAM, read-only flash
+\descrptn
+    INIT_mpuGuard() runs from pre_main_hook() (before main) and sets up:
+    - MPU_REGION_FLASH  flash read-only, executable
+    - MPU_REGION_SRAM   SRAM1+SRAM2 read/write, never executed
+    - MPU_REGION_CCM    CCM RAM read/write, never executed
+    - MPU_REGION_DMA0.. free slots for mpu_dma_region() (shareable, not
+                        cacheable - a no-op on F4, needed on cached parts)
+    - MPU_REGION_GUARD  no-access block MPU_STACK_BYTES below the top of
+                        RAM - the main stack grows down into it instead of
+                        into the newlib heap (_sbrk from "end", right after
+                        .bss) and the .bss buffers
+    Everything else keeps the default memory map (PRIVDEFENA). The MPU is off
+    in HardFault/NMI (HFNMIENA 0) only; MemManage/BusFault/UsageFault run
+    with it on, so fault_dump.c turns it off first to read the broken stack.
+    A stack overflow ends up as MemManage with MSTKERR/DACCVIOL.
+    Flash programming has to mpu_region_disable(MPU_REGION_FLASH) first.
+    Build with "make MPU_GUARD=0" to leave the MPU off.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef MPU_GUARD_H_INCLUDED
+#define MPU_GUARD_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// no-access block under the stack, power of 2 >= 32 - bigger catches
+// bigger frames (an FPU exception frame alone is 104 bytes)
+#define MPU_GUARD_BYTES     256
+// main stack above the guard, the heap gets the RAM between .bss and the
+// guard (the guard never goes below .bss); 0 = guard right above .bss, only
+// for a build with no heap - malloc/printf would hit it
+#define MPU_STACK_BYTES     (8 * 1024)
+//____________________________________________________
+//constants (do not change)
+// region numbers - a higher number wins where regions overlap
+#define MPU_REGION_FLASH    0
+#define MPU_REGION_SRAM     1
+#define MPU_REGION_CCM      2
+#define MPU_REGION_DMA0     3
+#define MPU_REGION_DMA_COUNT 4
+#define MPU_REGION_GUARD    7
+
+#define MPU_FLASH_BASE      0x08000000u
+#define MPU_FLASH_BYTES     (1024 * 1024)
+#define MPU_SRAM_BASE       0x20000000u
+#define MPU_SRAM_BYTES      (128 * 1024)
+#define MPU_CCM_BASE        0x10000000u
+#define MPU_CCM_BYTES       (64 * 1024)
+//____________________________________________________
+// macro functions (do not use often!)
+// declare a DMA buffer that mpu_dma_region() accepts, size power of 2 >= 32
+#define MPU_DMA_BUFFER(size) __attribute__((aligned(size)))
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Programs the preset regions and enables the MPU
+ \retval base address of the stack guard, 0 if the core has no MPU
+ ****************/
+uint32_t INIT_mpuGuard(void);
+
+/****************
+ \brief Programs one region (interrupts masked, barriers included)
+ \param region 0..7
+ \param base start address, aligned to size
+ \param size power of 2 >= 32 bytes
+ \param attr MPU_RASR_ATTR_* bits (AP, XN, TEX/S/C/B)
+ \retval 0 on success, -1 on bad arguments
+ ****************/
+int mpu_region_set(uint32_t region, uint32_t base, uint32_t size,
+                   uint32_t attr);
+
+/****************
+ \brief Disables one region
+ \param region 0..7
+ ****************/
+void mpu_region_disable(uint32_t region);
+
+/****************
+ \brief Maps a DMA buffer as shareable non-cacheable, never executed
+ \param buf buffer declared with MPU_DMA_BUFFER(size)
+ \param size power of 2 >= 32 bytes
+ \retval region used, -1 on bad arguments or no free DMA slot
+ ****************/
+int mpu_dma_region(volatile void *buf, uint32_t size);
+
+/****************
+ \brief Lowest usable main stack address (just above the guard)
+ \retval 0 if INIT_mpuGuard() did not run
+ ****************/
+uint32_t mpu_stack_limit(void);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // MPU_GUARD_H_INCLUDED
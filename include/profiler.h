@@ -0,0 +1,133 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Cycle accurate function profiler (DWT CYCCNT + -finstrument-functions)
+\descrptn
+    Build with "make PROFILE=1" - every function compiled with
+    -finstrument-functions then calls __cyg_profile_func_enter/exit, which
+    accumulate calls, inclusive and exclusive cycles per function address into
+    the fixed-size open-addressed hash table prof_table.
+    To profile libopencm3 calls too (exti_reset_request, gpio_toggle, ..),
+    rebuild the library with the same flag: "make -C lib/libopencm3 clean".
+    Read the table with gdb:
+        dump binary value prof.bin prof_table
+    and symbolize it with:
+        scripts/prof_report.py bin/project.elf prof.bin
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+
+// number of hash table slots = 1<<PROF_TABLE_BITS (24 B each)
+#define PROF_TABLE_BITS     8
+// maximal tracked call depth (ISR nesting included)
+#define PROF_STACK_DEPTH    48
+
+//____________________________________________________
+//constants (do not change)
+#define PROF_TABLE_SIZE     (1u << PROF_TABLE_BITS)
+// "PROF" in little endian memory dump
+#define PROF_MAGIC          0x464F5250u
+// bump when S_profEntry / S_profTable layout changes (prof_report.py)
+#define PROF_VERSION        1u
+
+//____________________________________________________
+// macro functions (do not use often!)
+#define PROF_NOINSTR __attribute__((no_instrument_function))
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief One profiled function. fn == 0 marks an empty slot
+ ****************/
+typedef struct _S_profEntry{
+    uint32_t fn;            // function address (thumb bit cleared)
+    uint32_t calls;         // number of completed calls
+    uint64_t incl;          // cycles spent in fn including callees and ISRs
+    uint64_t excl;          // cycles spent in fn itself
+} S_profEntry;
+
+/****************
+ \brief Whole profiling state - layout is parsed by scripts/prof_report.py
+ ****************/
+typedef struct _S_profTable{
+    uint32_t magic;         // PROF_MAGIC
+    uint32_t version;       // PROF_VERSION
+    uint32_t size;          // PROF_TABLE_SIZE
+    uint32_t cpu_hz;        // core clock for cycles -> time conversion
+    uint32_t enabled;       // hooks do nothing while zero
+    uint32_t lost_full;     // calls not recorded - table full
+    uint32_t lost_depth;    // calls not recorded - deeper than PROF_STACK_DEPTH
+    uint32_t max_depth;     // deepest call nesting seen
+    S_profEntry entry[PROF_TABLE_SIZE];
+} S_profTable;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+extern volatile S_profTable prof_table;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Enables DWT cycle counter, clears the table and arms the hooks
+ \param cpu_hz core clock stored into the table for the host tool
+ \retval 0 on success, -1 when the core has no cycle counter
+ ****************/
+PROF_NOINSTR int INIT_profiler(uint32_t cpu_hz);
+
+/****************
+ \brief Clears all accumulated data (keeps hooks armed)
+ ****************/
+PROF_NOINSTR void profiler_reset(void);
+
+/****************
+ \brief Arms/disarms the hooks (e.g. to profile just one code section)
+ \param enable nonzero to record
+ ****************/
+PROF_NOINSTR void profiler_enable(uint32_t enable);
+
+/****************
+ \brief Hooks called by code built with -finstrument-functions
+ \param fn address of the entered/exited function
+ \param call_site address of the caller
+ ****************/
+PROF_NOINSTR void __cyg_profile_func_enter(void *fn, void *call_site);
+PROF_NOINSTR void __cyg_profile_func_exit(void *fn, void *call_site);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // PROFILER_H_INCLUDED
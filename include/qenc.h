@@ -0,0 +1,138 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Quadrature encoder on a timer encoder interface, velocity estimate
+\descrptn
+    A and B go to CH1 and CH2 of the encoder timer (TIM1/2/3/4/5/8) which
+    counts every edge of both (encoder mode 3, x4) in hardware - no CPU
+    per edge at any rate the input filter lets through.
+    qenc_poll() extends the counter to a 32-bit position: the signed
+    difference from the last poll is added, so a 16-bit timer has to be
+    polled at least once per 32768 counts (32 ms at 1 M counts/s).
+    Velocity:
+    - with a time base (tb, TIM2 / TIM5 free running at QENC_TB_HZ): IC1
+      of the encoder timer latches CNT on every rising edge of A, its
+      compare pulse (TRGO) goes over the internal trigger to tb, where a
+      TRC capture latches the time of the same edge. The estimate is
+      positions of two timed edges over the time between them - many
+      edges per poll give the count delta over exactly their time span,
+      one edge per many polls gives one A period over its exact length.
+    - without tb: the poll times (DWT) of the polls where the count moved
+      are used instead - resolution one poll period.
+    When no edge comes, the speed can not be higher than one step since
+    the last edge - the estimate decays to that bound and after
+    QENC_STOP_MS it is zero.
+        INIT_qenc(&wheel, TIM3, TIM5, 4);
+        ...
+        qenc_poll(&wheel);      // 1 ms
+        pos = wheel.pos;        // counts
+        v = wheel.vel;          // counts/s << QENC_VEL_FRAC
+    Internal trigger connections (RM0090) - tb TIM2: TIM1, TIM8, TIM3, TIM4,
+    tb TIM5: TIM2, TIM3, TIM4, TIM8; one encoder per tb (one TS field), the
+    tb has to stay free running - it can be shared with edge_cap.h. Timer
+    clocks and pins (AF) are set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef QENC_H_INCLUDED
+#define QENC_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// time base clock (TIM2 / TIM5, APB1 x2) and SYSCLK (DWT)
+#define QENC_TB_HZ          84000000
+#define QENC_SYSCLK_HZ      168000000
+// A / B input filter, enum tim_ic_filter
+#define QENC_FILTER         TIM_IC_CK_INT_N_4
+// no edge for this long - standing still
+#define QENC_STOP_MS        500
+//____________________________________________________
+//constants (do not change)
+// S_qenc.vel fraction bits
+#define QENC_VEL_FRAC       8
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief Encoder counters
+ ****************/
+typedef struct _S_qencStats{
+    uint32_t polls;
+    uint32_t edges;         // velocity updates from a new timed edge
+    uint32_t stops;         // QENC_STOP_MS without an edge
+    uint32_t step_max;      // largest |count change| between two polls
+} S_qencStats;
+
+/****************
+ \brief Encoder state
+ ****************/
+typedef struct _S_qenc{
+    uint32_t tim;           // encoder timer
+    uint32_t tb;            // time base TIM2 / TIM5, 0 - poll times
+    uint8_t tb_ch;          // tb channel 1..4 capturing the edge times
+    uint8_t wide;           // 32-bit encoder counter
+    uint8_t have;           // e_pos / t_edge valid
+    uint32_t cnt;           // CNT at the last poll
+    int32_t pos;            // extended position [counts]
+    int32_t vel;            // [counts/s << QENC_VEL_FRAC]
+    int32_t e_pos;          // position of the last timed edge
+    uint32_t t_edge;        // its time [tb ticks / DWT cycles]
+    S_qencStats stats;
+} S_qenc;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Starts the encoder interface, position 0
+ \param q encoder state
+ \param tim encoder timer, A on CH1, B on CH2
+ \param tb TIM2 / TIM5 time base of the edges, 0 - poll times; a pair
+        without an internal trigger connection falls back to 0
+ \param tb_ch tb channel 1..4 free for the edge time capture
+ ****************/
+void INIT_qenc(S_qenc *q, uint32_t tim, uint32_t tb, uint8_t tb_ch);
+
+/****************
+ \brief Updates the position and the velocity - call it periodically
+ \param q encoder state
+ \retval position [counts]
+ ****************/
+int32_t qenc_poll(S_qenc *q);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // QENC_H_INCLUDED
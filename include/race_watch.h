@@ -0,0 +1,143 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Write watchpoints on shared globals (DWT comparators + DebugMonitor)
+\descrptn
+    Every write to an armed address raises the DebugMonitor exception, which
+    logs the writer's PC, its context (exception number, 0 = thread mode) and
+    the DWT cycle stamp into race_ring and counts the writing contexts per
+    comparator in race_watch[].
+    - the core must NOT be under halting debug (C_DEBUGEN), otherwise the
+      watchpoint halts the core instead - run detached and attach afterwards
+    - watchpoints are imprecise, the logged PC is a few instructions behind
+      the store
+    - a writer can only be attributed when DebugMonitor preempts it, so
+      INIT_raceWatch() moves every handler from priority group 0 to
+      RACE_WATCH_MIN_PRIO - call it after all nvic_set_priority() calls
+    Build with "make RACE_WATCH=1" to watch system_tick and tic_toc_start.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef RACE_WATCH_H_INCLUDED
+#define RACE_WATCH_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// logged writes kept, must be power of 2
+#define RACE_RING_SIZE      64
+// lowest priority value left to other handlers (F4 implements bits 7:4)
+#define RACE_WATCH_MIN_PRIO (1 << 4)
+//____________________________________________________
+//constants (do not change)
+// Cortex-M4 DWT has 4 comparators
+#define RACE_WATCH_COMPS    4
+// exception numbers 0..127 fit into the context bitmap
+#define RACE_CTX_WORDS      4
+// S_raceHit.flags
+#define RACE_HIT_PSP        (1 << 0)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief One logged write
+ ****************/
+typedef struct _S_raceHit{
+    uint32_t cycle;         // DWT CYCCNT in DebugMonitor
+    uint32_t pc;            // stacked PC of the writer
+    uint32_t value;         // watched variable after the write
+    uint16_t context;       // exception number of the writer, 0 = thread
+    uint8_t comp;           // comparator that matched
+    uint8_t flags;          // RACE_HIT_*
+} S_raceHit;
+
+/****************
+ \brief Per comparator summary - which contexts write and how often
+ ****************/
+typedef struct _S_raceWatch{
+    uint32_t addr;          // 0 = comparator not armed
+    uint32_t size;          // 1, 2 or 4 bytes
+    uint32_t writes;        // all writes seen
+    uint32_t handler_writes;// writes done from any exception handler
+    uint32_t ctx_seen[RACE_CTX_WORDS]; // bit n = exception n wrote
+} S_raceWatch;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+extern volatile S_raceWatch race_watch[RACE_WATCH_COMPS];
+extern volatile S_raceHit race_ring[RACE_RING_SIZE];
+extern volatile uint32_t race_ring_head;
+extern volatile uint32_t race_ring_tail;
+extern volatile uint32_t race_ring_dropped;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Enables DWT, cycle counter and DebugMonitor at top priority
+ \retval number of DWT comparators, 0 if the monitor cannot be used
+ ****************/
+uint32_t INIT_raceWatch(void);
+
+/****************
+ \brief Arms a write watchpoint
+ \param comp comparator index (< INIT_raceWatch() result)
+ \param addr watched variable, must be aligned to size
+ \param size 1, 2 or 4 bytes
+ \retval 0 on success, -1 on bad arguments
+ ****************/
+int race_watch_arm(uint32_t comp, volatile void *addr, uint32_t size);
+
+/****************
+ \brief Disarms a comparator (its statistics are kept)
+ \param comp comparator index
+ ****************/
+void race_watch_disarm(uint32_t comp);
+
+/****************
+ \brief Number of distinct contexts that wrote through comparator comp
+ \param comp comparator index
+ \retval >1 means the variable is shared between contexts
+ ****************/
+uint32_t race_watch_contexts(uint32_t comp);
+
+/****************
+ \brief Pops logged writes (oldest first)
+ \param out destination array
+ \param max capacity of out
+ \retval number of entries copied
+ ****************/
+uint32_t race_watch_read(S_raceHit *out, uint32_t max);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // RACE_WATCH_H_INCLUDED
@@ -0,0 +1,160 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Full duplex SPI master on paired DMA streams with a queue
+\descrptn
+    Transactions (S_spiXfer) are queued by spi_dma_submit() and executed
+    back to back by the DMA interrupt, the CPU only sets up each one:
+    - chip select: the GPIO goes low before the first clock and high after
+      the last received item, then the next transaction starts at once
+    - mode, prescaler, 8/16 bit and bit order are per transaction; the SPI
+      is disabled for reconfiguration only when they differ from the
+      previous one
+    - RX and TX run on two streams (spi_enable_rx_dma/spi_enable_tx_dma),
+      the RX stream has the higher priority so it never overruns; its
+      transfer complete is the end of the transaction. Missing tx/rx
+      buffers are replaced by a fixed 0xFF source / a dummy sink
+    The queue is an intrusive list - S_spiXfer is owned by the caller and
+    must stay valid until done() is called (from the interrupt).
+    SPI1 on APB2 (84 MHz) with SPI_CR1_BR_FPCLK_DIV_2 runs at 42 Mbit/s;
+    SPI2/3 (APB1) reach 21 Mbit/s.
+        S_dmaStream rx, tx;
+        dma_alloc(DMA_REQ_SPI1_RX, &rx);
+        dma_alloc(DMA_REQ_SPI1_TX, &tx);
+        INIT_spiDma(&spi1, SPI1, &rx, &tx);
+        void dma2_stream0_isr(void){ spi_dma_irq(&spi1); }   // rx.stream
+        void dma2_stream3_isr(void){ spi_dma_irq(&spi1); }   // tx.stream
+        spi_dma_submit(&spi1, &imu_read);
+    Clocks and the SCK/MISO/MOSI/CS pins are set up by the user.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef SPI_DMA_H_INCLUDED
+#define SPI_DMA_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+//____________________________________________________
+//constants (do not change)
+// S_spiXfer.flags
+#define SPI_XFER_16BIT      (1 << 0)    // 16-bit items, len counts items
+#define SPI_XFER_LSB_FIRST  (1 << 1)
+#define SPI_XFER_CS_HOLD    (1 << 2)    // keep CS low for the next xfer
+
+// done callback err values
+#define SPI_DMA_OK          0
+#define SPI_DMA_ERR_TRANSFER 1          // TEIF on one of the streams
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+typedef void (*F_spiDone)(void *arg, int err);
+
+/****************
+ \brief One transaction
+ ****************/
+typedef struct _S_spiXfer{
+    uint32_t cs_port;       // GPIOx, 0 - no chip select
+    uint16_t cs_pin;        // GPIOn
+    uint8_t mode;           // SPI mode 0..3 (CPOL << 1 | CPHA)
+    uint8_t br;             // SPI_CR1_BR_FPCLK_DIV_n
+    uint8_t flags;          // SPI_XFER_*
+    uint16_t len;           // items, > 0
+    const void *tx;         // 0 - send 0xFF
+    void *rx;               // 0 - discard
+    F_spiDone done;         // may be 0
+    void *arg;
+    struct _S_spiXfer *next;    // queue link, used by the engine
+} S_spiXfer;
+
+/****************
+ \brief Engine counters
+ ****************/
+typedef struct _S_spiDmaStats{
+    uint32_t xfers;
+    uint32_t items;
+    uint32_t reconfigs;     // SPI disabled to change mode/speed/size
+    uint32_t errors;
+} S_spiDmaStats;
+
+/****************
+ \brief Engine state, one per SPI
+ ****************/
+typedef struct _S_spiDma{
+    uint32_t spi;
+    S_dmaStream rxs;
+    S_dmaStream txs;
+    uint32_t cr1;           // configuration of the last transaction
+    S_spiXfer *volatile head;   // running
+    S_spiXfer *tail;
+    S_spiDmaStats stats;
+} S_spiDma;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Makes the SPI a DMA driven master
+ \param e engine state
+ \param spi SPI1..SPI3 (clock and pins already set up)
+ \param rx stream from dma_alloc(DMA_REQ_SPIx_RX)
+ \param tx stream from dma_alloc(DMA_REQ_SPIx_TX)
+ ****************/
+void INIT_spiDma(S_spiDma *e, uint32_t spi, const S_dmaStream *rx,
+                 const S_dmaStream *tx);
+
+/****************
+ \brief Queues a transaction, starts it when the SPI is idle
+ \param e engine state
+ \param x transaction, untouched by the caller until done
+ ****************/
+void spi_dma_submit(S_spiDma *e, S_spiXfer *x);
+
+/****************
+ \brief RX/TX stream interrupt body - call it from both dmaX_streamY_isr
+ \param e engine state
+ ****************/
+void spi_dma_irq(S_spiDma *e);
+
+/****************
+ \brief Nonzero while transactions are queued or running
+ \param e engine state
+ ****************/
+uint32_t spi_dma_busy(const S_spiDma *e);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // SPI_DMA_H_INCLUDED
@@ -0,0 +1,94 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Statistical PC sampling + exception trace over ITM/TPIU (SWO pin)
+\descrptn
+    The DWT periodically emits the sampled PC and every exception
+    entry/exit/return as hardware source packets, the ITM adds local
+    timestamps and the TPIU shifts it all out of PB3 (TRACESWO) as NRZ.
+    No code runs on the target per sample.
+    Capture the pin with any UART/probe set to swo_baud (8N1) into a file and
+    run:
+        scripts/swo_decode.py bin/project.elf swo.bin
+    Keep the byte rate in mind - one PC sample is 5 B, one exception event
+    3 B + timestamp, so at 2 MBd a sample_period below ~4000 cycles overflows
+    the ITM FIFO (decoder reports the overflow packets).
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef SWO_TRACE_H_INCLUDED
+#define SWO_TRACE_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// stimulus port used by swo_mark()
+#define SWO_PORT_MARK       1
+//____________________________________________________
+//constants (do not change)
+// trace bus ID the decoder does not care about, but must be nonzero
+#define SWO_TRACE_BUS_ID    1
+// PC sampling divider limits, see INIT_swoTrace()
+#define SWO_SAMPLE_MIN      64
+#define SWO_SAMPLE_MAX      (16 * 1024)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Routes TRACESWO to PB3 and starts PC sampling + exception trace
+ \param cpu_hz core clock (= TRACECLKIN on F4)
+ \param swo_baud SWO bit rate, cpu_hz/swo_baud should be an integer
+ \param sample_period wanted cycles between PC samples, it is rounded to
+        the nearest 64*n (n<=16) or 1024*n (n<=16); 0 disables PC sampling
+ \retval sample period really set in cycles (0 = sampling disabled)
+ ****************/
+uint32_t INIT_swoTrace(uint32_t cpu_hz, uint32_t swo_baud, uint32_t sample_period);
+
+/****************
+ \brief Stops sampling and exception trace (the stimulus ports stay usable)
+ ****************/
+void swo_trace_stop(void);
+
+/****************
+ \brief Emits a 32bit software marker on SWO_PORT_MARK (shown in timeline)
+ \param value user value, e.g. a phase ID
+ ****************/
+void swo_mark(uint32_t value);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // SWO_TRACE_H_INCLUDED
@@ -0,0 +1,221 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      PWM waveforms from a memory table by the timer DMA burst (DCR/DMAR)
+\descrptn
+    Every update event of the timer requests a DMA burst: TIMx_DCR points
+    it at a block of consecutive registers (DBA, DBL) and the DMA writes a
+    whole frame of them through TIMx_DMAR - e.g. CCR1..CCR4, or ARR, RCR
+    and CCR1..CCR4 for a variable period. ARR and CCRx preload is on, so a
+    frame written after update k is used from update k+1 on, all its
+    registers at once. No CPU per frame.
+    Modes of tim_burst_play():
+    - TIM_BURST_ONCE: the table plays once, the last frame stays
+    - TIM_BURST_LOOP: the table repeats (circular DMA)
+    - TIM_BURST_STREAM: the table is two halves, the half the DMA has just
+      left is refilled by fill() from the stream interrupt; when fill()
+      returns 0 its half is the last one, the other half is padded with the
+      last frame and the stream stops after the last half played
+    Helpers:
+    - WS2812 smart LEDs on one channel at 800 kbit/s: a frame per bit
+      (CCR = T0H / T1H), then TIM_BURST_LED_RESET low frames; the encoder is
+      a fill() for streaming, or fills a whole ONCE table in one call
+    - multi-phase sine PWM for motors: frames of 2..4 CCRs shifted by
+      360 / phases, played in LOOP - electrical frequency = f_pwm / frames
+      (TIM1/TIM8 RCR lowers the frame rate further)
+        // TIM3 CH1, ARR = TIM_BURST_LED_ARR, PWM mode 1 set up by the user
+        S_dmaStream s;
+        dma_alloc(DMA_REQ_TIM3_UP, &s);
+        INIT_timBurst(&leds, TIM3, &s, TIM_BURST_CCR1, 1);
+        tim_burst_led_start(&strip, grb, 60);
+        tim_burst_play(&leds, ring, 2 * 48, TIM_BURST_STREAM,
+                       tim_burst_led_fill, &strip);
+        void dma1_stream2_isr(void){ tim_burst_irq(&leds); }
+    Tables are uint16_t frames for 16-bit timers, uint32_t for TIM2 / TIM5
+    (the helpers write uint16_t). The timer, its outputs and pins are set
+    up by the user, the burst only writes the registers.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef TIM_BURST_H_INCLUDED
+#define TIM_BURST_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// WS2812 at 84 MHz timer clock: 1.25 us bit, 0.4 / 0.8 us high
+#define TIM_BURST_LED_ARR   104
+#define TIM_BURST_LED_T0H   34
+#define TIM_BURST_LED_T1H   67
+// low frames after the data, 300 us covers the WS2812B latch
+#define TIM_BURST_LED_RESET 240
+//____________________________________________________
+//constants (do not change)
+// DBA - first register of the frame, in words from CR1
+#define TIM_BURST_ARR       11      // ARR, RCR, CCR1..CCR4 - len 6
+#define TIM_BURST_CCR1      13      // CCR1..CCR4 - len 1..4
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+
+typedef enum _E_timBurstMode{
+    TIM_BURST_ONCE = 0,
+    TIM_BURST_LOOP,
+    TIM_BURST_STREAM
+} E_timBurstMode;
+
+//____________________________________________________
+// structs
+
+/****************
+ \brief Refill of a stream half
+ \param arg given to tim_burst_play()
+ \param half frames to fill
+ \param frames frames in the half
+ \retval 1 - more follows, 0 - this half is the last one
+ ****************/
+typedef uint8_t (*F_timBurstFill)(void *arg, void *half, uint32_t frames);
+
+/****************
+ \brief Waveform counters
+ ****************/
+typedef struct _S_timBurstStats{
+    uint32_t plays;
+    uint32_t refills;
+    uint32_t late;          // both halves done before the refill - glitch
+    uint32_t errors;        // TEIF
+} S_timBurstStats;
+
+/****************
+ \brief Waveform engine state, one per timer
+ ****************/
+typedef struct _S_timBurst{
+    uint32_t tim;
+    S_dmaStream s;
+    uint8_t dba;            // TIM_BURST_*
+    uint8_t len;            // registers per frame
+    uint8_t item;           // bytes per register, 2 / 4
+    E_timBurstMode mode;
+    uint8_t *buf;
+    uint32_t half;          // frames per stream half
+    F_timBurstFill fill;
+    void *arg;
+    uint8_t ending;         // stream: 1 - last half queued, 2 - padded
+    volatile uint8_t busy;
+    S_timBurstStats stats;
+} S_timBurst;
+
+/****************
+ \brief WS2812 encoder state
+ ****************/
+typedef struct _S_timBurstLed{
+    const uint8_t *grb;     // 3 bytes per LED, G R B
+    uint32_t bits;          // data bits
+    uint32_t bit;           // next bit to encode
+    uint32_t reset;         // low frames still to send
+} S_timBurstLed;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Binds the engine to a timer and its update DMA stream
+ \param b engine state
+ \param tim timer (TIM1..TIM5, TIM8)
+ \param s stream from dma_alloc(DMA_REQ_TIMx_UP)
+ \param dba TIM_BURST_ARR / TIM_BURST_CCR1 (+1..3 for a later CCR)
+ \param len registers per frame
+ ****************/
+void INIT_timBurst(S_timBurst *b, uint32_t tim, const S_dmaStream *s,
+                   uint8_t dba, uint8_t len);
+
+/****************
+ \brief Starts a table - the first frame is written at the next update
+ \param b engine state
+ \param buf frames, must stay valid while playing
+ \param frames frames in buf (even for TIM_BURST_STREAM), frames * len
+        at most 65535
+ \param mode TIM_BURST_*
+ \param fill stream refill, called for both halves before the start
+        (TIM_BURST_STREAM only, 0 otherwise)
+ \param arg passed to fill
+ \retval 0 started, -1 busy or bad size
+ ****************/
+int tim_burst_play(S_timBurst *b, void *buf, uint32_t frames,
+                   E_timBurstMode mode, F_timBurstFill fill, void *arg);
+
+/****************
+ \brief Stops the DMA, the registers keep the last frame
+ \param b engine state
+ ****************/
+void tim_burst_stop(S_timBurst *b);
+
+/****************
+ \brief Stream interrupt body - call it from the dmaX_streamY_isr
+ \param b engine state
+ ****************/
+void tim_burst_irq(S_timBurst *b);
+
+/****************
+ \brief Prepares a WS2812 bit stream
+ \param l encoder state
+ \param grb colours, 3 bytes per LED, valid until encoded
+ \param leds number of LEDs
+ ****************/
+void tim_burst_led_start(S_timBurstLed *l, const uint8_t *grb,
+                         uint32_t leds);
+
+/****************
+ \brief WS2812 encoder - F_timBurstFill, or a whole ONCE table of
+        24 * leds + TIM_BURST_LED_RESET frames in one call
+ \param arg S_timBurstLed
+ \param half uint16_t CCR frames
+ \param frames frames to write
+ \retval 1 - more bits follow, 0 - the stream ends in these frames
+ ****************/
+uint8_t tim_burst_led_fill(void *arg, void *half, uint32_t frames);
+
+/****************
+ \brief Fills a multi-phase sine PWM table
+ \param tab frames of phases uint16_t CCRs
+ \param frames frames per electrical period
+ \param phases 2..4, phase k shifted by k * 360 / phases
+ \param arr timer period (ARR), the duty centre is arr / 2
+ \param amp peak to peak amplitude [ticks], at most arr
+ ****************/
+void tim_burst_sine(uint16_t *tab, uint32_t frames, uint8_t phases,
+                    uint16_t arr, uint16_t amp);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // TIM_BURST_H_INCLUDED
@@ -0,0 +1,225 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.h
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Interrupt driven USART with RX/TX ring buffers
+\descrptn
+    The USART interrupt moves bytes between the data register and two
+    single-producer/single-consumer rings, so no lock is needed:
+    - RX: the interrupt is the only writer of rx_head, usart_buf_read() the
+      only writer of rx_tail; a full ring drops the byte (rx_dropped)
+    - TX: usart_buf_write() is the only writer of tx_head, the interrupt the
+      only writer of tx_tail; TXEIE is on only while the ring holds data
+    read/write move whole spans with memcpy (at most two pieces around the
+    ring end). The interrupt touches SR/DR directly and indexes the rings
+    with a mask, a byte costs a few dozen cycles.
+    Ring sizes must be powers of two; head/tail run freely and wrap.
+    At 921600 Bd a byte arrives every ~1800 cycles (168 MHz) and DR holds
+    only one more - give the USART a higher priority (lower number) than
+    EXTI so a burst of edge interrupts cannot cause an overrun.
+    Clock, GPIO alternate functions and the usartX_isr are up to the user:
+        static uint8_t rx[512], tx[512];
+        static S_usartBuf u1;
+        void usart1_isr(void){ usart_buf_irq(&u1); }
+        INIT_usartBuf(&u1, USART1, NVIC_USART1_IRQ, 921600, rx, sizeof(rx),
+                      tx, sizeof(tx));
+
+    DMA RX mode (usart_buf_rx_dma()) - for bursts without per-byte interrupts
+    a circular DMA stream writes straight into the RX ring, rx_head follows
+    NDTR. It is caught up on the half/full transfer interrupts (so the ring
+    is never lapped unseen) and on the USART IDLE interrupt, which also ends
+    a frame: frame(arg, len) gets the bytes received since the previous
+    frame, at most one character time after the line went idle. Errors come
+    through EIE. The data is read with usart_buf_read() or, zero-copy, with
+    usart_buf_rx_span()/usart_buf_rx_consume(). The DMA cannot be stopped
+    by a full ring - a reader that falls behind by more than the ring size
+    loses the oldest bytes (rx_dropped).
+        S_dmaStream s;
+        dma_alloc(DMA_REQ_USART1_RX, &s);       // DMA2 stream 2 or 5
+        void dma2_stream2_isr(void){ usart_buf_dma_irq(&u1); }
+        usart_buf_rx_dma(&u1, &s, on_frame, 0);
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+#ifndef USART_BUF_H_INCLUDED
+#define USART_BUF_H_INCLUDED
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <stdint.h>
+//_________> project includes
+#include "dma_alloc.h"
+//_________> local includes
+//_________> forward includes
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//____________________________________________________
+//constants (user-defined)
+// NVIC priority set by INIT_usartBuf() - above the button EXTI lines
+// (EXTI_BUTTON_PRIORITY 0x80 in main.c; the F4 keeps bits 7:4 only)
+#define USART_BUF_PRIORITY      0x40
+//____________________________________________________
+//constants (do not change)
+//____________________________________________________
+// macro functions (do not use often!)
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+
+/****************
+ \brief Line and ring counters
+ ****************/
+typedef struct _S_usartBufStats{
+    uint32_t rx;            // bytes received into the ring
+    uint32_t tx;            // bytes sent
+    uint32_t overrun;       // SR.ORE - a byte lost in the USART
+    uint32_t framing;       // SR.FE - missing stop bit / break
+    uint32_t noise;         // SR.NE
+    uint32_t parity;        // SR.PE
+    uint32_t rx_dropped;    // RX ring full / lapped by the DMA
+    uint32_t frames;        // IDLE-terminated frames (DMA RX mode)
+    uint32_t dma_errors;    // TEIF on the RX stream
+} S_usartBufStats;
+
+typedef void (*F_usartFrame)(void *arg, uint32_t len);
+
+/****************
+ \brief Driver state, one per USART
+ ****************/
+typedef struct _S_usartBuf{
+    uint32_t usart;         // USART1..UART5, USART6
+    uint8_t *rx;
+    uint32_t rx_mask;       // size - 1
+    volatile uint32_t rx_head;
+    volatile uint32_t rx_tail;
+    uint8_t *tx;
+    uint32_t tx_mask;
+    volatile uint32_t tx_head;
+    volatile uint32_t tx_tail;
+    // DMA RX mode
+    S_dmaStream rxs;
+    uint32_t rx_dma;        // 1 when the RX ring is fed by rxs
+    uint32_t rx_pos;        // ring index the DMA was last seen at
+    uint32_t frame_start;   // rx_head at the end of the previous frame
+    F_usartFrame frame;
+    void *frame_arg;
+    S_usartBufStats stats;
+} S_usartBuf;
+
+//____________________________________________________
+// unions
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DECLARATIONS
+/****************
+ \brief Sets the USART to 8N1 at baud, enables it with the RX interrupt
+ \param u driver state
+ \param usart USART1..UART5, USART6 (clock and pins already set up)
+ \param irqn NVIC_USARTx_IRQ
+ \param baud bit rate
+ \param rx RX ring storage, rx_size a power of two
+ \param tx TX ring storage, tx_size a power of two
+ \retval 0 on success, -1 on a ring size that is not a power of two
+ ****************/
+int INIT_usartBuf(S_usartBuf *u, uint32_t usart, uint8_t irqn, uint32_t baud,
+                  uint8_t *rx, uint32_t rx_size, uint8_t *tx, uint32_t tx_size);
+
+/****************
+ \brief USART interrupt body - call it from the usartX_isr
+ \param u driver state
+ ****************/
+void usart_buf_irq(S_usartBuf *u);
+
+/****************
+ \brief Takes up to len received bytes, does not block
+ \param u driver state
+ \param buf destination
+ \param len buf size
+ \retval bytes copied
+ ****************/
+uint32_t usart_buf_read(S_usartBuf *u, uint8_t *buf, uint32_t len);
+
+/****************
+ \brief Queues up to len bytes for sending, does not block
+ \param u driver state
+ \param buf data
+ \param len bytes
+ \retval bytes queued - fewer than len when the TX ring is full
+ ****************/
+uint32_t usart_buf_write(S_usartBuf *u, const uint8_t *buf, uint32_t len);
+
+/****************
+ \brief Contiguous received bytes at the read position (zero-copy read)
+ \param u driver state
+ \param p set to the first byte
+ \retval bytes at p, 0 when the ring is empty; the rest of a wrapped span
+         follows after usart_buf_rx_consume()
+ ****************/
+uint32_t usart_buf_rx_span(S_usartBuf *u, const uint8_t **p);
+
+/****************
+ \brief Releases n bytes returned by usart_buf_rx_span()
+ \param u driver state
+ \param n bytes
+ ****************/
+void usart_buf_rx_consume(S_usartBuf *u, uint32_t n);
+
+/****************
+ \brief Switches RX to a circular DMA stream with IDLE-line framing,
+        bytes pending in the RX ring are discarded
+ \param u driver state, after INIT_usartBuf()
+ \param s stream from dma_alloc(DMA_REQ_USARTx_RX), its dmaX_streamY_isr
+        must call usart_buf_dma_irq()
+ \param frame called from the interrupt at the end of each frame (may be 0)
+ \param arg passed to frame
+ \retval 0 on success, -1 when the ring is over 32 KB (NDTR is 16 bits)
+ ****************/
+int usart_buf_rx_dma(S_usartBuf *u, const S_dmaStream *s,
+                     F_usartFrame frame, void *arg);
+
+/****************
+ \brief RX stream interrupt body - call it from the dmaX_streamY_isr
+ \param u driver state
+ ****************/
+void usart_buf_dma_irq(S_usartBuf *u);
+
+/****************
+ \brief Bytes waiting in the RX ring
+ \param u driver state
+ ****************/
+uint32_t usart_buf_rx_count(const S_usartBuf *u);
+
+/****************
+ \brief Free space in the TX ring
+ \param u driver state
+ ****************/
+uint32_t usart_buf_tx_free(const S_usartBuf *u);
+
+/****************
+ \brief Waits until the TX ring is empty and the last stop bit is out
+ \param u driver state
+ ****************/
+void usart_buf_flush(S_usartBuf *u);
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
+
+
+#endif // USART_BUF_H_INCLUDED
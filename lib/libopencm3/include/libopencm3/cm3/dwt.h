@@ -124,16 +124,12 @@
 #define DWT_FUNCTIONx_FUNCTION				15
 #define DWT_FUNCTIONx_FUNCTION_DISABLED			0
 
-/* Those defined only on ARMv6 */
-#if defined(__ARM_ARCH_6M__)
-
+/* Watchpoint functions share their encoding on ARMv6M and ARMv7M */
 #define DWT_FUNCTIONx_FUNCTION_PCWATCH			4
 #define DWT_FUNCTIONx_FUNCTION_DWATCH_R			5
 #define DWT_FUNCTIONx_FUNCTION_DWATCH_W			6
 #define DWT_FUNCTIONx_FUNCTION_DWATCH_RW		7
 
-#endif /* defined(__ARM_ARCH_6M__)*/
-
 /*****************************************************************************/
 /* API definitions                                                           */
 /*****************************************************************************/
@@ -65,7 +65,7 @@
 /* SCB: System Control Block */
 #define SCB_BASE                        (SCS_BASE + 0x0D00)
 
-#ifdef CM0_PLUS
+#if defined(CM0_PLUS) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
 /* MPU: Memory protection unit */
 #define MPU_BASE                        (SCS_BASE + 0x0D90)
 #endif
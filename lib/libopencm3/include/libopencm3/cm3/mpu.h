@@ -17,17 +17,13 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef LIBOPENCM3_CM0_MPU_H
-#define LIBOPENCM3_CM0_MPU_H
+#ifndef LIBOPENCM3_MPU_H
+#define LIBOPENCM3_MPU_H
 
-#ifndef CM0_PLUS
-#error "mpu is supported only on CM0+ architecture"
-#else
-
-#include <libopencm3/cm0/memorymap.h>
-#include <libopencm3/cm0/common.h>
+#include <libopencm3/cm3/memorymap.h>
+#include <libopencm3/cm3/common.h>
 
-/* --- SCB: Registers ------------------------------------------------------ */
+/* --- MPU: Registers ------------------------------------------------------ */
 
 #define MPU_TYPE			MMIO32(MPU_BASE + 0x00)
 #define MPU_CTRL			MMIO32(MPU_BASE + 0x04)
@@ -58,8 +54,14 @@
 
 /* --- MPU_RBAR values ----------------------------------------------------- */
 
+/* ARMv6-M regions are at least 256 bytes, ARMv7-M regions 32 bytes */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define MPU_RBAR_ADDR_LSB		5
+#define MPU_RBAR_ADDR			(0x07FFFFFF << MPU_RBAR_ADDR_LSB)
+#else
 #define MPU_RBAR_ADDR_LSB		8
-#define MPU_RBAR_ADDR			(0x00FFFFFF << MPU_RBAR_REGION_LSB)
+#define MPU_RBAR_ADDR			(0x00FFFFFF << MPU_RBAR_ADDR_LSB)
+#endif
 #define MPU_RBAR_VALID			(1<<4)
 #define MPU_RBAR_REGION_LSB		0
 #define MPU_RBAR_REGION			(0xF << MPU_RBAR_REGION_LSB)
@@ -74,6 +76,15 @@
 #define MPU_RASR_SIZE			(0x1F << MPU_RASR_SIZE_LSB)
 #define MPU_RASR_ENABLE			(1 << 0)
 
+/** Region of 2^n bytes, n >= 5 (ARMv7-M) or n >= 8 (ARMv6-M) */
+#define MPU_RASR_SIZE_LOG2(n)		(((n) - 1) << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_32B		(4 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_256B		(7 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_1KB		(9 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_64KB		(15 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_128KB		(16 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_1MB		(19 << MPU_RASR_SIZE_LSB)
+#define MPU_RASR_SIZE_4GB		(31 << MPU_RASR_SIZE_LSB)
 
 #define MPU_RASR_ATTR_XN		(1 << 28)
 #define MPU_RASR_ATTR_AP		(7 << 24)
@@ -83,20 +94,21 @@
 #define MPU_RASR_ATTR_AP_PRW_URW	(3 << 24)
 #define MPU_RASR_ATTR_AP_PRO_UNO	(5 << 24)
 #define MPU_RASR_ATTR_AP_PRO_URO	(6 << 24)
-#define MPU_RASR_ATTR_AP_PRO_URO	(7 << 24)
 #define MPU_RASR_ATTR_TEX		(7 << 19)
 #define MPU_RASR_ATTR_S			(1 << 18)
 #define MPU_RASR_ATTR_C			(1 << 17)
 #define MPU_RASR_ATTR_B			(1 << 16)
 #define MPU_RASR_ATTR_SCB		(7 << 16)
-#define MPU_RASR_ATTR_SCB_SH_STRONG	(0 << 16)
-#define MPU_RASR_ATTR_SCB_SH_DEVICE	(1 << 16)
+#define MPU_RASR_ATTR_SCB_NSH_STRONG	(0 << 16)
+#define MPU_RASR_ATTR_SCB_NSH_DEVICE	(1 << 16)
 #define MPU_RASR_ATTR_SCB_NSH_WT	(2 << 16)
 #define MPU_RASR_ATTR_SCB_NSH_WB	(3 << 16)
 #define MPU_RASR_ATTR_SCB_SH_STRONG	(4 << 16)
 #define MPU_RASR_ATTR_SCB_SH_DEVICE	(5 << 16)
 #define MPU_RASR_ATTR_SCB_SH_WT		(6 << 16)
 #define MPU_RASR_ATTR_SCB_SH_WB		(7 << 16)
+/** TEX=1 C=0 B=0: normal memory, not cacheable */
+#define MPU_RASR_ATTR_TEX_NORMAL_NC	((1 << 19) | (0 << 16))
 
 /* --- MPU functions ------------------------------------------------------- */
 
@@ -105,6 +117,4 @@ BEGIN_DECLS
 
 END_DECLS
 
-#endif /* CM0_PLUS */
-
 #endif
@@ -61,4 +61,13 @@ typedef struct {
 	vector_table_entry_t irq[NVIC_IRQ_COUNT];
 } vector_table_t;
 
+BEGIN_DECLS
+
+/** Application hook run by reset_handler after the platform pre_main() and
+ * before main(), with .data and .bss already set up. The default does
+ * nothing; define it to configure the core (e.g. the MPU) before main(). */
+void pre_main_hook(void);
+
+END_DECLS
+
 #endif
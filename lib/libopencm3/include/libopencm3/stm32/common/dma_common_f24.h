@@ -563,6 +563,34 @@ being at the same relative location */
 
 /* [31:8]: Reserved */
 
+/* --- Stream descriptor --------------------------------------------------- */
+
+/** @brief DMA stream transfer descriptor
+
+Everything @ref dma_configure needs to program a stream in one pass. Members
+take the DMA_SxCR / DMA_SxFCR values listed with them, 0 is the reset default.
+*/
+struct dma_stream_desc {
+	uint32_t channel;	/**< @ref dma_ch_sel */
+	uint32_t direction;	/**< @ref dma_st_dir */
+	uint32_t priority;	/**< @ref dma_st_pri */
+	uint32_t periph_size;	/**< @ref dma_st_perwidth */
+	uint32_t mem_size;	/**< @ref dma_st_memwidth */
+	uint32_t periph_burst;	/**< @ref dma_pburst */
+	uint32_t mem_burst;	/**< @ref dma_mburst */
+	/** DMA_SxCR_MINC, PINC, PINCOS, CIRC, DBM, CT, PFCTRL */
+	uint32_t mode;
+	/** DMA_SxCR_TCIE, HTIE, TEIE, DMEIE */
+	uint32_t interrupts;
+	/** 0 for direct mode, else DMA_SxFCR_DMDIS | @ref dma_fifo_thresh
+	 * [| DMA_SxFCR_FEIE] */
+	uint32_t fifo;
+	uint32_t periph_address;
+	uint32_t mem_address;
+	uint32_t mem_address_1;	/**< second buffer with DMA_SxCR_DBM */
+	uint16_t number;	/**< data items (peripheral size units) */
+};
+
 /* --- Function prototypes ------------------------------------------------- */
 
 BEGIN_DECLS
@@ -616,6 +644,10 @@ void dma_set_peripheral_address(uint32_t dma, uint8_t stream, uint32_t address);
 void dma_set_memory_address(uint32_t dma, uint8_t stream, uint32_t address);
 void dma_set_memory_address_1(uint32_t dma, uint8_t stream, uint32_t address);
 void dma_set_number_of_data(uint32_t dma, uint8_t stream, uint16_t number);
+void dma_configure(uint32_t dma, uint8_t stream,
+		   const struct dma_stream_desc *desc);
+void dma_rearm(uint32_t dma, uint8_t stream, uint32_t mem_address,
+	       uint16_t number);
 
 END_DECLS
 /**@}*/
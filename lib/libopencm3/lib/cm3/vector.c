@@ -84,6 +84,8 @@ void WEAK __attribute__ ((naked)) reset_handler(void)
 
 	/* might be provided by platform specific vector.c */
 	pre_main();
+	/* might be provided by the application */
+	pre_main_hook();
 
 	/* Call the application's entry point. */
 	main();
@@ -110,6 +112,7 @@ void null_handler(void)
 #pragma weak sv_call_handler = null_handler
 #pragma weak pend_sv_handler = null_handler
 #pragma weak sys_tick_handler = null_handler
+#pragma weak pre_main_hook = null_handler
 
 /* Those are defined only on CM3 or CM4 */
 #if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
@@ -790,5 +790,67 @@ void dma_set_number_of_data(uint32_t dma, uint8_t stream, uint16_t number)
 {
 	DMA_SNDTR(dma, stream) = number;
 }
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Stream Configure from a Descriptor
+
+The stream is stopped and all its registers are computed from the descriptor
+and written once each, instead of one read-modify-write of DMA_SxCR per
+setting. Pending interrupt flags of the stream are cleared. The stream is left
+disabled, start it with @ref dma_enable_stream.
+
+@param[in] dma unsigned int32. DMA controller base address: DMA1 or DMA2
+@param[in] stream unsigned int8. Stream number: @ref dma_st_number
+@param[in] desc Transfer descriptor.
+*/
+
+void dma_configure(uint32_t dma, uint8_t stream,
+		   const struct dma_stream_desc *desc)
+{
+	uint32_t scr = desc->channel | desc->direction | desc->priority |
+		       desc->periph_size | desc->mem_size |
+		       desc->periph_burst | desc->mem_burst |
+		       desc->mode | desc->interrupts;
+
+	/* EN reads back 1 until the current transfer is really over. */
+	DMA_SCR(dma, stream) = 0;
+	while (DMA_SCR(dma, stream) & DMA_SxCR_EN);
+
+	dma_clear_interrupt_flags(dma, stream, DMA_ISR_FLAGS);
+	DMA_SPAR(dma, stream) = (uint32_t *) desc->periph_address;
+	DMA_SM0AR(dma, stream) = (uint32_t *) desc->mem_address;
+	DMA_SM1AR(dma, stream) = (uint32_t *) desc->mem_address_1;
+	DMA_SNDTR(dma, stream) = desc->number;
+	DMA_SFCR(dma, stream) = desc->fifo;
+	DMA_SCR(dma, stream) = scr & ~DMA_SxCR_EN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Stream Restart with a new Buffer
+
+Fast path for a stream already set up by @ref dma_configure whose previous
+transfer has completed (the hardware clears EN at the end of a transfer): the
+interrupt flags are cleared, memory address 0 and the count are replaced and
+the stream is enabled. Nothing happens if the stream is still enabled.
+
+@param[in] dma unsigned int32. DMA controller base address: DMA1 or DMA2
+@param[in] stream unsigned int8. Stream number: @ref dma_st_number
+@param[in] mem_address unsigned int32. Memory address 0.
+@param[in] number unsigned int16. Number of data items.
+*/
+
+void dma_rearm(uint32_t dma, uint8_t stream, uint32_t mem_address,
+	       uint16_t number)
+{
+	uint32_t scr = DMA_SCR(dma, stream);
+
+	if (scr & DMA_SxCR_EN) {
+		return;
+	}
+	dma_clear_interrupt_flags(dma, stream, DMA_ISR_FLAGS);
+	DMA_SM0AR(dma, stream) = (uint32_t *) mem_address;
+	DMA_SNDTR(dma, stream) = number;
+	DMA_SCR(dma, stream) = scr | DMA_SxCR_EN;
+}
 /**@}*/
 
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Host side reference of the COBS + CRC-32 framing in src/cobs.c.
+
+Frame: COBS(payload | CRC-32/MPEG-2(payload) big-endian) 0x00
+
+    scripts/cobs_frame.py encode 01020300ff        # hex payload -> frame
+    scripts/cobs_frame.py decode capture.bin       # raw serial capture
+    scripts/cobs_frame.py check                    # reference self-check
+
+The functions are meant to be imported by host side tools as well.
+"""
+
+import argparse
+import random
+import sys
+
+CRC_POLY = 0x04C11DB7
+CRC_INIT = 0xFFFFFFFF
+CRC_BYTES = 4
+BLOCK_MAX = 0xFF
+
+
+def crc32_mpeg2(data, crc=CRC_INIT):
+    """CRC-32/MPEG-2 as computed by src/crc_hw.c."""
+    for b in data:
+        crc ^= b << 24
+        for _ in range(8):
+            crc = (crc << 1) ^ CRC_POLY if crc & 0x80000000 else crc << 1
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def cobs_stuff(data):
+    """Plain COBS, a trailing code byte closes the last block."""
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+            if code != BLOCK_MAX:
+                continue
+        out[code_at] = code
+        code_at, code = len(out), 1
+        out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def cobs_unstuff(data):
+    """Inverse of cobs_stuff(), raise ValueError on a malformed block."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0:
+            raise ValueError("zero inside a frame")
+        block = data[i + 1:i + code]
+        if len(block) != code - 1 or 0 in block:
+            raise ValueError("truncated block")
+        out += block
+        i += code
+        if code != BLOCK_MAX and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode(payload):
+    """Payload -> frame bytes, delimiter included."""
+    crc = crc32_mpeg2(payload)
+    return cobs_stuff(bytes(payload) + crc.to_bytes(CRC_BYTES, "big")) + b"\0"
+
+
+def decode(stream):
+    """Split a byte stream on delimiters, yield (payload, error or None)."""
+    for chunk in bytes(stream).split(b"\0"):
+        if not chunk:
+            continue
+        try:
+            data = cobs_unstuff(chunk)
+        except ValueError as e:
+            yield None, str(e)
+            continue
+        if len(data) < CRC_BYTES:
+            yield None, "runt"
+        elif crc32_mpeg2(data) != 0:
+            yield None, "crc"
+        else:
+            yield data[:-CRC_BYTES], None
+
+
+def check():
+    """Known answers plus random round trips, return the failure count."""
+    fails = 0
+    if crc32_mpeg2(b"123456789") != 0x0376E6E7:
+        print("crc32_mpeg2 check value mismatch")
+        fails += 1
+    vectors = [
+        (b"", b"\x01"),
+        (b"\x00", b"\x01\x01"),
+        (b"\x11\x22\x00\x33", b"\x03\x11\x22\x02\x33"),
+        (bytes(range(1, 255)), b"\xff" + bytes(range(1, 255)) + b"\x01"),
+    ]
+    for data, stuffed in vectors:
+        if cobs_stuff(data) != stuffed or cobs_unstuff(stuffed) != data:
+            print("COBS vector failed: %s" % data[:8].hex())
+            fails += 1
+
+    rnd = random.Random(1)
+    for n in range(2000):
+        size = rnd.choice((0, 1, 3, 4, 253, 254, 255, 508, rnd.randrange(600)))
+        payload = bytes(rnd.choice((0, rnd.randrange(256)))
+                        for _ in range(size))
+        got = list(decode(b"\0" + encode(payload)))
+        if got != [(payload, None)]:
+            print("round trip failed, %u bytes" % size)
+            fails += 1
+    return fails
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("encode", help="hex payload to a hex frame")
+    p.add_argument("payload")
+    p = sub.add_parser("decode", help="print the frames of a raw capture")
+    p.add_argument("capture")
+    sub.add_parser("check", help="run the reference self-check")
+    args = ap.parse_args()
+
+    if args.cmd == "encode":
+        print(encode(bytes.fromhex(args.payload)).hex())
+    elif args.cmd == "decode":
+        with open(args.capture, "rb") as f:
+            data = f.read()
+        for i, (payload, err) in enumerate(decode(data)):
+            if err:
+                print("#%-4u bad frame: %s" % (i, err))
+            else:
+                print("#%-4u %4u B  %s" % (i, len(payload), payload.hex()))
+    else:
+        fails = check()
+        print("%s (%u failures)" % ("FAIL" if fails else "ok", fails))
+        sys.exit(1 if fails else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,60 @@
+"""Address -> symbol lookup for the host tools in this directory.
+
+Uses the toolchain nm, so nothing beyond the standard library is needed.
+"""
+
+import bisect
+import subprocess
+
+DEFAULT_NM = "arm-none-eabi-nm"
+DEFAULT_ADDR2LINE = "arm-none-eabi-addr2line"
+
+
+class Symbolizer(object):
+    """Maps code addresses of an ELF to 'function+offset' strings."""
+
+    def __init__(self, elf, nm=DEFAULT_NM, addr2line=DEFAULT_ADDR2LINE):
+        self.elf = elf
+        self.addr2line = addr2line
+        out = subprocess.check_output([nm, "-n", "--defined-only", elf],
+                                      universal_newlines=True)
+        syms = []
+        for line in out.splitlines():
+            parts = line.split()
+            if len(parts) != 3 or parts[1] not in "tTwW":
+                continue
+            syms.append((int(parts[0], 16) & ~1, parts[2]))
+        syms.sort()
+        self.syms = syms
+        self.addrs = [a for a, _ in syms]
+
+    def lookup(self, addr):
+        """Return (name, offset) of the function containing addr."""
+        i = bisect.bisect_right(self.addrs, addr & ~1) - 1
+        if i < 0:
+            return None, addr
+        base, name = self.syms[i]
+        return name, (addr & ~1) - base
+
+    def function(self, addr):
+        name, _ = self.lookup(addr)
+        return name if name else "0x%08x" % addr
+
+    def __call__(self, addr):
+        name, off = self.lookup(addr)
+        if name is None:
+            return "0x%08x" % addr
+        return name if off == 0 else "%s+0x%x" % (name, off)
+
+    def source(self, addr):
+        """Return 'file:line' for addr, None when addr2line cannot tell."""
+        try:
+            out = subprocess.check_output(
+                [self.addr2line, "-e", self.elf, "0x%x" % (addr & ~1)],
+                universal_newlines=True, stderr=subprocess.DEVNULL)
+        except (OSError, subprocess.CalledProcessError):
+            return None
+        loc = out.strip().splitlines()[0] if out.strip() else ""
+        if not loc or loc.startswith("??"):
+            return None
+        return loc
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Decode the fault record left in backup SRAM by src/fault_dump.c.
+
+Dump the 4 KB BKPSRAM after the reset and decode it against the same ELF:
+
+    (gdb) dump binary memory fault.bin 0x40024000 0x40025000
+    scripts/fault_decode.py bin/project.elf fault.bin
+
+Prints the exception, the decoded CFSR/HFSR bits, the fault address when it
+is valid, the registers at the fault and a heuristic backtrace built from
+the code addresses found in the saved stack.
+"""
+
+import argparse
+import struct
+import sys
+
+from elfsym import DEFAULT_ADDR2LINE, DEFAULT_NM, Symbolizer
+
+# S_faultDump in include/fault_dump.h
+FAULT_MAGIC = 0x31544C46
+FAULT_VERSION = 1
+FIELDS = ("magic", "version", "size", "checksum", "count", "acked",
+          "exc_number", "exc_return")
+FIELDS_TAIL = ("sp", "msp", "psp", "cfsr", "hfsr", "mmfar", "bfar", "shcsr",
+               "cycle", "tick", "flags", "stack_words")
+FRAME_WORDS = 8
+REGS_WORDS = 8
+# words before stack[]: header, frame, r4-r11, tail (36)
+HEADER_WORDS = len(FIELDS) + FRAME_WORDS + REGS_WORDS + len(FIELDS_TAIL)
+
+FRAME_VALID = 1 << 0
+FRAME_FPU = 1 << 1
+FRAME_PSP = 1 << 2
+
+FLASH_START = 0x08000000
+FLASH_END = 0x08100000
+
+EXCEPTIONS = {3: "HardFault", 4: "MemManage", 5: "BusFault",
+              6: "UsageFault"}
+
+CFSR_BITS = [
+    # MMFSR
+    (0, "IACCVIOL", "instruction fetch from XN / no-access region"),
+    (1, "DACCVIOL", "data access violation (MPU)"),
+    (3, "MUNSTKERR", "MemManage on exception return unstacking"),
+    (4, "MSTKERR", "MemManage on exception entry stacking"),
+    (5, "MLSPERR", "MemManage during lazy FP state save"),
+    (7, "MMARVALID", "MMFAR holds the faulting address"),
+    # BFSR
+    (8, "IBUSERR", "bus error on instruction fetch"),
+    (9, "PRECISERR", "precise data bus error"),
+    (10, "IMPRECISERR", "imprecise data bus error (PC is not exact)"),
+    (11, "UNSTKERR", "bus error on exception return unstacking"),
+    (12, "STKERR", "bus error on exception entry stacking"),
+    (13, "LSPERR", "bus error during lazy FP state save"),
+    (15, "BFARVALID", "BFAR holds the faulting address"),
+    # UFSR
+    (16, "UNDEFINSTR", "undefined instruction"),
+    (17, "INVSTATE", "invalid EPSR state (Thumb bit cleared)"),
+    (18, "INVPC", "invalid EXC_RETURN / PC load"),
+    (19, "NOCP", "coprocessor access (FPU disabled?)"),
+    (24, "UNALIGNED", "unaligned access"),
+    (25, "DIVBYZERO", "divide by zero"),
+]
+
+HFSR_BITS = [
+    (1, "VECTTBL", "bus fault on vector table read"),
+    (30, "FORCED", "escalated configurable fault - see CFSR"),
+    (31, "DEBUGEVT", "debug event"),
+]
+
+FRAME_NAMES = ("r0", "r1", "r2", "r3", "r12", "lr", "pc", "xpsr")
+
+
+def parse(data):
+    """Unpack a BKPSRAM image into a dict, raise ValueError when invalid."""
+    if len(data) < HEADER_WORDS * 4:
+        raise ValueError("dump too short (%u bytes)" % len(data))
+    words = struct.unpack_from("<%uI" % HEADER_WORDS, data)
+    o = len(FIELDS)
+    rec = dict(zip(FIELDS, words[0:o]))
+    rec["frame"] = list(words[o:o + FRAME_WORDS])
+    o += FRAME_WORDS
+    rec["r4_r11"] = list(words[o:o + REGS_WORDS])
+    o += REGS_WORDS
+    rec.update(zip(FIELDS_TAIL, words[o:HEADER_WORDS]))
+
+    if rec["magic"] != FAULT_MAGIC:
+        raise ValueError("no fault record (magic 0x%08x)" % rec["magic"])
+    if rec["version"] != FAULT_VERSION:
+        raise ValueError("record version %u, decoder knows %u" % (
+            rec["version"], FAULT_VERSION))
+    size = rec["size"]
+    if size % 4 or size < HEADER_WORDS * 4 or size > len(data):
+        raise ValueError("bad record size %u" % size)
+
+    all_words = struct.unpack_from("<%uI" % (size // 4), data)
+    total = sum(w for i, w in enumerate(all_words) if i != 3)
+    if (~total) & 0xFFFFFFFF != rec["checksum"]:
+        raise ValueError("checksum mismatch - record is torn")
+
+    n = min(rec["stack_words"], size // 4 - HEADER_WORDS)
+    rec["stack"] = list(all_words[HEADER_WORDS:HEADER_WORDS + n])
+    return rec
+
+
+def bits(value, table):
+    return [(name, text) for bit, name, text in table if value & (1 << bit)]
+
+
+def in_flash(addr):
+    return FLASH_START <= addr < FLASH_END
+
+
+def describe(addr, sym):
+    s = sym(addr)
+    src = sym.source(addr)
+    return "%s (%s)" % (s, src) if src else s
+
+
+def report(rec, sym, out=sys.stdout):
+    exc = rec["exc_number"]
+    print("=== %s (exception %u), fault #%u since power-up%s" % (
+        EXCEPTIONS.get(exc, "exception"), exc, rec["count"],
+        ", acknowledged" if rec["acked"] else ""), file=out)
+    print("tick %u, cycle %u, EXC_RETURN 0x%08x, %s stack%s" % (
+        rec["tick"], rec["cycle"], rec["exc_return"],
+        "process" if rec["flags"] & FRAME_PSP else "main",
+        ", FPU frame" if rec["flags"] & FRAME_FPU else ""), file=out)
+
+    print("\n=== CFSR 0x%08x  HFSR 0x%08x  SHCSR 0x%08x" % (
+        rec["cfsr"], rec["hfsr"], rec["shcsr"]), file=out)
+    for name, text in bits(rec["hfsr"], HFSR_BITS):
+        print("  HFSR.%-12s %s" % (name, text), file=out)
+    for name, text in bits(rec["cfsr"], CFSR_BITS):
+        print("  CFSR.%-12s %s" % (name, text), file=out)
+    if rec["cfsr"] & (1 << 7):
+        print("  MMFAR = 0x%08x" % rec["mmfar"], file=out)
+    if rec["cfsr"] & (1 << 15):
+        print("  BFAR  = 0x%08x" % rec["bfar"], file=out)
+
+    print("\n=== registers", file=out)
+    if not rec["flags"] & FRAME_VALID:
+        print("  no stacked frame at 0x%08x - stack overflow?" % rec["sp"],
+              file=out)
+    else:
+        frame = rec["frame"]
+        print("  pc   0x%08x  %s" % (frame[6], describe(frame[6], sym)),
+              file=out)
+        print("  lr   0x%08x  %s" % (frame[5], describe(frame[5], sym)),
+              file=out)
+        for i in (0, 1, 2, 3, 4, 7):
+            print("  %-4s 0x%08x" % (FRAME_NAMES[i], frame[i]), file=out)
+    for i, v in enumerate(rec["r4_r11"]):
+        print("  %-4s 0x%08x" % ("r%u" % (i + 4), v), file=out)
+    print("  sp   0x%08x  (msp 0x%08x, psp 0x%08x)" % (
+        rec["sp"], rec["msp"], rec["psp"]), file=out)
+
+    print("\n=== backtrace (heuristic, %u stack words)" % len(rec["stack"]),
+          file=out)
+    if rec["flags"] & FRAME_VALID:
+        print("  #0  0x%08x  %s" % (rec["frame"][6], sym(rec["frame"][6])),
+              file=out)
+    depth = 1
+    for i, w in enumerate(rec["stack"]):
+        # pushed return addresses have the Thumb bit set
+        if not (w & 1 and in_flash(w)):
+            continue
+        name, _ = sym.lookup(w)
+        if name is None:
+            continue
+        print("  #%-2u 0x%08x  %-32s [sp+0x%x]" % (
+            depth, w & ~1, describe(w, sym), i * 4), file=out)
+        depth += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf", help="firmware that faulted")
+    ap.add_argument("dump", help="binary dump of BKPSRAM (0x40024000)")
+    ap.add_argument("--nm", default=DEFAULT_NM,
+                    help="nm used for symbolization (default: %(default)s)")
+    ap.add_argument("--addr2line", default=DEFAULT_ADDR2LINE,
+                    help="addr2line for file:line (default: %(default)s)")
+    args = ap.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    try:
+        rec = parse(data)
+    except ValueError as e:
+        sys.exit("fault_decode: %s" % e)
+    report(rec, Symbolizer(args.elf, args.nm, args.addr2line))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Print the cycle profile collected by src/profiler.c.
+
+Dump the table from the running target with gdb:
+
+    (gdb) dump binary value prof.bin prof_table
+
+and symbolize it against the ELF that was flashed:
+
+    scripts/prof_report.py bin/project.elf prof.bin
+
+The binary layout mirrors S_profTable / S_profEntry in include/profiler.h.
+"""
+
+import argparse
+import struct
+import sys
+
+from elfsym import DEFAULT_NM, Symbolizer
+
+PROF_MAGIC = 0x464F5250
+PROF_VERSION = 1
+
+HEADER = struct.Struct("<8I")
+ENTRY = struct.Struct("<IIQQ")
+
+
+def parse_table(data):
+    (magic, version, size, cpu_hz, enabled,
+     lost_full, lost_depth, max_depth) = HEADER.unpack_from(data, 0)
+    if magic != PROF_MAGIC:
+        sys.exit("bad magic 0x%08x - not a prof_table dump" % magic)
+    if version != PROF_VERSION:
+        sys.exit("table version %u, this tool knows %u" % (version,
+                                                           PROF_VERSION))
+    need = HEADER.size + size * ENTRY.size
+    if len(data) < need:
+        sys.exit("dump truncated: %u of %u bytes" % (len(data), need))
+
+    entries = []
+    for i in range(size):
+        fn, calls, incl, excl = ENTRY.unpack_from(
+            data, HEADER.size + i * ENTRY.size)
+        if fn and calls:
+            entries.append((fn, calls, incl, excl))
+    info = {"cpu_hz": cpu_hz, "enabled": enabled, "lost_full": lost_full,
+            "lost_depth": lost_depth, "max_depth": max_depth}
+    return info, entries
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf", help="firmware the dump was taken from")
+    ap.add_argument("dump", help="binary dump of prof_table")
+    ap.add_argument("--nm", default=DEFAULT_NM,
+                    help="nm used for symbolization (default: %(default)s)")
+    ap.add_argument("--sort", choices=("excl", "incl", "calls"),
+                    default="excl", help="sort key (default: %(default)s)")
+    ap.add_argument("-n", "--top", type=int, default=0,
+                    help="print only the first N rows")
+    args = ap.parse_args()
+
+    with open(args.dump, "rb") as f:
+        info, entries = parse_table(f.read())
+    sym = Symbolizer(args.elf, args.nm)
+
+    key = {"excl": 3, "incl": 2, "calls": 1}[args.sort]
+    entries.sort(key=lambda e: e[key], reverse=True)
+    # percentages and the total cover every function, not only the rows shown
+    total = sum(e[3] for e in entries) or 1
+    if args.top:
+        entries = entries[:args.top]
+    us = 1e6 / info["cpu_hz"] if info["cpu_hz"] else 0.0
+
+    print("%7s %10s %14s %14s %10s  %s" % ("excl%", "calls", "incl cyc",
+                                           "excl cyc", "excl/call",
+                                           "function"))
+    for fn, calls, incl, excl in entries:
+        print("%6.2f%% %10u %14u %14u %10.1f  %s" % (
+            100.0 * excl / total, calls, incl, excl, float(excl) / calls,
+            sym(fn)))
+
+    if us:
+        print("\ntotal exclusive: %u cycles = %.1f us @ %u Hz" % (
+            total, total * us, info["cpu_hz"]))
+    if info["lost_full"] or info["lost_depth"]:
+        print("lost calls: %u (table full), %u (deeper than stack)" % (
+            info["lost_full"], info["lost_depth"]))
+    print("max call depth: %u" % info["max_depth"])
+
+
+if __name__ == "__main__":
+    main()
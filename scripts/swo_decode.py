@@ -0,0 +1,280 @@
+#!/usr/bin/env python3
+"""Decode a captured SWO (ITM/DWT) byte stream produced by src/swo_trace.c.
+
+Prints a flat profile from the DWT periodic PC samples and a timeline of
+exception entry/exit/return events with per-IRQ statistics:
+
+    scripts/swo_decode.py bin/project.elf swo.bin
+
+The stream must be raw ITM packets (TPIU formatter bypassed), which is what
+INIT_swoTrace() configures. Local timestamps are expected in core cycles.
+"""
+
+import argparse
+import collections
+import json
+import os
+import sys
+
+from elfsym import DEFAULT_NM, Symbolizer
+
+IRQ_JSON = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                        "lib", "libopencm3", "include", "libopencm3",
+                        "stm32", "f4", "irq.json")
+
+CORE_EXCEPTIONS = {
+    1: "reset", 2: "nmi", 3: "hard_fault", 4: "mem_manage", 5: "bus_fault",
+    6: "usage_fault", 11: "sv_call", 12: "debug_monitor", 14: "pend_sv",
+    15: "sys_tick",
+}
+
+EXC_FUNCTION = {1: "enter", 2: "exit", 3: "return"}
+
+# DWT hardware source packet discriminators
+HW_EVENT_COUNTER = 0
+HW_EXCEPTION = 1
+HW_PC_SAMPLE = 2
+
+# stimulus port used by swo_mark() - SWO_PORT_MARK in swo_trace.h
+PORT_MARK = 1
+
+
+class Packet(object):
+    __slots__ = ("kind", "a", "b", "offset", "time")
+
+    def __init__(self, kind, offset, a=None, b=None):
+        self.kind = kind
+        self.a = a
+        self.b = b
+        self.offset = offset
+        self.time = None
+
+
+def _continuation(data, i, maxlen):
+    """Read up to maxlen 7-bit continuation bytes starting at data[i]."""
+    value = 0
+    shift = 0
+    n = 0
+    while i < len(data) and n < maxlen:
+        c = data[i]
+        value |= (c & 0x7F) << shift
+        shift += 7
+        i += 1
+        n += 1
+        if not c & 0x80:
+            break
+    return value, i
+
+
+def parse(data):
+    """Split a raw ITM byte stream into a list of Packet."""
+    packets = []
+    i = 0
+    n = len(data)
+    while i < n:
+        b = data[i]
+        start = i
+        i += 1
+
+        if b == 0x00:
+            # synchronization: >= 47 zero bits followed by a one bit
+            while i < n and data[i] == 0x00:
+                i += 1
+            if i < n and data[i] == 0x80:
+                i += 1
+                packets.append(Packet("sync", start))
+            continue
+
+        if b == 0x70:
+            packets.append(Packet("overflow", start))
+            continue
+
+        if b & 0x0F == 0x00:
+            if not b & 0x80:
+                # local timestamp format 2 - the value is in the header
+                packets.append(Packet("lts", start, (b >> 4) & 0x07, 0))
+            elif b & 0xC0 == 0xC0:
+                # local timestamp format 1, TC in bits 5:4
+                value, i = _continuation(data, i, 4)
+                packets.append(Packet("lts", start, value, (b >> 4) & 0x03))
+            else:
+                packets.append(Packet("garbage", start, b))
+            continue
+
+        if b in (0x94, 0xB4):
+            # global timestamps are not enabled, but skip them cleanly
+            if b & 0x80:
+                _, i = _continuation(data, i, 4)
+            continue
+
+        if b & 0x0B == 0x08:
+            # extension packet (stimulus port page)
+            value = (b >> 4) & 0x07
+            if b & 0x80:
+                ext, i = _continuation(data, i, 4)
+                value |= ext << 3
+            packets.append(Packet("ext", start, value))
+            continue
+
+        size = (0, 1, 2, 4)[b & 0x03]
+        if not size:
+            packets.append(Packet("garbage", start, b))
+            continue
+        if i + size > n:
+            break
+        payload = int.from_bytes(bytes(data[i:i + size]), "little")
+        i += size
+        ident = b >> 3
+        if not b & 0x04:
+            packets.append(Packet("sw", start, ident, payload))
+        elif ident == HW_EXCEPTION:
+            packets.append(Packet("exc", start, payload & 0x1FF,
+                                  (payload >> 12) & 0x03))
+        elif ident == HW_PC_SAMPLE:
+            if size == 4:
+                packets.append(Packet("pc", start, payload))
+            else:
+                packets.append(Packet("sleep", start))
+        elif ident == HW_EVENT_COUNTER:
+            packets.append(Packet("evcnt", start, payload))
+        else:
+            packets.append(Packet("data", start, ident, payload))
+    return packets
+
+
+def stamp(packets):
+    """Assign absolute cycle times - an LTS applies to the packets before it."""
+    now = 0
+    pending = []
+    for p in packets:
+        if p.kind == "lts":
+            now += p.a
+            for q in pending:
+                q.time = now
+            pending = []
+        elif p.kind == "sync":
+            continue
+        else:
+            pending.append(p)
+    for q in pending:
+        q.time = now
+    return now
+
+
+def exception_name(num, irqs):
+    if num >= 16:
+        n = num - 16
+        return "%s_isr" % irqs[n] if n < len(irqs) else "irq%d" % n
+    return CORE_EXCEPTIONS.get(num, "exception%d" % num)
+
+
+def load_irqs(path):
+    try:
+        with open(path) as f:
+            return json.load(f)["irqs"]
+    except (IOError, OSError, ValueError, KeyError):
+        return []
+
+
+def flat_profile(packets, sym, top):
+    counts = collections.Counter()
+    for p in packets:
+        if p.kind == "pc":
+            counts[sym.function(p.a)] += 1
+        elif p.kind == "sleep":
+            counts["<sleep>"] += 1
+    total = sum(counts.values())
+    print("=== flat profile: %u PC samples" % total)
+    if not total:
+        return
+    rows = counts.most_common(top or None)
+    for name, cnt in rows:
+        print("%6.2f%% %8u  %s" % (100.0 * cnt / total, cnt, name))
+
+
+def timeline(packets, irqs, cpu_hz, max_events):
+    print("\n=== exception timeline")
+    print("%14s %12s  %-6s %s" % ("cycle", "us", "event", "exception"))
+    stack = []
+    stats = collections.OrderedDict()
+    shown = 0
+    for p in packets:
+        if p.kind == "sw" and p.a == PORT_MARK:
+            line = ("mark", "0x%08x" % p.b)
+        elif p.kind == "exc":
+            name = exception_name(p.a, irqs)
+            func = EXC_FUNCTION.get(p.b, "?%d" % p.b)
+            line = (func, name)
+            if func == "enter":
+                stack.append((p.a, p.time))
+            elif func == "exit":
+                # pop to the matching entry, tolerating lost packets
+                for k in range(len(stack) - 1, -1, -1):
+                    if stack[k][0] == p.a:
+                        dur = p.time - stack[k][1]
+                        st = stats.setdefault(name, [0, 0, 0, None])
+                        st[0] += 1
+                        st[1] += dur
+                        st[2] = max(st[2], dur)
+                        st[3] = dur if st[3] is None else min(st[3], dur)
+                        del stack[k:]
+                        break
+        elif p.kind == "overflow":
+            line = ("OVF", "ITM FIFO overflow - packets lost")
+        else:
+            continue
+        if max_events and shown >= max_events:
+            continue
+        shown += 1
+        print("%14u %12.3f  %-6s %s" % (p.time, p.time * 1e6 / cpu_hz,
+                                        line[0], line[1]))
+
+    print("\n=== exception statistics (entry to exit, cycles)")
+    print("%-28s %8s %10s %8s %8s" % ("exception", "count", "avg", "min",
+                                      "max"))
+    for name, (cnt, tot, mx, mn) in stats.items():
+        print("%-28s %8u %10.1f %8u %8u" % (name, cnt, float(tot) / cnt,
+                                            mn, mx))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf", help="firmware running during the capture")
+    ap.add_argument("stream", help="raw SWO capture file")
+    ap.add_argument("--nm", default=DEFAULT_NM,
+                    help="nm used for symbolization (default: %(default)s)")
+    ap.add_argument("--cpu-hz", type=float, default=168e6,
+                    help="core clock (default: %(default)d)")
+    ap.add_argument("--irq-json", default=IRQ_JSON,
+                    help="IRQ name list (default: libopencm3 F4 irq.json)")
+    ap.add_argument("-n", "--top", type=int, default=30,
+                    help="rows of the flat profile, 0 = all")
+    ap.add_argument("-e", "--events", type=int, default=200,
+                    help="timeline events printed, 0 = all")
+    args = ap.parse_args()
+
+    with open(args.stream, "rb") as f:
+        data = bytearray(f.read())
+    packets = parse(data)
+    end = stamp(packets)
+    irqs = load_irqs(args.irq_json)
+    sym = Symbolizer(args.elf, args.nm)
+
+    kinds = collections.Counter(p.kind for p in packets)
+    print("%u bytes, %u packets, %u cycles (%.3f ms)" % (
+        len(data), len(packets), end, end * 1e3 / args.cpu_hz))
+    if kinds["overflow"] or kinds["garbage"]:
+        print("warning: %u overflow, %u undecodable packets" % (
+            kinds["overflow"], kinds["garbage"]), file=sys.stderr)
+
+    flat_profile(packets, sym, args.top)
+    timeline(packets, irqs, args.cpu_hz, args.events)
+
+    text = bytes(p.b & 0xFF for p in packets if p.kind == "sw" and p.a == 0)
+    if text:
+        print("\n=== stimulus port 0")
+        print(text.decode("latin-1"))
+
+
+if __name__ == "__main__":
+    main()
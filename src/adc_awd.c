@@ -0,0 +1,255 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Analog watchdog triggered ADC capture - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "adc_awd.h"
+
+#include <libopencm3/stm32/adc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define ADC_AWD_FLAGS       (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void adc_awd_halt(S_adcAwd *a);
+static void adc_awd_freeze(S_adcAwd *a);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// conversions and DMA off, NDTR keeps the last ring position
+static void adc_awd_halt(S_adcAwd *a)
+{
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+
+    adc_disable_awd_interrupt(a->adc);
+    adc_set_single_conversion_mode(a->adc);
+    // without the DMA bit a late result does not raise OVR
+    adc_disable_dma(a->adc);
+    DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+    dma_clear_interrupt_flags(dma, stream, ADC_AWD_FLAGS);
+}
+
+static void adc_awd_freeze(S_adcAwd *a)
+{
+    uint32_t end, written;
+
+    adc_awd_halt(a);
+    end = a->n - DMA_SNDTR(a->s.dma, a->s.stream);
+    // samples from the trigger one on
+    written = (end + a->n - a->trig) % a->n;
+    if( written < a->post || written + a->pre > a->n )
+    {
+        a->stats.lost++;
+        adc_awd_arm(a);
+        return;
+    }
+    a->state = ADC_AWD_FROZEN;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_adcAwd(S_adcAwd *a, uint32_t adc, const S_dmaStream *s,
+                 uint8_t channel, uint16_t low, uint16_t high,
+                 uint16_t *ring, uint32_t n, uint32_t pre, uint32_t post)
+{
+    uint8_t ch[1];
+
+    a->adc = adc;
+    a->s = *s;
+    a->ring = ring;
+    a->n = n;
+    a->pre = pre;
+    a->post = post;
+    a->state = ADC_AWD_IDLE;
+    a->seq = 0;
+    a->stats = (S_adcAwdStats){0};
+    ch[0] = channel;
+
+    adc_off(adc);
+    adc_set_resolution(adc, ADC_CR1_RES_12BIT);
+    adc_set_right_aligned(adc);
+    adc_disable_scan_mode(adc);
+    adc_set_sample_time(adc, channel, ADC_AWD_SMP);
+    adc_set_regular_sequence(adc, 1, ch);
+    adc_enable_analog_watchdog_on_selected_channel(adc, channel);
+    adc_set_watchdog_low_threshold(adc, low);
+    adc_set_watchdog_high_threshold(adc, high);
+    adc_enable_analog_watchdog_regular(adc);
+    adc_enable_overrun_interrupt(adc);
+    adc_power_on(adc);
+
+    dwt_enable_cycle_counter();
+    nvic_set_priority(NVIC_ADC_IRQ, ADC_AWD_PRIORITY);
+    nvic_enable_irq(NVIC_ADC_IRQ);
+    nvic_set_priority(s->irqn, ADC_AWD_PRIORITY);
+    nvic_enable_irq(s->irqn);
+}
+
+void adc_awd_arm(S_adcAwd *a)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+
+    adc_awd_halt(a);
+    ADC_SR(a->adc) = ~ADC_SR_AWD;
+    adc_clear_overrun_flag(a->adc);
+
+    d.channel = a->s.channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_16BIT;
+    d.mem_size = DMA_SxCR_MSIZE_16BIT;
+    d.mode = DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    d.interrupts = DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.periph_address = (uint32_t)&ADC_DR(a->adc);
+    d.mem_address = (uint32_t)a->ring;
+    d.number = a->n;
+    dma_configure(dma, stream, &d);
+    dma_enable_stream(dma, stream);
+
+    a->state = ADC_AWD_ARMING;
+    ADC_CR2(a->adc) |= ADC_CR2_DDS;
+    adc_enable_dma(a->adc);
+    adc_set_continuous_conversion_mode(a->adc);
+    adc_start_conversion_regular(a->adc);
+}
+
+void adc_awd_stop(S_adcAwd *a)
+{
+    a->state = ADC_AWD_IDLE;
+    adc_awd_halt(a);
+}
+
+uint8_t adc_awd_read(S_adcAwd *a, S_adcAwdEvent *ev, uint16_t *dst)
+{
+    uint32_t i, k, len;
+
+    if( a->state != ADC_AWD_FROZEN ) return 0;
+
+    len = a->pre + a->post;
+    i = (a->trig + a->n - a->pre) % a->n;
+    for(k = 0; k < len; k++)
+    {
+        dst[k] = a->ring[i];
+        if( ++i == a->n ) i = 0;
+    }
+    ev->t = a->t;
+    ev->seq = a->seq - 1;
+    ev->level = a->ring[a->trig];
+    ev->n = len;
+    a->stats.events++;
+    adc_awd_arm(a);
+    return 1;
+}
+
+void adc_awd_irq(S_adcAwd *a)
+{
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+    uint8_t ht = dma_get_interrupt_flag(dma, stream, DMA_HTIF);
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+    uint32_t now, d;
+
+    dma_clear_interrupt_flags(dma, stream, ADC_AWD_FLAGS);
+    if( te )
+    {
+        a->stats.errors++;
+        adc_awd_stop(a);
+        return;
+    }
+    if( !(ht || tc) ) return;
+
+    if( a->state == ADC_AWD_ARMING )
+    {
+        // n / 2 > pre samples of history are in
+        ADC_SR(a->adc) = ~ADC_SR_AWD;
+        a->state = ADC_AWD_ARMED;
+        adc_enable_awd_interrupt(a->adc);
+    }
+    else if( a->state == ADC_AWD_POST )
+    {
+        now = a->n - DMA_SNDTR(dma, stream);
+        d = (now + a->n - a->trig) % a->n;
+        // the second boundary is over n / 2 > post away
+        if( d >= a->post || ++a->seen >= 2 )
+            adc_awd_freeze(a);
+    }
+}
+
+void adc_awd_adc_irq(S_adcAwd *a)
+{
+    uint32_t adc = a->adc;
+    uint32_t p, t;
+
+    if( (ADC_SR(adc) & ADC_SR_AWD) && (ADC_CR1(adc) & ADC_CR1_AWDIE) )
+    {
+        t = DWT_CYCCNT;
+        adc_disable_awd_interrupt(adc);
+        ADC_SR(adc) = ~ADC_SR_AWD;
+        if( a->state == ADC_AWD_ARMED )
+        {
+            // next ring index; with EOC still set the DMA has not taken
+            // the trigger sample yet - it goes there, else it is behind
+            p = a->n - DMA_SNDTR(a->s.dma, a->s.stream);
+            if( !adc_eoc(adc) ) p += a->n - 1;
+            a->trig = p % a->n;
+            a->t = t;
+            a->seen = 0;
+            a->seq++;
+            a->state = ADC_AWD_POST;
+        }
+    }
+    if( adc_get_overrun_flag(adc) )
+    {
+        adc_clear_overrun_flag(adc);
+        if( a->state != ADC_AWD_IDLE && a->state != ADC_AWD_FROZEN )
+        {
+            // the DMA missed a sample, the ring has a hole - start over
+            a->stats.overruns++;
+            adc_awd_arm(a);
+        }
+    }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,262 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timer triggered ADC scan with CIC decimation - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "adc_scan.h"
+
+#include <libopencm3/stm32/adc.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define ADC_SCAN_FLAGS      (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void adc_scan_cic(S_adcScanCh *c, uint32_t x);
+static void adc_scan_start(S_adcScan *s);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// one input of the CIC, modulo 2^32 integrators, differential delay 1
+static void adc_scan_cic(S_adcScanCh *c, uint32_t x)
+{
+    uint32_t i, y, t;
+
+    c->integ[0] += x;
+    for(i = 1; i < c->order; i++)
+        c->integ[i] += c->integ[i - 1];
+    if( ++c->n < c->ratio ) return;
+
+    c->n = 0;
+    y = c->integ[c->order - 1];
+    for(i = 0; i < c->order; i++)
+    {
+        t = y;
+        y -= c->comb[i];
+        c->comb[i] = t;
+    }
+    c->out = y / c->gain;
+}
+
+static void adc_scan_start(S_adcScan *s)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t dma = s->s.dma;
+    uint8_t stream = s->s.stream;
+    uint32_t i;
+
+    timer_disable_counter(s->tim);
+    adc_disable_dma(s->adc);
+    DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+    dma_clear_interrupt_flags(dma, stream, ADC_SCAN_FLAGS);
+    adc_clear_overrun_flag(s->adc);
+
+    // the filters start over, old outputs would mix two time lines
+    for(i = 0; i < s->nch; i++)
+    {
+        S_adcScanCh *c = &s->ch[i];
+        c->n = 0;
+        c->out = 0;
+        c->integ[0] = c->integ[1] = c->integ[2] = 0;
+        c->comb[0] = c->comb[1] = c->comb[2] = 0;
+    }
+    s->k = 0;
+    s->halves = 0;
+
+    d.channel = s->s.channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_16BIT;
+    d.mem_size = DMA_SxCR_MSIZE_16BIT;
+    d.mode = DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    d.interrupts = DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.periph_address = (uint32_t)&ADC_DR(s->adc);
+    d.mem_address = (uint32_t)s->ring;
+    d.number = s->scans * s->nch;
+    dma_configure(dma, stream, &d);
+    dma_enable_stream(dma, stream);
+
+    // DDS - requests go on after the ring wraps
+    ADC_CR2(s->adc) |= ADC_CR2_DDS;
+    adc_enable_dma(s->adc);
+    timer_set_counter(s->tim, 0);
+    timer_enable_counter(s->tim);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_adcScan(S_adcScan *s, uint32_t adc, const S_dmaStream *dma,
+                 uint32_t tim, uint32_t ticks, S_adcScanCh *ch, uint8_t nch,
+                 uint16_t *ring, uint32_t scans, uint32_t frame,
+                 S_adcFrame *fr, uint32_t nfr)
+{
+    uint8_t seq[ADC_SCAN_MAX_CH];
+    uint32_t extsel, psc, i, j;
+
+    if( tim == TIM2 ) extsel = ADC_CR2_EXTSEL_TIM2_TRGO;
+    else if( tim == TIM3 ) extsel = ADC_CR2_EXTSEL_TIM3_TRGO;
+    else if( tim == TIM8 ) extsel = ADC_CR2_EXTSEL_TIM8_TRGO;
+    else return -1;
+    if( !nch || nch > ADC_SCAN_MAX_CH || !ticks || (scans & 1)
+        || scans * nch > 0xFFFF )
+        return -1;
+
+    for(i = 0; i < nch; i++)
+    {
+        S_adcScanCh *c = &ch[i];
+        if( !c->order || c->order > ADC_SCAN_MAX_ORDER || !c->ratio
+            || frame % c->ratio )
+            return -1;
+        c->gain = 1;
+        for(j = 0; j < c->order; j++)
+            c->gain *= c->ratio;
+        seq[i] = c->ch;
+    }
+
+    s->adc = adc;
+    s->s = *dma;
+    s->tim = tim;
+    s->ch = ch;
+    s->nch = nch;
+    s->ring = ring;
+    s->scans = scans;
+    s->frame = frame;
+    s->scan = 0;
+    s->fr = fr;
+    s->fmask = nfr - 1;
+    s->head = s->tail = 0;
+    s->stats = (S_adcScanStats){0};
+
+    adc_off(adc);
+    adc_set_resolution(adc, ADC_CR1_RES_12BIT);
+    adc_set_right_aligned(adc);
+    adc_enable_scan_mode(adc);
+    adc_set_single_conversion_mode(adc);
+    adc_eoc_after_each(adc);
+    for(i = 0; i < nch; i++)
+        adc_set_sample_time(adc, seq[i], ADC_SCAN_SMP);
+    adc_set_regular_sequence(adc, nch, seq);
+    adc_enable_external_trigger_regular(adc, extsel,
+                                        ADC_CR2_EXTEN_RISING_EDGE);
+    adc_power_on(adc);
+
+    // one scan per update event
+    timer_disable_counter(tim);
+    psc = (ticks - 1) / 0x10000;
+    timer_set_prescaler(tim, psc);
+    timer_set_period(tim, ticks / (psc + 1) - 1);
+    timer_set_master_mode(tim, TIM_CR2_MMS_UPDATE);
+    timer_generate_event(tim, TIM_EGR_UG);
+
+    nvic_set_priority(dma->irqn, ADC_SCAN_PRIORITY);
+    nvic_enable_irq(dma->irqn);
+    adc_scan_start(s);
+    return 0;
+}
+
+uint8_t adc_scan_read(S_adcScan *s, S_adcFrame *out)
+{
+    uint32_t tail = s->tail;
+
+    if( adc_get_overrun_flag(s->adc) )
+    {
+        // the DMA missed a result, the ADC stopped requesting
+        bool masked = cm_mask_interrupts(true);
+        s->stats.overruns++;
+        adc_scan_start(s);
+        cm_mask_interrupts(masked);
+    }
+    if( tail == s->head ) return 0;
+    *out = s->fr[tail & s->fmask];
+    __asm__ volatile("" ::: "memory");
+    s->tail = tail + 1;
+    return 1;
+}
+
+void adc_scan_irq(S_adcScan *s)
+{
+    uint32_t dma = s->s.dma;
+    uint8_t stream = s->s.stream;
+    uint8_t ht = dma_get_interrupt_flag(dma, stream, DMA_HTIF);
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint32_t half = s->scans / 2;
+    uint32_t idle, i, j;
+    const uint16_t *p;
+
+    dma_clear_interrupt_flags(dma, stream, ADC_SCAN_FLAGS);
+    if( !(ht || tc) ) return;
+
+    // the half the DMA is not in - NDTR counts down
+    idle = DMA_SNDTR(dma, stream) > half * s->nch ? 1 : 0;
+    if( (s->halves & 1) != idle )
+    {
+        s->halves++;
+        s->scan += half;
+        s->stats.late++;
+    }
+    s->halves++;
+
+    p = s->ring + idle * half * s->nch;
+    for(i = 0; i < half; i++)
+    {
+        for(j = 0; j < s->nch; j++)
+            adc_scan_cic(&s->ch[j], *p++);
+        s->scan++;
+        if( ++s->k < s->frame ) continue;
+
+        // every ratio divides frame - all channels just produced an output
+        s->k = 0;
+        if( s->head - s->tail > s->fmask )
+        {
+            s->stats.dropped++;
+            continue;
+        }
+        S_adcFrame *f = &s->fr[s->head & s->fmask];
+        f->scan = s->scan - 1;
+        for(j = 0; j < s->nch; j++)
+            f->val[j] = s->ch[j].out;
+        __asm__ volatile("" ::: "memory");
+        s->head++;
+        s->stats.frames++;
+    }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,211 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Triple interleaved ADC capture - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "adc_triple.h"
+
+#include <libopencm3/stm32/adc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define ADC_TRIPLE_FLAGS    (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// tSTAB after ADON, 3 us
+#define ADC_TRIPLE_STAB_CYC (3 * 168)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static const uint32_t adc_triple_adc[3] = { ADC1, ADC2, ADC3 };
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_adcTriple(S_adcTriple *a, const S_dmaStream *s, uint8_t channel,
+                    uint16_t *buf, uint32_t n, F_adcTripleHalf cb, void *arg)
+{
+    uint8_t ch[1];
+    uint32_t i, t;
+
+    a->s = *s;
+    a->channel = channel;
+    a->buf = buf;
+    a->half = n / 2;
+    a->cb = cb;
+    a->arg = arg;
+    a->halves = 0;
+    a->running = 0;
+    a->stats = (S_adcTripleStats){0};
+    ch[0] = channel;
+
+    for(i = 0; i < 3; i++)
+        adc_off(adc_triple_adc[i]);
+    ADC_CCR = 0;
+    adc_set_clk_prescale(ADC_TRIPLE_ADCPRE);
+    ADC_CCR |= ADC_TRIPLE_CCR_DLY;
+    adc_set_multi_mode(ADC_CCR_MULTI_TRIPLE_INTERLEAVED);
+
+    for(i = 0; i < 3; i++)
+    {
+        uint32_t adc = adc_triple_adc[i];
+        adc_set_resolution(adc, ADC_CR1_RES_12BIT);
+        adc_set_right_aligned(adc);
+        adc_disable_scan_mode(adc);
+        adc_set_sample_time(adc, channel, ADC_SMPR_SMP_3CYC);
+        adc_set_regular_sequence(adc, 1, ch);
+        // the common DMA mode moves the data, not the ADC's own request
+        adc_disable_dma(adc);
+        adc_enable_overrun_interrupt(adc);
+        adc_power_on(adc);
+    }
+
+    dwt_enable_cycle_counter();
+    t = DWT_CYCCNT;
+    while( DWT_CYCCNT - t < ADC_TRIPLE_STAB_CYC ) ;
+
+    nvic_set_priority(NVIC_ADC_IRQ, ADC_TRIPLE_PRIORITY);
+    nvic_enable_irq(NVIC_ADC_IRQ);
+    nvic_set_priority(s->irqn, ADC_TRIPLE_PRIORITY);
+    nvic_enable_irq(s->irqn);
+}
+
+void adc_triple_start(S_adcTriple *a)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+    uint32_t i;
+
+    adc_triple_stop(a);
+
+    d.channel = a->s.channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    // one word per 2 samples, 2.1 M words/s at 4.2 MS/s
+    d.priority = DMA_SxCR_PL_VERY_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_32BIT;
+    d.mem_size = DMA_SxCR_MSIZE_32BIT;
+    d.mode = DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    d.interrupts = DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.periph_address = (uint32_t)&ADC_CDR;
+    d.mem_address = (uint32_t)a->buf;
+    d.number = a->half;             // 2 * half samples = half words
+    dma_configure(dma, stream, &d);
+    dma_enable_stream(dma, stream);
+
+    // DMA mode 2, requests go on after the last transfer (circular)
+    ADC_CCR |= ADC_CCR_DMA_MODE_2 | ADC_CCR_DDS;
+    for(i = 0; i < 3; i++)
+        adc_set_continuous_conversion_mode(adc_triple_adc[i]);
+
+    a->halves = 0;
+    a->running = 1;
+    // the slaves follow the master, sample 0 is started here
+    bool masked = cm_mask_interrupts(true);
+    a->t0 = DWT_CYCCNT;
+    adc_start_conversion_regular(ADC1);
+    cm_mask_interrupts(masked);
+}
+
+void adc_triple_stop(S_adcTriple *a)
+{
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+    uint32_t i;
+
+    a->running = 0;
+    for(i = 0; i < 3; i++)
+        adc_set_single_conversion_mode(adc_triple_adc[i]);
+    // clearing the DMA mode resets the CDR sequence for the restart
+    ADC_CCR &= ~(ADC_CCR_DMA_MODE_2 | ADC_CCR_DMA_MODE_3 | ADC_CCR_DDS);
+    DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+    dma_clear_interrupt_flags(dma, stream, ADC_TRIPLE_FLAGS);
+    for(i = 0; i < 3; i++)
+        adc_clear_overrun_flag(adc_triple_adc[i]);
+}
+
+void adc_triple_irq(S_adcTriple *a)
+{
+    uint32_t dma = a->s.dma;
+    uint8_t stream = a->s.stream;
+    uint8_t ht = dma_get_interrupt_flag(dma, stream, DMA_HTIF);
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+    uint32_t idle, first;
+
+    dma_clear_interrupt_flags(dma, stream, ADC_TRIPLE_FLAGS);
+    if( !a->running ) return;
+    if( te )
+    {
+        a->stats.errors++;
+        adc_triple_stop(a);
+        return;
+    }
+    if( !(ht || tc) ) return;
+
+    // the half the DMA is not in - NDTR (words) counts down
+    idle = DMA_SNDTR(dma, stream) > a->half / 2 ? 1 : 0;
+    if( (a->halves & 1) != idle )
+    {
+        // a whole half went by unseen
+        a->halves++;
+        a->stats.late++;
+    }
+    first = a->halves * a->half;
+    a->halves++;
+    a->stats.halves++;
+    if( a->cb )
+        a->cb(a->arg, a->buf + idle * a->half, a->half, first,
+              a->t0 + first * ADC_TRIPLE_CYC);
+}
+
+void adc_triple_adc_irq(S_adcTriple *a)
+{
+    uint32_t i;
+
+    for(i = 0; i < 3; i++)
+        if( adc_get_overrun_flag(adc_triple_adc[i]) )
+        {
+            // the conversions stopped, the DMA waits for requests
+            a->stats.overruns++;
+            adc_triple_stop(a);
+            return;
+        }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
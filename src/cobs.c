@@ -0,0 +1,244 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Streaming COBS framing with a hardware CRC-32 trailer - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "cobs.h"
+#include "crc_hw.h"
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+// a block holds at most 254 data bytes, code 0xFF = 254 and no zero after
+#define COBS_BLOCK_MAX      0xFF
+
+// nonzero if one of the 4 bytes of v is zero
+#define COBS_HAS_ZERO(v)    (((v) - 0x01010101u) & ~(v) & 0x80808080u)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static int cobs_enc_run(S_cobsEnc *e, const uint8_t *p, uint32_t len);
+static void cobs_dec_end(S_cobsDec *d);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// stuffs len bytes, no CRC
+static int cobs_enc_run(S_cobsEnc *e, const uint8_t *p, uint32_t len)
+{
+    uint8_t *o, *c;
+    uint32_t code;
+
+    if( e->err ) return -1;
+    // worst case - one more code byte per 254 data bytes
+    if( e->size - e->n < len + len / 254 + 1 )
+    {
+        e->err = 1;
+        return -1;
+    }
+
+    o = e->out + e->n;
+    c = e->out + e->code_at;
+    code = e->code;
+    while( len )
+    {
+        uint8_t b;
+        // 4 zero-free bytes that fit into the open block at once
+        if( len >= 4 && code <= COBS_BLOCK_MAX - 4 )
+        {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            if( !COBS_HAS_ZERO(v) )
+            {
+                memcpy(o, &v, 4);
+                o += 4;
+                p += 4;
+                len -= 4;
+                code += 4;
+                if( code == COBS_BLOCK_MAX )
+                {
+                    *c = COBS_BLOCK_MAX;
+                    c = o++;
+                    code = 1;
+                }
+                continue;
+            }
+        }
+
+        b = *p++;
+        len--;
+        if( b )
+        {
+            *o++ = b;
+            if( ++code != COBS_BLOCK_MAX ) continue;
+        }
+        // a zero (or a full block) closes the block
+        *c = code;
+        c = o++;
+        code = 1;
+    }
+
+    e->n = o - e->out;
+    e->code_at = c - e->out;
+    e->code = code;
+    return 0;
+}
+
+static void cobs_dec_end(S_cobsDec *d)
+{
+    if( d->skip ) ;
+    else if( d->left ) d->stats.truncated++;
+    else if( !d->n ) ;  // back to back delimiters - idle / resync
+    else if( d->n < COBS_CRC_BYTES ) d->stats.runts++;
+    else if( crc_hw_update(CRC_HW_INIT, d->buf, d->n) ) d->stats.crc_errors++;
+    else
+    {
+        d->stats.frames++;
+        if( d->frame ) d->frame(d->arg, d->buf, d->n - COBS_CRC_BYTES);
+    }
+    d->n = 0;
+    d->left = 0;
+    d->zero = 0;
+    d->skip = 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void cobs_enc_begin(S_cobsEnc *e, uint8_t *out, uint32_t size)
+{
+    e->out = out;
+    e->size = size;
+    e->n = 1;
+    e->code_at = 0;
+    e->code = 1;
+    e->crc = CRC_HW_INIT;
+    e->err = (size < 2);
+}
+
+int cobs_enc_feed(S_cobsEnc *e, const void *p, uint32_t len)
+{
+    if( cobs_enc_run(e, p, len) ) return -1;
+    e->crc = crc_hw_update(e->crc, p, len);
+    return 0;
+}
+
+uint32_t cobs_enc_end(S_cobsEnc *e)
+{
+    uint8_t crc[COBS_CRC_BYTES];
+
+    crc[0] = e->crc >> 24;
+    crc[1] = e->crc >> 16;
+    crc[2] = e->crc >> 8;
+    crc[3] = e->crc;
+    if( cobs_enc_run(e, crc, sizeof(crc)) || e->n >= e->size ) return 0;
+    e->out[e->code_at] = e->code;
+    e->out[e->n++] = 0;
+    return e->n;
+}
+
+uint32_t cobs_encode(const void *p, uint32_t len, uint8_t *out,
+                     uint32_t size)
+{
+    S_cobsEnc e;
+    cobs_enc_begin(&e, out, size);
+    if( cobs_enc_feed(&e, p, len) ) return 0;
+    return cobs_enc_end(&e);
+}
+
+void INIT_cobsDec(S_cobsDec *d, uint8_t *buf, uint32_t size,
+                  F_cobsFrame frame, void *arg)
+{
+    memset(d, 0, sizeof(*d));
+    d->buf = buf;
+    d->size = size;
+    d->frame = frame;
+    d->arg = arg;
+}
+
+void cobs_dec_feed(S_cobsDec *d, const uint8_t *p, uint32_t len)
+{
+    while( len )
+    {
+        uint8_t b;
+
+        if( d->left )
+        {
+            // data run of the block - copy it in one go
+            uint32_t run = d->left < len ? d->left : len;
+            const uint8_t *z = memchr(p, 0, run);
+            if( z ) run = z - p;
+            if( !d->skip )
+            {
+                if( d->n + run > d->size )
+                {
+                    d->stats.overflows++;
+                    d->skip = 1;
+                }
+                else
+                {
+                    memcpy(d->buf + d->n, p, run);
+                    d->n += run;
+                }
+            }
+            p += run;
+            len -= run;
+            d->left -= run;
+            if( !z ) continue;
+        }
+
+        b = *p++;
+        len--;
+        if( !b )
+        {
+            cobs_dec_end(d);
+            continue;
+        }
+
+        // code byte - the zero the previous block ended with comes first
+        if( d->zero && !d->skip )
+        {
+            if( d->n >= d->size )
+            {
+                d->stats.overflows++;
+                d->skip = 1;
+            }
+            else d->buf[d->n++] = 0;
+        }
+        d->left = b - 1;
+        d->zero = (b != COBS_BLOCK_MAX);
+    }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,391 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Byte stream CRC-32/MPEG-2 on the hardware CRC unit - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "crc_hw.h"
+
+#include <libopencm3/stm32/crc.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define CRC_HW_POLY         0x04C11DB7u
+#define CRC_HW_DMA_FLAGS    (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// longest chunk of byte items, NDTR counts the source (peripheral) items
+// and has to be a multiple of the 4 bytes packed into one word
+#define CRC_HW_DMA_BYTES    0xFFFCu
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+
+// CRC of a nibble in the top 4 bits, MSB first
+static const uint32_t crc_hw_nib[16] = {
+    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
+    0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
+    0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD
+};
+
+// CRC of a nibble in the low 4 bits, reflected (0xEDB88320)
+static const uint32_t crc_hw_nib_r[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// a DMA job holds the unit
+static volatile uint8_t crc_hw_dma_own = 0;
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t crc_hw_byte(uint32_t crc, uint8_t b);
+static uint32_t crc_hw_byte_r(uint32_t t, uint8_t b);
+static uint32_t crc_hw_unstep(uint32_t crc);
+static uint32_t crc_hw_rbit(uint32_t x);
+static void crc_hw_load(uint32_t crc);
+static uint32_t crc_hw_words(uint32_t crc, const uint8_t *b, uint32_t n);
+static void crc_hw_dma_run(S_crcHwDma *c);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t crc_hw_byte(uint32_t crc, uint8_t b)
+{
+    crc = (crc << 4) ^ crc_hw_nib[(crc >> 28) ^ (b >> 4)];
+    crc = (crc << 4) ^ crc_hw_nib[(crc >> 28) ^ (b & 0x0F)];
+    return crc;
+}
+
+// t - reflected register (not inverted), low nibble first
+static uint32_t crc_hw_byte_r(uint32_t t, uint8_t b)
+{
+    t = (t >> 4) ^ crc_hw_nib_r[(t ^ b) & 0x0F];
+    t = (t >> 4) ^ crc_hw_nib_r[(t ^ (b >> 4)) & 0x0F];
+    return t;
+}
+
+// x such that one 32-bit step of the unit turns x into crc
+static uint32_t crc_hw_unstep(uint32_t crc)
+{
+    uint32_t i;
+    for(i = 0; i < 32; i++)
+    {
+        // the polynomial has bit 0 set - a set LSB means it was xored in
+        if( crc & 1 ) crc = ((crc ^ CRC_HW_POLY) >> 1) | 0x80000000u;
+        else crc >>= 1;
+    }
+    return crc;
+}
+
+static uint32_t crc_hw_rbit(uint32_t x)
+{
+    uint32_t r;
+    __asm__("rbit %0, %1" : "=r" (r) : "r" (x));
+    return r;
+}
+
+// unit brought to crc - interrupts masked by the caller; CRC_DR is the
+// whole state, so a unit still holding crc (nobody used it since the last
+// chunk) is left as it is
+static void crc_hw_load(uint32_t crc)
+{
+    if( CRC_DR == crc ) return;
+    CRC_CR = CRC_CR_RESET;
+    // after the reset the unit holds CRC_HW_INIT
+    if( crc != CRC_HW_INIT ) CRC_DR = crc_hw_unstep(crc) ^ CRC_HW_INIT;
+}
+
+// native word CRC of n little-endian words, any alignment
+static uint32_t crc_hw_words(uint32_t crc, const uint8_t *b, uint32_t n)
+{
+    uint32_t w, k;
+
+    while( n )
+    {
+        bool masked = cm_mask_interrupts(true);
+        if( crc_hw_dma_own )
+        {
+            cm_mask_interrupts(masked);
+            break;
+        }
+        k = n < CRC_HW_MASK_WORDS ? n : CRC_HW_MASK_WORDS;
+        n -= k;
+        crc_hw_load(crc);
+        for(; k; k--, b += 4)
+        {
+            memcpy(&w, b, 4);
+            CRC_DR = w;
+        }
+        crc = CRC_DR;
+        cm_mask_interrupts(masked);
+    }
+    // the unit is taken - MSB first of a little-endian word, byte 3 first
+    for(; n; n--, b += 4)
+    {
+        crc = crc_hw_byte(crc, b[3]);
+        crc = crc_hw_byte(crc, b[2]);
+        crc = crc_hw_byte(crc, b[1]);
+        crc = crc_hw_byte(crc, b[0]);
+    }
+    return crc;
+}
+
+static void crc_hw_dma_run(S_crcHwDma *c)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t item = ((uint32_t)c->p & 3) ? 1 : 4;
+    uint32_t max = item == 4 ? 0xFFFFu * 4 : CRC_HW_DMA_BYTES;
+    uint32_t chunk = c->left < max ? c->left : max;
+
+    d.channel = c->s.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_MEM;
+    // peripheral streams go first
+    d.priority = DMA_SxCR_PL_LOW;
+    // memory-to-memory: the peripheral port reads the data, the memory
+    // port writes CRC_DR; unaligned bytes are packed LSB first
+    d.periph_size = item == 4 ? DMA_SxCR_PSIZE_32BIT : DMA_SxCR_PSIZE_8BIT;
+    d.mem_size = DMA_SxCR_MSIZE_32BIT;
+    d.mode = DMA_SxCR_PINC;
+    d.interrupts = DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.fifo = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH_4_4_FULL;
+    d.periph_address = (uint32_t)c->p;
+    d.mem_address = (uint32_t)&CRC_DR;
+    d.number = chunk / item;
+    c->p += chunk;
+    c->left -= chunk;
+
+    dma_clear_interrupt_flags(c->s.dma, c->s.stream, CRC_HW_DMA_FLAGS);
+    dma_configure(c->s.dma, c->s.stream, &d);
+    dma_enable_stream(c->s.dma, c->s.stream);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_crcHw(void)
+{
+    rcc_periph_clock_enable(RCC_CRC);
+}
+
+uint32_t crc_hw_update(uint32_t crc, const void *p, uint32_t len)
+{
+    const uint8_t *b = p;
+    uint32_t words;
+
+    // head up to a word boundary
+    while( len && ((uint32_t)b & 3) )
+    {
+        crc = crc_hw_byte(crc, *b++);
+        len--;
+    }
+
+    // CRC_HW_MASK_WORDS at a time - the running CRC carries over
+    while( len >= 4 )
+    {
+        const uint32_t *w = (const uint32_t *)b;
+        bool masked = cm_mask_interrupts(true);
+
+        if( crc_hw_dma_own )
+        {
+            cm_mask_interrupts(masked);
+            break;
+        }
+        words = len >> 2;
+        if( words > CRC_HW_MASK_WORDS ) words = CRC_HW_MASK_WORDS;
+        crc_hw_load(crc);
+        len -= words << 2;
+        b += words << 2;
+        while( words-- ) CRC_DR = __builtin_bswap32(*w++);
+        crc = CRC_DR;
+        cm_mask_interrupts(masked);
+    }
+
+    while( len-- ) crc = crc_hw_byte(crc, *b++);
+    return crc;
+}
+
+uint32_t crc_hw_crc32(uint32_t crc, const void *p, uint32_t len)
+{
+    const uint8_t *b = p;
+    uint32_t t = ~crc;
+    uint32_t words;
+
+    while( len && ((uint32_t)b & 3) )
+    {
+        t = crc_hw_byte_r(t, *b++);
+        len--;
+    }
+
+    while( len >= 4 )
+    {
+        const uint32_t *w = (const uint32_t *)b;
+        bool masked = cm_mask_interrupts(true);
+
+        if( crc_hw_dma_own )
+        {
+            cm_mask_interrupts(masked);
+            break;
+        }
+        words = len >> 2;
+        if( words > CRC_HW_MASK_WORDS ) words = CRC_HW_MASK_WORDS;
+        // the unit register is the mirror image of t
+        crc_hw_load(crc_hw_rbit(t));
+        len -= words << 2;
+        b += words << 2;
+        while( words-- ) CRC_DR = crc_hw_rbit(*w++);
+        t = crc_hw_rbit(CRC_DR);
+        cm_mask_interrupts(masked);
+    }
+
+    while( len-- ) t = crc_hw_byte_r(t, *b++);
+    return ~t;
+}
+
+void INIT_crcHwDma(S_crcHwDma *c, const S_dmaStream *s)
+{
+    c->s = *s;
+    c->busy = 0;
+    c->stats = (S_crcHwDmaStats){0};
+    crc_hw_dma_begin(c);
+
+    nvic_set_priority(s->irqn, CRC_HW_DMA_PRIORITY);
+    nvic_enable_irq(s->irqn);
+}
+
+void crc_hw_dma_begin(S_crcHwDma *c)
+{
+    c->crc = CRC_HW_INIT;
+    c->ntail = 0;
+}
+
+int crc_hw_dma_update(S_crcHwDma *c, const void *p, uint32_t len,
+                      F_crcHwDone done, void *arg)
+{
+    const uint8_t *b = p;
+    uint32_t bytes;
+
+    if( c->busy ) return -1;
+
+    // finish the word left over from the previous span
+    if( c->ntail )
+    {
+        while( len && c->ntail < 4 )
+        {
+            c->tail[c->ntail++] = *b++;
+            len--;
+        }
+        if( c->ntail == 4 )
+        {
+            c->crc = crc_hw_words(c->crc, c->tail, 1);
+            c->ntail = 0;
+        }
+    }
+    // bytes after the last whole word wait for the next span
+    bytes = len & ~3u;
+    if( !c->ntail )
+    {
+        c->ntail = len & 3;
+        memcpy(c->tail, b + bytes, c->ntail);
+    }
+
+    bool masked = cm_mask_interrupts(true);
+    if( bytes < CRC_HW_DMA_MIN || crc_hw_dma_own )
+    {
+        cm_mask_interrupts(masked);
+        c->crc = crc_hw_words(c->crc, b, bytes >> 2);
+        c->stats.cpu_jobs++;
+        if( done ) done(arg);
+        return 0;
+    }
+    crc_hw_dma_own = 1;
+    c->busy = 1;
+    c->start = c->p = b;
+    c->len = c->left = bytes;
+    c->done = done;
+    c->arg = arg;
+    c->stats.dma_jobs++;
+    crc_hw_load(c->crc);
+    crc_hw_dma_run(c);
+    cm_mask_interrupts(masked);
+    return 0;
+}
+
+uint32_t crc_hw_dma_final(const S_crcHwDma *c)
+{
+    uint8_t pad[4] = {0};
+
+    if( !c->ntail ) return c->crc;
+    memcpy(pad, c->tail, c->ntail);
+    return crc_hw_words(c->crc, pad, 1);
+}
+
+void crc_hw_dma_irq(S_crcHwDma *c)
+{
+    uint32_t dma = c->s.dma;
+    uint8_t stream = c->s.stream;
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+
+    dma_clear_interrupt_flags(dma, stream, CRC_HW_DMA_FLAGS);
+    if( !c->busy ) return;
+
+    if( te )
+    {
+        // an address the DMA cannot read - the CPU does the whole span,
+        // c->crc still holds the value from before it
+        DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+        while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+        c->stats.errors++;
+        crc_hw_dma_own = 0;
+        c->crc = crc_hw_words(c->crc, c->start, c->len >> 2);
+    }
+    else if( !tc ) return;
+    else if( c->left )
+    {
+        crc_hw_dma_run(c);
+        return;
+    }
+    else
+    {
+        c->crc = CRC_DR;
+        crc_hw_dma_own = 0;
+    }
+    c->busy = 0;
+    if( c->done ) c->done(c->arg);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,476 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Asynchronous AES / TDES on the CRYP unit - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "cryp_hw.h"
+
+#include <libopencm3/stm32/crypto.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define CRYP_HW_FLAGS       (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// key and IV registers as 32-bit words (libopencm3 takes 64-bit keys and
+// reaches only the IVxLR halves): K0LR..K3RR, IV0LR..IV1RR
+#define CRYP_HW_KR(i)       MMIO32(CRYP_BASE + 0x20 + 4 * (i))
+#define CRYP_HW_IVR(i)      MMIO32(CRYP_BASE + 0x40 + 4 * (i))
+// longest DMA run, NDTR counts words; a multiple of both block sizes
+#define CRYP_HW_CHUNK       (0xFFF0u * 4)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+typedef struct _S_crypHwJob{
+    S_crypHwCtx *x;
+    const uint8_t *in;
+    uint8_t *out;
+    uint32_t len;           // bytes left
+    uint32_t chunk;         // bytes of the running NDTR load
+    F_crypHwDone done;
+    void *arg;
+} S_crypHwJob;
+
+typedef struct _S_crypHwKat{
+    E_crypHwMode mode;
+    uint8_t klen;
+    uint8_t len;
+    uint8_t split;          // bytes of the first job, 0 - one job
+    uint8_t key[32];
+    uint8_t iv[16];
+    uint8_t pt[32];
+    uint8_t ct[32];
+} S_crypHwKat;
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static S_dmaStream cryp_hw_in;
+static S_dmaStream cryp_hw_out;
+static uint32_t cryp_hw_ready = 0;
+
+// ring of jobs, the one at cryp_hw_first runs
+static S_crypHwJob cryp_hw_q[CRYP_HW_QUEUE];
+static uint32_t cryp_hw_first = 0;
+static volatile uint32_t cryp_hw_n = 0;
+
+// context whose key is in the unit
+static S_crypHwCtx *cryp_hw_loaded = 0;
+
+static S_crypHwStats cryp_hw_st;
+
+static const S_crypHwKat cryp_hw_kat[] = {
+    // FIPS-197 C.1
+    {CRYP_HW_AES_ECB, 16, 16, 0,
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+         0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F},
+        {0},
+        {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+         0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF},
+        {0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30,
+         0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A}
+    },
+    // FIPS-197 C.3
+    {CRYP_HW_AES_ECB, 32, 16, 0,
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+         0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+         0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+         0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F},
+        {0},
+        {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+         0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF},
+        {0x8E, 0xA2, 0xB7, 0xCA, 0x51, 0x67, 0x45, 0xBF,
+         0xEA, 0xFC, 0x49, 0x90, 0x4B, 0x49, 0x60, 0x89}
+    },
+    // SP800-38A F.2.1
+    {CRYP_HW_AES_CBC, 16, 32, 16,
+        {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+         0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+         0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F},
+        {0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96,
+         0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+         0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C,
+         0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51},
+        {0x76, 0x49, 0xAB, 0xAC, 0x81, 0x19, 0xB2, 0x46,
+         0xCE, 0xE9, 0x8E, 0x9B, 0x12, 0xE9, 0x19, 0x7D,
+         0x50, 0x86, 0xCB, 0x9B, 0x50, 0x72, 0x19, 0xEE,
+         0x95, 0xDB, 0x11, 0x3A, 0x91, 0x76, 0x78, 0xB2}
+    },
+    // SP800-38A F.5.1
+    {CRYP_HW_AES_CTR, 16, 32, 16,
+        {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+         0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C},
+        {0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7,
+         0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF},
+        {0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96,
+         0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A,
+         0xAE, 0x2D, 0x8A, 0x57, 0x1E, 0x03, 0xAC, 0x9C,
+         0x9E, 0xB7, 0x6F, 0xAC, 0x45, 0xAF, 0x8E, 0x51},
+        {0x87, 0x4D, 0x61, 0x91, 0xB6, 0x20, 0xE3, 0x26,
+         0x1B, 0xEF, 0x68, 0x64, 0x99, 0x0D, 0xB6, 0xCE,
+         0x98, 0x06, 0xF6, 0x6B, 0x79, 0x70, 0xFD, 0xFF,
+         0x86, 0x17, 0x18, 0x7B, 0xB9, 0xFF, 0xFD, 0xFF}
+    },
+    // SP800-67 example
+    {CRYP_HW_TDES_ECB, 24, 24, 8,
+        {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+         0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01,
+         0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23},
+        {0},
+        {0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x66, 0x63,
+         0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+         0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70},
+        {0xA8, 0x26, 0xFD, 0x8C, 0xE5, 0x3B, 0x85, 0x5F,
+         0xCC, 0xE2, 0x1C, 0x81, 0x12, 0x25, 0x6F, 0xE6,
+         0x68, 0xD5, 0xC0, 0x5D, 0xD9, 0xB6, 0xB9, 0x00}
+    },
+    // SP800-67 key and text, CBC with IV 00..07
+    {CRYP_HW_TDES_CBC, 24, 24, 8,
+        {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+         0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01,
+         0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x01, 0x23},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07},
+        {0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x66, 0x63,
+         0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+         0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70},
+        {0xF3, 0x68, 0xD0, 0x6F, 0x3B, 0xBD, 0x61, 0x4E,
+         0x60, 0xF2, 0xD0, 0x24, 0x5C, 0xAD, 0x3F, 0x81,
+         0x8D, 0x5C, 0x69, 0xF2, 0xCB, 0x3F, 0xD5, 0xC7}
+    }
+};
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t cryp_hw_be32(const uint8_t *b);
+static void cryp_hw_halt(const S_dmaStream *s);
+static void cryp_hw_stream(const S_dmaStream *s, uint32_t dir,
+                           volatile uint32_t *reg, const void *mem,
+                           uint32_t len);
+static void cryp_hw_load(S_crypHwCtx *x);
+static void cryp_hw_run(S_crypHwJob *j);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t cryp_hw_be32(const uint8_t *b)
+{
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16
+         | (uint32_t)b[2] << 8 | b[3];
+}
+
+static void cryp_hw_halt(const S_dmaStream *s)
+{
+    DMA_SCR(s->dma, s->stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(s->dma, s->stream) & DMA_SxCR_EN ) ;
+}
+
+// the unit asks for 4 words at a time - 16-byte peripheral bursts
+static void cryp_hw_stream(const S_dmaStream *s, uint32_t dir,
+                           volatile uint32_t *reg, const void *mem,
+                           uint32_t len)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t a = (uint32_t)mem;
+
+    d.channel = s->channel;
+    d.direction = dir;
+    // the output first, a full output FIFO stalls the unit
+    d.priority = dir == DMA_SxCR_DIR_PERIPHERAL_TO_MEM ? DMA_SxCR_PL_HIGH
+                                                       : DMA_SxCR_PL_MEDIUM;
+    d.periph_size = DMA_SxCR_PSIZE_32BIT;
+    d.periph_burst = DMA_SxCR_PBURST_INCR4;
+    if( a & 3 )
+        d.mem_size = DMA_SxCR_MSIZE_8BIT;
+    else
+    {
+        d.mem_size = DMA_SxCR_MSIZE_32BIT;
+        // from a 16-byte aligned address a burst never crosses 1 KB
+        if( !(a & 15) ) d.mem_burst = DMA_SxCR_MBURST_INCR4;
+    }
+    d.mode = DMA_SxCR_MINC;
+    d.interrupts = DMA_SxCR_TEIE;
+    if( dir == DMA_SxCR_DIR_PERIPHERAL_TO_MEM )
+        d.interrupts |= DMA_SxCR_TCIE;
+    d.fifo = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH_4_4_FULL;
+    d.periph_address = (uint32_t)reg;
+    d.mem_address = a;
+    d.number = len >> 2;
+    dma_configure(s->dma, s->stream, &d);
+}
+
+// unit off, key (on a context change only) and IV in
+static void cryp_hw_load(S_crypHwCtx *x)
+{
+    uint8_t i;
+
+    crypto_wait_busy();
+    crypto_stop();
+    CRYP_CR = x->cr;
+    if( cryp_hw_loaded != x )
+    {
+        for(i = 0; i < 8; i++) CRYP_HW_KR(i) = x->key[i];
+        if( x->prep )
+        {
+            // the decryption key schedule, CRYPEN drops at the end
+            CRYP_CR = (x->cr & ~CRYP_CR_ALGOMODE) | CRYP_CR_ALGOMODE_AES_PREP
+                    | CRYP_CR_CRYPEN;
+            crypto_wait_busy();
+            CRYP_CR = x->cr;
+        }
+        cryp_hw_loaded = x;
+        cryp_hw_st.rekeys++;
+    }
+    for(i = 0; i < 4; i++) CRYP_HW_IVR(i) = x->iv[i];
+    CRYP_CR |= CRYP_CR_FFLUSH;
+}
+
+// loads the next NDTR chunk of job j, both streams, unit on
+static void cryp_hw_run(S_crypHwJob *j)
+{
+    j->chunk = j->len > CRYP_HW_CHUNK ? CRYP_HW_CHUNK : j->len;
+    cryp_hw_stream(&cryp_hw_out, DMA_SxCR_DIR_PERIPHERAL_TO_MEM,
+                   &CRYP_DOUT, j->out, j->chunk);
+    cryp_hw_stream(&cryp_hw_in, DMA_SxCR_DIR_MEM_TO_PERIPHERAL,
+                   &CRYP_DIN, j->in, j->chunk);
+    dma_enable_stream(cryp_hw_out.dma, cryp_hw_out.stream);
+    dma_enable_stream(cryp_hw_in.dma, cryp_hw_in.stream);
+    CRYP_DMACR = CRYP_DMACR_DIEN | CRYP_DMACR_DOEN;
+    crypto_start();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_crypHw(void)
+{
+    if( cryp_hw_ready ) return 0;
+    if( !CRYP_HW_UNIT ) return -1;
+    if( dma_alloc(DMA_REQ_CRYP_IN, &cryp_hw_in) ) return -1;
+    if( dma_alloc(DMA_REQ_CRYP_OUT, &cryp_hw_out) )
+    {
+        dma_free(&cryp_hw_in);
+        return -1;
+    }
+    rcc_periph_clock_enable(RCC_CRYP);
+    nvic_set_priority(cryp_hw_in.irqn, CRYP_HW_PRIORITY);
+    nvic_enable_irq(cryp_hw_in.irqn);
+    nvic_set_priority(cryp_hw_out.irqn, CRYP_HW_PRIORITY);
+    nvic_enable_irq(cryp_hw_out.irqn);
+    cryp_hw_ready = 1;
+    return 0;
+}
+
+int cryp_hw_ctx(S_crypHwCtx *x, E_crypHwMode mode, uint8_t decrypt,
+                const uint8_t *key, uint8_t klen, const uint8_t *iv)
+{
+    static const uint32_t algo[5] = {
+        CRYP_CR_ALGOMODE_AES_ECB, CRYP_CR_ALGOMODE_AES_CBC,
+        CRYP_CR_ALGOMODE_AES_CTR, CRYP_CR_ALGOMODE_TDES_ECB,
+        CRYP_CR_ALGOMODE_TDES_CBC
+    };
+    uint8_t tdes = mode >= CRYP_HW_TDES_ECB;
+    uint8_t i, k0;
+
+    if( tdes ? klen != 24 : (klen != 16 && klen != 24 && klen != 32) )
+        return -1;
+
+    x->cr = algo[mode] | CRYP_CR_DATATYPE_8;
+    if( !tdes ) x->cr |= (uint32_t)(klen / 8 - 2) << CRYP_CR_KEYSIZE_SHIFT;
+    // CTR decrypts by encrypting the counter
+    if( decrypt && mode != CRYP_HW_AES_CTR ) x->cr |= CRYP_CR_ALGODIR;
+    x->prep = decrypt && (mode == CRYP_HW_AES_ECB || mode == CRYP_HW_AES_CBC);
+    x->block = tdes ? 8 : 16;
+    x->chain = mode != CRYP_HW_AES_ECB && mode != CRYP_HW_TDES_ECB;
+
+    // the key ends in K3RR, a shorter one leaves the first words unused
+    memset(x->key, 0, sizeof(x->key));
+    k0 = 8 - klen / 4;
+    for(i = 0; i < klen / 4; i++) x->key[k0 + i] = cryp_hw_be32(key + 4 * i);
+    memset(x->iv, 0, sizeof(x->iv));
+    if( iv )
+        for(i = 0; i < x->block / 4; i++) x->iv[i] = cryp_hw_be32(iv + 4 * i);
+
+    if( cryp_hw_loaded == x ) cryp_hw_loaded = 0;
+    return 0;
+}
+
+int cryp_hw_queue(S_crypHwCtx *x, const void *in, void *out, uint32_t len,
+                  F_crypHwDone done, void *arg)
+{
+    S_crypHwJob *j;
+
+    if( !cryp_hw_ready || !len || len % x->block ) return -1;
+
+    bool masked = cm_mask_interrupts(true);
+    if( cryp_hw_n >= CRYP_HW_QUEUE )
+    {
+        cryp_hw_st.full++;
+        cm_mask_interrupts(masked);
+        return -1;
+    }
+    j = &cryp_hw_q[(cryp_hw_first + cryp_hw_n) % CRYP_HW_QUEUE];
+    j->x = x;
+    j->in = in;
+    j->out = out;
+    j->len = len;
+    j->chunk = 0;
+    j->done = done;
+    j->arg = arg;
+    if( cryp_hw_n++ == 0 )
+    {
+        cryp_hw_load(x);
+        cryp_hw_run(j);
+    }
+    cm_mask_interrupts(masked);
+    return 0;
+}
+
+void cryp_hw_irq(void)
+{
+    uint8_t te = dma_get_interrupt_flag(cryp_hw_in.dma, cryp_hw_in.stream,
+                                        DMA_TEIF)
+              || dma_get_interrupt_flag(cryp_hw_out.dma, cryp_hw_out.stream,
+                                        DMA_TEIF);
+    uint8_t tc = dma_get_interrupt_flag(cryp_hw_out.dma, cryp_hw_out.stream,
+                                        DMA_TCIF);
+    S_crypHwJob *j = &cryp_hw_q[cryp_hw_first];
+    F_crypHwDone done;
+    void *arg;
+    uint8_t i;
+    int err = CRYP_HW_OK;
+
+    dma_clear_interrupt_flags(cryp_hw_in.dma, cryp_hw_in.stream,
+                              CRYP_HW_FLAGS);
+    dma_clear_interrupt_flags(cryp_hw_out.dma, cryp_hw_out.stream,
+                              CRYP_HW_FLAGS);
+    if( !cryp_hw_n ) return;
+
+    if( te )
+    {
+        // blocks are stuck in the FIFOs - the next job loads everything
+        cryp_hw_halt(&cryp_hw_in);
+        cryp_hw_halt(&cryp_hw_out);
+        crypto_stop();
+        cryp_hw_loaded = 0;
+        cryp_hw_st.errors++;
+        err = CRYP_HW_ERR_TRANSFER;
+    }
+    else if( !tc ) return;
+    else
+    {
+        cryp_hw_st.bytes += j->chunk;
+        j->in += j->chunk;
+        j->out += j->chunk;
+        j->len -= j->chunk;
+        if( j->len )
+        {
+            // the unit goes on with the same key and IV
+            cryp_hw_st.chunks++;
+            cryp_hw_run(j);
+            return;
+        }
+        // the IV of the next block, the next job of the context goes on
+        crypto_wait_busy();
+        crypto_stop();
+        if( j->x->chain )
+            for(i = 0; i < 4; i++) j->x->iv[i] = CRYP_HW_IVR(i);
+        cryp_hw_st.jobs++;
+    }
+    CRYP_DMACR = 0;
+
+    // pop before done() - it may queue the next job
+    done = j->done;
+    arg = j->arg;
+    cryp_hw_first = (cryp_hw_first + 1) % CRYP_HW_QUEUE;
+    cryp_hw_n--;
+    if( cryp_hw_n )
+    {
+        j = &cryp_hw_q[cryp_hw_first];
+        cryp_hw_load(j->x);
+        cryp_hw_run(j);
+    }
+    if( done ) done(arg, err);
+}
+
+uint32_t cryp_hw_busy(void)
+{
+    return cryp_hw_n;
+}
+
+void cryp_hw_wait(void)
+{
+    while( cryp_hw_n );
+}
+
+const S_crypHwStats *cryp_hw_stats(void)
+{
+    return &cryp_hw_st;
+}
+
+int cryp_hw_selftest(void)
+{
+    // static - SRAM, reachable by the DMA
+    static uint8_t buf[32];
+    static S_crypHwCtx x;
+    const S_crypHwKat *v;
+    uint32_t k;
+    int fails = 0;
+
+    if( !cryp_hw_ready ) return -1;
+
+    for(k = 0; k < sizeof(cryp_hw_kat) / sizeof(cryp_hw_kat[0]); k++)
+    {
+        v = &cryp_hw_kat[k];
+        // encryption in two jobs - the IV has to carry over
+        cryp_hw_ctx(&x, v->mode, 0, v->key, v->klen, v->iv);
+        if( v->split )
+        {
+            cryp_hw_queue(&x, v->pt, buf, v->split, 0, 0);
+            cryp_hw_queue(&x, v->pt + v->split, buf + v->split,
+                          v->len - v->split, 0, 0);
+        }
+        else cryp_hw_queue(&x, v->pt, buf, v->len, 0, 0);
+        cryp_hw_wait();
+        if( memcmp(buf, v->ct, v->len) )
+        {
+            fails++;
+            continue;
+        }
+        // decryption in place, one job
+        cryp_hw_ctx(&x, v->mode, 1, v->key, v->klen, v->iv);
+        cryp_hw_queue(&x, buf, buf, v->len, 0, 0);
+        cryp_hw_wait();
+        if( memcmp(buf, v->pt, v->len) ) fails++;
+    }
+    return fails;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
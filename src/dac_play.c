@@ -0,0 +1,278 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timer triggered DAC playback by DMA - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "dac_play.h"
+
+#include <libopencm3/stm32/dac.h>
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/nvic.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define DAC_PLAY_FLAGS      (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// DAC status register, not in the F4 headers
+#define DAC_PLAY_SR         MMIO32(DAC_BASE + 0x34)
+#define DAC_PLAY_SR_UDR1    (1 << 13)
+#define DAC_PLAY_SR_UDR2    (1 << 29)
+// channel 2 bits of DAC_CR are channel 1 bits << 16
+#define DAC_PLAY_CH2_SHIFT  16
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static int32_t dac_play_tsel(uint32_t tim);
+static uint32_t dac_play_dmaen(S_dacPlay *p);
+static void dac_play_halt(S_dacPlay *p);
+static void dac_play_pad(S_dacPlay *p, uint32_t idle);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// TSEL1 of the timer, F4 trigger map
+static int32_t dac_play_tsel(uint32_t tim)
+{
+    if( tim == TIM6 ) return 0;
+    if( tim == TIM8 ) return 1;
+    if( tim == TIM7 ) return 2;
+    if( tim == TIM5 ) return 3;
+    if( tim == TIM2 ) return 4;
+    if( tim == TIM4 ) return 5;
+    return -1;
+}
+
+// the channel asking the DMA - channel 1 for the dual output
+static uint32_t dac_play_dmaen(S_dacPlay *p)
+{
+    return p->out == DAC_PLAY_CH2 ? DAC_CR_DMAEN2 : DAC_CR_DMAEN1;
+}
+
+// the timer goes on, the last holding register keeps being output
+static void dac_play_halt(S_dacPlay *p)
+{
+    DAC_CR &= ~dac_play_dmaen(p);
+    DMA_SCR(p->s.dma, p->s.stream) &= ~DMA_SxCR_EN;
+    p->busy = 0;
+}
+
+// every sample of the idle half = the last sample of the other one
+static void dac_play_pad(S_dacPlay *p, uint32_t idle)
+{
+    uint8_t *dst = p->buf + idle * p->half * p->item;
+    const uint8_t *last = p->buf + ((1 - idle) * p->half + p->half - 1)
+                          * p->item;
+    uint32_t i;
+
+    for(i = 0; i < p->half; i++)
+        memcpy(dst + i * p->item, last, p->item);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_dacPlay(S_dacPlay *p, E_dacPlayOut out, uint32_t tim,
+                 uint32_t ticks, const S_dmaStream *s)
+{
+    int32_t tsel = dac_play_tsel(tim);
+    uint32_t cr, psc;
+
+    if( tsel < 0 || !ticks ) return -1;
+
+    p->out = out;
+    p->tim = tim;
+    p->s = *s;
+    p->item = out == DAC_PLAY_DUAL ? 4 : 2;
+    p->busy = 0;
+    p->stats = (S_dacPlayStats){0};
+
+    // output buffer on, no noise / triangle, trigger from the timer
+    cr = DAC_CR_EN1 | DAC_CR_TEN1 | ((uint32_t)tsel << DAC_CR_TSEL1_SHIFT)
+         | DAC_CR_DMAUDRIE1;
+    DAC_CR = 0;
+    DAC_PLAY_SR = DAC_PLAY_SR_UDR1 | DAC_PLAY_SR_UDR2;
+    if( out == DAC_PLAY_CH1 )
+        DAC_CR = cr;
+    else if( out == DAC_PLAY_CH2 )
+        DAC_CR = cr << DAC_PLAY_CH2_SHIFT;
+    else
+        // the same trigger - both holding registers move at once
+        DAC_CR = cr | ((cr & ~DAC_CR_DMAUDRIE1) << DAC_PLAY_CH2_SHIFT);
+
+    timer_disable_counter(tim);
+    psc = (ticks - 1) / 0x10000;
+    timer_set_prescaler(tim, psc);
+    timer_set_period(tim, ticks / (psc + 1) - 1);
+    timer_set_master_mode(tim, TIM_CR2_MMS_UPDATE);
+    timer_generate_event(tim, TIM_EGR_UG);
+    timer_enable_counter(tim);
+
+    nvic_set_priority(s->irqn, DAC_PLAY_PRIORITY);
+    nvic_enable_irq(s->irqn);
+    nvic_set_priority(NVIC_TIM6_DAC_IRQ, DAC_PLAY_PRIORITY);
+    nvic_enable_irq(NVIC_TIM6_DAC_IRQ);
+    return 0;
+}
+
+int dac_play_start(S_dacPlay *p, void *buf, uint32_t samples,
+                   E_dacPlayMode mode, F_dacPlayFill fill, void *arg)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t dma = p->s.dma;
+    uint8_t stream = p->s.stream;
+
+    if( p->busy || !samples || samples > 0xFFFF ) return -1;
+    if( mode == DAC_PLAY_STREAM && ((samples & 1) || !fill) ) return -1;
+
+    p->mode = mode;
+    p->buf = buf;
+    p->half = samples / 2;
+    p->fill = fill;
+    p->arg = arg;
+    p->ending = 0;
+
+    if( mode == DAC_PLAY_STREAM )
+    {
+        if( !fill(arg, p->buf, p->half) )
+        {
+            dac_play_pad(p, 1);
+            p->ending = 2;
+        }
+        else if( !fill(arg, p->buf + p->half * p->item, p->half) )
+            p->ending = 1;
+    }
+
+    DAC_CR &= ~dac_play_dmaen(p);
+    DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+    dma_clear_interrupt_flags(dma, stream, DAC_PLAY_FLAGS);
+    DAC_PLAY_SR = DAC_PLAY_SR_UDR1 | DAC_PLAY_SR_UDR2;
+
+    d.channel = p->s.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_PERIPHERAL;
+    // one sample period to deliver, 1 us at 1 MS/s
+    d.priority = DMA_SxCR_PL_VERY_HIGH;
+    d.periph_size = p->item == 4 ? DMA_SxCR_PSIZE_32BIT : DMA_SxCR_PSIZE_16BIT;
+    d.mem_size = p->item == 4 ? DMA_SxCR_MSIZE_32BIT : DMA_SxCR_MSIZE_16BIT;
+    d.mode = DMA_SxCR_MINC | (mode == DAC_PLAY_ONCE ? 0 : DMA_SxCR_CIRC);
+    d.interrupts = DMA_SxCR_TEIE;
+    if( mode == DAC_PLAY_ONCE ) d.interrupts |= DMA_SxCR_TCIE;
+    if( mode == DAC_PLAY_STREAM )
+        d.interrupts |= DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+    if( p->out == DAC_PLAY_CH1 )
+        d.periph_address = (uint32_t)&DAC_DHR12R1;
+    else if( p->out == DAC_PLAY_CH2 )
+        d.periph_address = (uint32_t)&DAC_DHR12R2;
+    else
+        d.periph_address = (uint32_t)&DAC_DHR12RD;
+    d.mem_address = (uint32_t)buf;
+    d.number = samples;
+    dma_configure(dma, stream, &d);
+
+    p->busy = 1;
+    p->stats.plays++;
+    dma_enable_stream(dma, stream);
+    DAC_CR |= dac_play_dmaen(p);
+    return 0;
+}
+
+void dac_play_stop(S_dacPlay *p)
+{
+    dac_play_halt(p);
+    dma_clear_interrupt_flags(p->s.dma, p->s.stream, DAC_PLAY_FLAGS);
+    DAC_PLAY_SR = DAC_PLAY_SR_UDR1 | DAC_PLAY_SR_UDR2;
+}
+
+void dac_play_irq(S_dacPlay *p)
+{
+    uint32_t dma = p->s.dma;
+    uint8_t stream = p->s.stream;
+    uint8_t ht = dma_get_interrupt_flag(dma, stream, DMA_HTIF);
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+    uint32_t idle;
+
+    dma_clear_interrupt_flags(dma, stream, DAC_PLAY_FLAGS);
+    if( !p->busy ) return;
+
+    if( te )
+    {
+        p->stats.errors++;
+        dac_play_halt(p);
+        return;
+    }
+    if( p->mode == DAC_PLAY_ONCE )
+    {
+        // the last sample is in the holding register, the next trigger
+        // outputs it
+        if( tc ) dac_play_halt(p);
+        return;
+    }
+    if( p->mode != DAC_PLAY_STREAM || !(ht || tc) ) return;
+    if( ht && tc ) p->stats.late++;
+
+    // the half the DMA is not in - NDTR counts down
+    idle = DMA_SNDTR(dma, stream) > p->half ? 1 : 0;
+    switch( p->ending )
+    {
+    case 0:
+        p->stats.refills++;
+        if( !p->fill(p->arg, p->buf + idle * p->half * p->item, p->half) )
+            p->ending = 1;
+        break;
+    case 1:
+        // the last half is playing, anything after it repeats its end
+        dac_play_pad(p, idle);
+        p->ending = 2;
+        break;
+    default:
+        dac_play_halt(p);
+        break;
+    }
+}
+
+void dac_play_dac_irq(S_dacPlay *p)
+{
+    uint32_t udr = DAC_PLAY_SR & (DAC_PLAY_SR_UDR1 | DAC_PLAY_SR_UDR2);
+
+    if( !udr ) return;
+    DAC_PLAY_SR = udr;
+    // a trigger right after the ONCE end is no underrun
+    if( !p->busy ) return;
+    p->stats.underruns++;
+    dac_play_halt(p);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,228 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      DMA stream/channel allocator - see dma_alloc.h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "dma_alloc.h"
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+// controller 0/1 and stream packed into one table byte
+#define DMA_SEL(ctl, stream)    (((ctl) - 1) * 8 + (stream))
+#define DMA_SEL_DMA(sel)        ((sel) < 8 ? DMA1 : DMA2)
+#define DMA_SEL_STREAM(sel)     ((sel) & 7)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+typedef struct _S_dmaMap{
+    uint8_t req;            // E_dmaReq
+    uint8_t sel;            // DMA_SEL()
+    uint8_t channel;        // 0..7
+} S_dmaMap;
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+
+// RM0090 DMA1/DMA2 request mapping, F40x peripherals only - the first free
+// entry of a request wins, so the preferred stream goes first
+static const S_dmaMap dma_map[] = {
+    // memory to memory - streams the F40x peripherals need least go first
+    {DMA_REQ_MEM, DMA_SEL(2,1), 0}, {DMA_REQ_MEM, DMA_SEL(2,5), 0},
+    {DMA_REQ_MEM, DMA_SEL(2,6), 0}, {DMA_REQ_MEM, DMA_SEL(2,7), 0},
+    {DMA_REQ_MEM, DMA_SEL(2,3), 0}, {DMA_REQ_MEM, DMA_SEL(2,2), 0},
+    {DMA_REQ_MEM, DMA_SEL(2,4), 0}, {DMA_REQ_MEM, DMA_SEL(2,0), 0},
+    // DMA1 stream 0
+    {DMA_REQ_SPI3_RX,   DMA_SEL(1,0), 0}, {DMA_REQ_I2C1_RX,   DMA_SEL(1,0), 1},
+    {DMA_REQ_TIM4_CH1,  DMA_SEL(1,0), 2}, {DMA_REQ_UART5_RX,  DMA_SEL(1,0), 4},
+    {DMA_REQ_TIM5_CH3,  DMA_SEL(1,0), 6}, {DMA_REQ_TIM5_UP,   DMA_SEL(1,0), 6},
+    // DMA1 stream 1
+    {DMA_REQ_TIM2_UP,   DMA_SEL(1,1), 3}, {DMA_REQ_TIM2_CH3,  DMA_SEL(1,1), 3},
+    {DMA_REQ_USART3_RX, DMA_SEL(1,1), 4}, {DMA_REQ_TIM5_CH4,  DMA_SEL(1,1), 6},
+    {DMA_REQ_TIM5_TRIG, DMA_SEL(1,1), 6}, {DMA_REQ_TIM6_UP,   DMA_SEL(1,1), 7},
+    // DMA1 stream 2
+    {DMA_REQ_SPI3_RX,   DMA_SEL(1,2), 0}, {DMA_REQ_TIM7_UP,   DMA_SEL(1,2), 1},
+    {DMA_REQ_I2C3_RX,   DMA_SEL(1,2), 3}, {DMA_REQ_UART4_RX,  DMA_SEL(1,2), 4},
+    {DMA_REQ_TIM3_CH4,  DMA_SEL(1,2), 5}, {DMA_REQ_TIM3_UP,   DMA_SEL(1,2), 5},
+    {DMA_REQ_TIM5_CH1,  DMA_SEL(1,2), 6}, {DMA_REQ_I2C2_RX,   DMA_SEL(1,2), 7},
+    // DMA1 stream 3
+    {DMA_REQ_SPI2_RX,   DMA_SEL(1,3), 0}, {DMA_REQ_TIM4_CH2,  DMA_SEL(1,3), 2},
+    {DMA_REQ_USART3_TX, DMA_SEL(1,3), 4}, {DMA_REQ_TIM5_CH4,  DMA_SEL(1,3), 6},
+    {DMA_REQ_TIM5_TRIG, DMA_SEL(1,3), 6}, {DMA_REQ_I2C2_RX,   DMA_SEL(1,3), 7},
+    // DMA1 stream 4
+    {DMA_REQ_SPI2_TX,   DMA_SEL(1,4), 0}, {DMA_REQ_TIM7_UP,   DMA_SEL(1,4), 1},
+    {DMA_REQ_I2C3_TX,   DMA_SEL(1,4), 3}, {DMA_REQ_UART4_TX,  DMA_SEL(1,4), 4},
+    {DMA_REQ_TIM3_CH1,  DMA_SEL(1,4), 5}, {DMA_REQ_TIM3_TRIG, DMA_SEL(1,4), 5},
+    {DMA_REQ_TIM5_CH2,  DMA_SEL(1,4), 6}, {DMA_REQ_USART3_TX, DMA_SEL(1,4), 7},
+    // DMA1 stream 5
+    {DMA_REQ_SPI3_TX,   DMA_SEL(1,5), 0}, {DMA_REQ_I2C1_RX,   DMA_SEL(1,5), 1},
+    {DMA_REQ_TIM2_CH1,  DMA_SEL(1,5), 3}, {DMA_REQ_USART2_RX, DMA_SEL(1,5), 4},
+    {DMA_REQ_TIM3_CH2,  DMA_SEL(1,5), 5}, {DMA_REQ_DAC1,      DMA_SEL(1,5), 7},
+    // DMA1 stream 6
+    {DMA_REQ_I2C1_TX,   DMA_SEL(1,6), 1}, {DMA_REQ_TIM4_UP,   DMA_SEL(1,6), 2},
+    {DMA_REQ_TIM2_CH2,  DMA_SEL(1,6), 3}, {DMA_REQ_TIM2_CH4,  DMA_SEL(1,6), 3},
+    {DMA_REQ_USART2_TX, DMA_SEL(1,6), 4}, {DMA_REQ_TIM5_UP,   DMA_SEL(1,6), 6},
+    {DMA_REQ_DAC2,      DMA_SEL(1,6), 7},
+    // DMA1 stream 7
+    {DMA_REQ_SPI3_TX,   DMA_SEL(1,7), 0}, {DMA_REQ_I2C1_TX,   DMA_SEL(1,7), 1},
+    {DMA_REQ_TIM4_CH3,  DMA_SEL(1,7), 2}, {DMA_REQ_TIM2_UP,   DMA_SEL(1,7), 3},
+    {DMA_REQ_TIM2_CH4,  DMA_SEL(1,7), 3}, {DMA_REQ_UART5_TX,  DMA_SEL(1,7), 4},
+    {DMA_REQ_TIM3_CH3,  DMA_SEL(1,7), 5}, {DMA_REQ_I2C2_TX,   DMA_SEL(1,7), 7},
+    // DMA2 stream 0
+    {DMA_REQ_ADC1,      DMA_SEL(2,0), 0}, {DMA_REQ_ADC3,      DMA_SEL(2,0), 2},
+    {DMA_REQ_SPI1_RX,   DMA_SEL(2,0), 3}, {DMA_REQ_TIM1_TRIG, DMA_SEL(2,0), 6},
+    // DMA2 stream 1
+    {DMA_REQ_DCMI,      DMA_SEL(2,1), 1}, {DMA_REQ_ADC3,      DMA_SEL(2,1), 2},
+    {DMA_REQ_USART6_RX, DMA_SEL(2,1), 5}, {DMA_REQ_TIM1_CH1,  DMA_SEL(2,1), 6},
+    {DMA_REQ_TIM8_UP,   DMA_SEL(2,1), 7},
+    // DMA2 stream 2
+    {DMA_REQ_TIM8_CH1,  DMA_SEL(2,2), 0}, {DMA_REQ_TIM8_CH2,  DMA_SEL(2,2), 0},
+    {DMA_REQ_TIM8_CH3,  DMA_SEL(2,2), 0}, {DMA_REQ_ADC2,      DMA_SEL(2,2), 1},
+    {DMA_REQ_SPI1_RX,   DMA_SEL(2,2), 3}, {DMA_REQ_USART1_RX, DMA_SEL(2,2), 4},
+    {DMA_REQ_USART6_RX, DMA_SEL(2,2), 5}, {DMA_REQ_TIM1_CH2,  DMA_SEL(2,2), 6},
+    // DMA2 stream 3
+    {DMA_REQ_ADC2,      DMA_SEL(2,3), 1}, {DMA_REQ_SPI1_TX,   DMA_SEL(2,3), 3},
+    {DMA_REQ_SDIO,      DMA_SEL(2,3), 4}, {DMA_REQ_TIM1_CH1,  DMA_SEL(2,3), 6},
+    {DMA_REQ_TIM8_CH2,  DMA_SEL(2,3), 7},
+    // DMA2 stream 4
+    {DMA_REQ_ADC1,      DMA_SEL(2,4), 0}, {DMA_REQ_TIM1_CH4,  DMA_SEL(2,4), 6},
+    {DMA_REQ_TIM1_TRIG, DMA_SEL(2,4), 6}, {DMA_REQ_TIM1_COM,  DMA_SEL(2,4), 6},
+    {DMA_REQ_TIM8_CH3,  DMA_SEL(2,4), 7},
+    // DMA2 stream 5
+    {DMA_REQ_CRYP_OUT,  DMA_SEL(2,5), 2}, {DMA_REQ_SPI1_TX,   DMA_SEL(2,5), 3},
+    {DMA_REQ_USART1_RX, DMA_SEL(2,5), 4}, {DMA_REQ_TIM1_UP,   DMA_SEL(2,5), 6},
+    // DMA2 stream 6
+    {DMA_REQ_TIM1_CH1,  DMA_SEL(2,6), 0}, {DMA_REQ_TIM1_CH2,  DMA_SEL(2,6), 0},
+    {DMA_REQ_TIM1_CH3,  DMA_SEL(2,6), 0}, {DMA_REQ_CRYP_IN,   DMA_SEL(2,6), 2},
+    {DMA_REQ_SDIO,      DMA_SEL(2,6), 4}, {DMA_REQ_USART6_TX, DMA_SEL(2,6), 5},
+    {DMA_REQ_TIM1_CH3,  DMA_SEL(2,6), 6},
+    // DMA2 stream 7
+    {DMA_REQ_DCMI,      DMA_SEL(2,7), 1}, {DMA_REQ_HASH_IN,   DMA_SEL(2,7), 2},
+    {DMA_REQ_USART1_TX, DMA_SEL(2,7), 4}, {DMA_REQ_USART6_TX, DMA_SEL(2,7), 5},
+    {DMA_REQ_TIM8_CH4,  DMA_SEL(2,7), 7}, {DMA_REQ_TIM8_TRIG, DMA_SEL(2,7), 7},
+    {DMA_REQ_TIM8_COM,  DMA_SEL(2,7), 7},
+};
+
+static const uint8_t dma_irqn[DMA_STREAM_COUNT] = {
+    NVIC_DMA1_STREAM0_IRQ, NVIC_DMA1_STREAM1_IRQ, NVIC_DMA1_STREAM2_IRQ,
+    NVIC_DMA1_STREAM3_IRQ, NVIC_DMA1_STREAM4_IRQ, NVIC_DMA1_STREAM5_IRQ,
+    NVIC_DMA1_STREAM6_IRQ, NVIC_DMA1_STREAM7_IRQ,
+    NVIC_DMA2_STREAM0_IRQ, NVIC_DMA2_STREAM1_IRQ, NVIC_DMA2_STREAM2_IRQ,
+    NVIC_DMA2_STREAM3_IRQ, NVIC_DMA2_STREAM4_IRQ, NVIC_DMA2_STREAM5_IRQ,
+    NVIC_DMA2_STREAM6_IRQ, NVIC_DMA2_STREAM7_IRQ,
+};
+
+// E_dmaReq + 1 of the owner, 0 = free
+static uint8_t dma_owner[DMA_STREAM_COUNT];
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static int dma_claim(const S_dmaMap *m, S_dmaStream *out);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// interrupts must be masked by the caller
+static int dma_claim(const S_dmaMap *m, S_dmaStream *out)
+{
+    if( dma_owner[m->sel] ) return -1;
+    dma_owner[m->sel] = m->req + 1;
+
+    out->dma = DMA_SEL_DMA(m->sel);
+    out->stream = DMA_SEL_STREAM(m->sel);
+    out->irqn = dma_irqn[m->sel];
+    out->req = m->req;
+    out->channel = DMA_SxCR_CHSEL(m->channel);
+    return 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int dma_alloc(E_dmaReq req, S_dmaStream *out)
+{
+    uint32_t i;
+    int ret = -1;
+
+    bool masked = cm_mask_interrupts(true);
+    for(i = 0; i < sizeof(dma_map) / sizeof(dma_map[0]); i++)
+    {
+        if( dma_map[i].req != req ) continue;
+        if( !dma_claim(&dma_map[i], out) )
+        {
+            ret = 0;
+            break;
+        }
+    }
+    cm_mask_interrupts(masked);
+
+    if( ret ) return ret;
+    rcc_periph_clock_enable(out->dma == DMA1 ? RCC_DMA1 : RCC_DMA2);
+    dma_stream_reset(out->dma, out->stream);
+    return 0;
+}
+
+int dma_alloc_stream(E_dmaReq req, uint32_t dma, uint8_t stream,
+                     S_dmaStream *out)
+{
+    uint32_t sel = DMA_SEL(dma == DMA1 ? 1 : 2, stream & 7);
+    uint32_t i;
+    int ret = -1;
+
+    bool masked = cm_mask_interrupts(true);
+    for(i = 0; i < sizeof(dma_map) / sizeof(dma_map[0]); i++)
+    {
+        if( dma_map[i].req != req || dma_map[i].sel != sel ) continue;
+        ret = dma_claim(&dma_map[i], out);
+        break;
+    }
+    cm_mask_interrupts(masked);
+
+    if( ret ) return ret;
+    rcc_periph_clock_enable(out->dma == DMA1 ? RCC_DMA1 : RCC_DMA2);
+    dma_stream_reset(out->dma, out->stream);
+    return 0;
+}
+
+void dma_free(const S_dmaStream *s)
+{
+    uint32_t sel = DMA_SEL(s->dma == DMA1 ? 1 : 2, s->stream & 7);
+
+    nvic_disable_irq(s->irqn);
+    dma_stream_reset(s->dma, s->stream);
+    dma_owner[sel] = 0;
+}
+
+uint32_t dma_stream_owner(uint32_t dma, uint8_t stream)
+{
+    return dma_owner[DMA_SEL(dma == DMA1 ? 1 : 2, stream & 7)];
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,334 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Software scatter-gather on the DMA double buffer mode - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "dma_chain.h"
+
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/timer.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+// what the idle target holds
+#define DMA_CHAIN_IDLE_QUEUED   0   // next segment, same length
+#define DMA_CHAIN_IDLE_CONT     1   // next segment, longer or the last one
+#define DMA_CHAIN_IDLE_STOP     2   // none - the run stops at its TC (no DBM)
+
+#define DMA_CHAIN_FLAGS     (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+// dma_chain_selftest(): untouched marker, guard items after each segment,
+// whole run timeout (DWT cycles, 10 ms at 168 MHz)
+#define DMA_CHAIN_TEST_MARK     0xFFFFu
+#define DMA_CHAIN_TEST_GUARD    2
+#define DMA_CHAIN_TEST_TIMEOUT  1680000u
+#define DMA_CHAIN_TEST_SEGS     7
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+// shorter, longer, equal (hardware switch), last - every path of the irq
+static const uint16_t dma_chain_test_len[DMA_CHAIN_TEST_SEGS] = {
+    16, 8, 24, 24, 24, 7, 32
+};
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t dma_chain_fits(const S_dmaChain *c, uint32_t j);
+static uint32_t dma_chain_idle_for(S_dmaChain *c, uint32_t j);
+static void dma_chain_run(S_dmaChain *c, uint32_t i, uint32_t skip);
+static void dma_chain_finish(S_dmaChain *c, int err);
+static void dma_chain_test_done(void *arg, int err);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// segment j can be the idle target of the running NDTR - a late TC
+// interrupt lets the DMA move up to c->len items into it
+static uint32_t dma_chain_fits(const S_dmaChain *c, uint32_t j)
+{
+    return j < c->nseg && c->seg[j].count >= c->len;
+}
+
+// address for the idle target when segment j comes next, 0 - none
+static uint32_t dma_chain_idle_for(S_dmaChain *c, uint32_t j)
+{
+    if( !dma_chain_fits(c, j) )
+    {
+        c->idle = DMA_CHAIN_IDLE_STOP;
+        return 0;
+    }
+    // a hardware switch only when the segment after j fits as well - the
+    // last segment is always restarted without DBM, nothing runs after it
+    c->idle = (c->seg[j].count == c->len && dma_chain_fits(c, j + 1))
+            ? DMA_CHAIN_IDLE_QUEUED : DMA_CHAIN_IDLE_CONT;
+    return (uint32_t)c->seg[j].addr;
+}
+
+// (re)starts the stream on segment i, skip items of it already moved
+static void dma_chain_run(S_dmaChain *c, uint32_t i, uint32_t skip)
+{
+    struct dma_stream_desc d = c->desc;
+
+    c->act = i;
+    c->len = c->seg[i].count - skip;
+    d.mem_address = (uint32_t)c->seg[i].addr + skip * c->item;
+    d.mem_address_1 = dma_chain_idle_for(c, i + 1);
+    if( c->idle == DMA_CHAIN_IDLE_STOP ) d.mode &= ~DMA_SxCR_DBM;
+    d.number = c->len;
+    dma_configure(c->s.dma, c->s.stream, &d);
+    dma_enable_stream(c->s.dma, c->s.stream);
+}
+
+static void dma_chain_finish(S_dmaChain *c, int err)
+{
+    DMA_SCR(c->s.dma, c->s.stream) &= ~DMA_SxCR_EN;
+    dma_clear_interrupt_flags(c->s.dma, c->s.stream, DMA_CHAIN_FLAGS);
+    c->busy = 0;
+    if( c->done ) c->done(c->arg, err);
+}
+
+static void dma_chain_test_done(void *arg, int err)
+{
+    *(int *)arg = err;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_dmaChain(S_dmaChain *c, const S_dmaStream *s,
+                  const struct dma_stream_desc *tmpl)
+{
+    uint32_t psize = (tmpl->periph_size & DMA_SxCR_PSIZE_MASK)
+                   >> DMA_SxCR_PSIZE_SHIFT;
+    uint32_t msize = (tmpl->mem_size & DMA_SxCR_MSIZE_MASK)
+                   >> DMA_SxCR_MSIZE_SHIFT;
+
+    if( s->req == DMA_REQ_MEM ) return -1;
+    if( tmpl->direction == DMA_SxCR_DIR_MEM_TO_MEM ) return -1;
+    if( psize != msize ) return -1;
+
+    c->s = *s;
+    c->desc = *tmpl;
+    c->desc.channel = s->channel;
+    c->desc.mode = (tmpl->mode & ~(DMA_SxCR_CIRC | DMA_SxCR_CT))
+                 | DMA_SxCR_DBM | DMA_SxCR_MINC;
+    c->desc.interrupts = DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    c->item = 1u << psize;
+    c->busy = 0;
+    c->stats = (S_dmaChainStats){0};
+    c->stats.gap_min = UINT32_MAX;
+
+    dwt_enable_cycle_counter();
+    nvic_enable_irq(s->irqn);
+    return 0;
+}
+
+int dma_chain_start(S_dmaChain *c, const S_dmaSeg *seg, uint32_t nseg,
+                    F_dmaChainDone done, void *arg)
+{
+    if( c->busy || !nseg ) return -1;
+    c->seg = seg;
+    c->nseg = nseg;
+    c->done = done;
+    c->arg = arg;
+    c->busy = 1;
+    dma_chain_run(c, 0, 0);
+    return 0;
+}
+
+void dma_chain_irq(S_dmaChain *c)
+{
+    uint32_t t = DWT_CYCCNT;
+    uint32_t dma = c->s.dma;
+    uint8_t st = c->s.stream;
+
+    if( dma_get_interrupt_flag(dma, st, DMA_TEIF) )
+    {
+        dma_chain_finish(c, DMA_CHAIN_ERR_TRANSFER);
+        return;
+    }
+    if( !dma_get_interrupt_flag(dma, st, DMA_TCIF) ) return;
+    dma_clear_interrupt_flags(dma, st, DMA_CHAIN_FLAGS);
+    if( !c->busy ) return;
+    c->stats.segments++;
+
+    if( c->idle == DMA_CHAIN_IDLE_STOP )
+    {
+        // the stream stopped by itself, nothing went anywhere else
+        if( c->act + 1 >= c->nseg )
+        {
+            dma_chain_finish(c, DMA_CHAIN_OK);
+            return;
+        }
+        dma_chain_run(c, c->act + 1, 0);
+    }
+    else if( c->idle == DMA_CHAIN_IDLE_QUEUED )
+    {
+        // the DMA switched on its own, refill the target it just left
+        uint32_t next;
+        c->act++;
+        c->stats.switches++;
+        next = dma_chain_idle_for(c, c->act + 1);
+        if( DMA_SCR(dma, st) & DMA_SxCR_CT )
+            DMA_SM0AR(dma, st) = (void *)next;
+        else
+            DMA_SM1AR(dma, st) = (void *)next;
+
+        // act ended meanwhile - the DMA may have re-sent the old target
+        if( dma_get_interrupt_flag(dma, st, DMA_TCIF) )
+        {
+            c->stats.late++;
+            dma_chain_finish(c, DMA_CHAIN_ERR_LATE);
+            return;
+        }
+        t = DWT_CYCCNT - t;
+        if( t > c->stats.refill_max ) c->stats.refill_max = t;
+        return;
+    }
+    else
+    {
+        // the DMA went on into a longer segment or into the last one - stop
+        // it and see how far it got (never past the segment, it fits).
+        // A TC before the stop means it ran through segment j already
+        uint32_t j = c->act + 1;
+        uint32_t late = dma_get_interrupt_flag(dma, st, DMA_TCIF);
+        DMA_SCR(dma, st) &= ~DMA_SxCR_EN;
+        while( DMA_SCR(dma, st) & DMA_SxCR_EN );
+        // the stop sets TCIF by itself (RM0090 transfer suspension)
+        dma_clear_interrupt_flags(dma, st, DMA_CHAIN_FLAGS);
+        uint32_t slipped = c->len - DMA_SNDTR(dma, st);
+        // a switch back between the check and the stop leaves segment j
+        volatile void *cur = (DMA_SCR(dma, st) & DMA_SxCR_CT)
+                           ? DMA_SM1AR(dma, st) : DMA_SM0AR(dma, st);
+        if( late || cur != c->seg[j].addr )
+        {
+            c->stats.late++;
+            dma_chain_finish(c, DMA_CHAIN_ERR_LATE);
+            return;
+        }
+        c->stats.slipped += slipped;
+
+        if( slipped == c->seg[j].count )
+        {
+            c->stats.segments++;
+            slipped = 0;
+            if( ++j >= c->nseg )
+            {
+                dma_chain_finish(c, DMA_CHAIN_OK);
+                return;
+            }
+        }
+        dma_chain_run(c, j, slipped);
+    }
+
+    t = DWT_CYCCNT - t;
+    c->stats.restarts++;
+    c->stats.gap_sum += t;
+    if( t < c->stats.gap_min ) c->stats.gap_min = t;
+    if( t > c->stats.gap_max ) c->stats.gap_max = t;
+}
+
+void dma_chain_abort(S_dmaChain *c)
+{
+    DMA_SCR(c->s.dma, c->s.stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(c->s.dma, c->s.stream) & DMA_SxCR_EN );
+    dma_clear_interrupt_flags(c->s.dma, c->s.stream, DMA_CHAIN_FLAGS);
+    c->busy = 0;
+}
+
+int dma_chain_selftest(void)
+{
+    static uint16_t buf[200];
+    static S_dmaChain c;
+    S_dmaSeg seg[DMA_CHAIN_TEST_SEGS];
+    struct dma_stream_desc d = {0};
+    S_dmaStream s;
+    uint32_t i, k, n, t;
+    int err = -1;
+
+    if( dma_alloc(DMA_REQ_TIM6_UP, &s) ) return -1;
+    for(i = 0; i < sizeof(buf) / 2; i++) buf[i] = DMA_CHAIN_TEST_MARK;
+    for(i = 0, n = 0; i < DMA_CHAIN_TEST_SEGS; i++)
+    {
+        seg[i].addr = &buf[n];
+        seg[i].count = dma_chain_test_len[i];
+        n += dma_chain_test_len[i] + DMA_CHAIN_TEST_GUARD;
+    }
+
+    // TIM6 update every 1 us requests one CNT read (0..83, never the mark)
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_16BIT;
+    d.mem_size = DMA_SxCR_MSIZE_16BIT;
+    d.periph_address = (uint32_t)&TIM_CNT(TIM6);
+    INIT_dmaChain(&c, &s, &d);
+    // polled below - the stream has no isr of its own
+    nvic_disable_irq(s.irqn);
+
+    rcc_periph_clock_enable(RCC_TIM6);
+    timer_set_prescaler(TIM6, 0);
+    timer_set_period(TIM6, 83);
+    timer_enable_irq(TIM6, TIM_DIER_UDE);
+    dma_chain_start(&c, seg, DMA_CHAIN_TEST_SEGS, dma_chain_test_done, &err);
+    timer_enable_counter(TIM6);
+
+    t = DWT_CYCCNT;
+    while( c.busy && DWT_CYCCNT - t < DMA_CHAIN_TEST_TIMEOUT )
+    {
+        if( dma_get_interrupt_flag(s.dma, s.stream, DMA_TCIF | DMA_TEIF) )
+            dma_chain_irq(&c);
+    }
+    if( c.busy )
+    {
+        dma_chain_abort(&c);
+        err = -3;
+    }
+    timer_disable_counter(TIM6);
+    timer_disable_irq(TIM6, TIM_DIER_UDE);
+    dma_free(&s);
+    if( err ) return err;
+
+    // every item once, nothing in the guards or after the list
+    for(i = 0, n = 0; i < DMA_CHAIN_TEST_SEGS; i++)
+    {
+        for(k = 0; k < dma_chain_test_len[i]; k++, n++)
+            if( buf[n] == DMA_CHAIN_TEST_MARK ) return -2;
+        for(k = 0; k < DMA_CHAIN_TEST_GUARD; k++, n++)
+            if( buf[n] != DMA_CHAIN_TEST_MARK ) return -2;
+    }
+    for(; n < sizeof(buf) / 2; n++)
+        if( buf[n] != DMA_CHAIN_TEST_MARK ) return -2;
+    return 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
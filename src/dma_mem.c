@@ -0,0 +1,392 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Asynchronous memcpy/memset on DMA2 - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "dma_mem.h"
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/nvic.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define DMA_MEM_FLAGS       (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// NDTR is 16 bits, keep burst chunks a multiple of the 16-byte burst
+#define DMA_MEM_NDTR_MAX    0xFFF0u
+#define DMA_MEM_BURST_BYTES 16u
+
+// core coupled memory - on the D-bus only, the DMA cannot reach it
+#define DMA_MEM_CCM_START   0x10000000u
+#define DMA_MEM_CCM_END     0x10010000u
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+typedef struct _S_dmaMemJob{
+    uint8_t *dst;
+    const uint8_t *src;     // 0 for memset
+    uint32_t len;           // bytes left
+    uint32_t chunk;         // bytes of the running NDTR load
+    uint8_t fill;
+    F_dmaMemDone done;
+    void *arg;
+} S_dmaMemJob;
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static S_dmaStream dma_mem_s;
+static uint32_t dma_mem_ready = 0;
+static uint32_t dma_mem_threshold = DMA_MEM_THRESHOLD;
+
+// ring of jobs, the one at dma_mem_first runs
+static S_dmaMemJob dma_mem_q[DMA_MEM_QUEUE];
+static uint32_t dma_mem_first = 0;
+static volatile uint32_t dma_mem_n = 0;
+
+// memset source - in .bss, so in SRAM and reachable by the DMA
+static uint32_t dma_mem_pattern;
+
+static S_dmaMemStats dma_mem_st;
+static uint32_t dma_mem_irq_last;
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t dma_mem_in_ccm(const void *p, uint32_t len);
+static uint32_t dma_mem_can_wait(bool masked);
+static void dma_mem_run(S_dmaMemJob *j);
+static int dma_mem_queue(uint8_t *dst, const uint8_t *src, uint8_t fill,
+                         uint32_t len, F_dmaMemDone done, void *arg);
+static void dma_mem_bench_done(void *arg, int err);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t dma_mem_in_ccm(const void *p, uint32_t len)
+{
+    uint32_t a = (uint32_t)p;
+    return a < DMA_MEM_CCM_END && a + len > DMA_MEM_CCM_START;
+}
+
+// thread mode with interrupts on - the queue drains while we spin
+static uint32_t dma_mem_can_wait(bool masked)
+{
+    uint32_t ipsr;
+    __asm__ volatile("mrs %0, ipsr" : "=r" (ipsr));
+    return !masked && !(ipsr & 0x1FF);
+}
+
+// loads the next NDTR chunk of job j and enables the stream
+static void dma_mem_run(S_dmaMemJob *j)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t align = (uint32_t)j->dst | j->len;
+    uint32_t item, max;
+
+    if( j->src ) align |= (uint32_t)j->src;
+    else
+    {
+        dma_mem_pattern = j->fill * 0x01010101u;
+        align |= (uint32_t)&dma_mem_pattern;
+    }
+
+    if( !(align & 3) )
+    {
+        item = 4;
+        d.periph_size = DMA_SxCR_PSIZE_32BIT;
+        d.mem_size = DMA_SxCR_MSIZE_32BIT;
+    }
+    else if( !(align & 1) )
+    {
+        item = 2;
+        d.periph_size = DMA_SxCR_PSIZE_16BIT;
+        d.mem_size = DMA_SxCR_MSIZE_16BIT;
+    }
+    else
+    {
+        item = 1;
+        d.periph_size = DMA_SxCR_PSIZE_8BIT;
+        d.mem_size = DMA_SxCR_MSIZE_8BIT;
+    }
+
+    max = DMA_MEM_NDTR_MAX * item;
+    if( !(align & (DMA_MEM_BURST_BYTES - 1)) )
+    {
+        // 16 bytes = INCR4 words / INCR8 halfwords / INCR16 bytes; from
+        // 16-byte aligned addresses a burst never crosses a 1 KB boundary
+        static const uint32_t burst[5] = {0,
+            DMA_SxCR_PBURST_INCR16 | DMA_SxCR_MBURST_INCR16,
+            DMA_SxCR_PBURST_INCR8 | DMA_SxCR_MBURST_INCR8, 0,
+            DMA_SxCR_PBURST_INCR4 | DMA_SxCR_MBURST_INCR4};
+        d.periph_burst = burst[item] & DMA_SxCR_PBURST_MASK;
+        d.mem_burst = burst[item] & DMA_SxCR_MBURST_MASK;
+        if( !j->src ) d.periph_burst = DMA_SxCR_PBURST_SINGLE;
+        dma_mem_st.bursts += (j->chunk == 0);
+    }
+    j->chunk = j->len < max ? j->len : max;
+
+    d.channel = dma_mem_s.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_MEM;
+    // peripheral streams go first
+    d.priority = DMA_SxCR_PL_LOW;
+    d.mode = DMA_SxCR_MINC | (j->src ? DMA_SxCR_PINC : 0);
+    d.interrupts = DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.fifo = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH_4_4_FULL;
+    // memory-to-memory: the peripheral port is the source
+    d.periph_address = j->src ? (uint32_t)j->src : (uint32_t)&dma_mem_pattern;
+    d.mem_address = (uint32_t)j->dst;
+    d.number = j->chunk / item;
+
+    dma_configure(dma_mem_s.dma, dma_mem_s.stream, &d);
+    dma_enable_stream(dma_mem_s.dma, dma_mem_s.stream);
+}
+
+static int dma_mem_queue(uint8_t *dst, const uint8_t *src, uint8_t fill,
+                         uint32_t len, F_dmaMemDone done, void *arg)
+{
+    S_dmaMemJob *j;
+    uint32_t ccm = dma_mem_in_ccm(dst, len)
+                || (src && dma_mem_in_ccm(src, len));
+
+    // NDTR 0 would never end - and a queued one would stall the queue
+    if( !len )
+    {
+        if( done ) done(arg, DMA_MEM_OK);
+        return 0;
+    }
+    bool masked = cm_mask_interrupts(true);
+    // CCM is out of the DMA's reach, the CPU copy must not overtake the
+    // queued jobs - wait for them, or refuse when they cannot drain
+    while( ccm && dma_mem_n )
+    {
+        cm_mask_interrupts(masked);
+        if( !dma_mem_can_wait(masked) )
+        {
+            dma_mem_st.ccm_refused++;
+            return -1;
+        }
+        dma_mem_wait();
+        masked = cm_mask_interrupts(true);
+    }
+    // a small job still queues behind running ones to keep the order
+    if( !dma_mem_n && (len < dma_mem_threshold || !dma_mem_ready || ccm) )
+    {
+        cm_mask_interrupts(masked);
+        if( src ) memcpy(dst, src, len);
+        else memset(dst, fill, len);
+        dma_mem_st.cpu_jobs++;
+        dma_mem_st.cpu_bytes += len;
+        if( done ) done(arg, DMA_MEM_OK);
+        return 0;
+    }
+    if( dma_mem_n >= DMA_MEM_QUEUE )
+    {
+        dma_mem_st.full++;
+        cm_mask_interrupts(masked);
+        return -1;
+    }
+
+    j = &dma_mem_q[(dma_mem_first + dma_mem_n) % DMA_MEM_QUEUE];
+    j->dst = dst;
+    j->src = src;
+    j->fill = fill;
+    j->len = len;
+    j->chunk = 0;
+    j->done = done;
+    j->arg = arg;
+    if( dma_mem_n++ == 0 ) dma_mem_run(j);
+    cm_mask_interrupts(masked);
+    return 0;
+}
+
+static void dma_mem_bench_done(void *arg, int err)
+{
+    (void)err;
+    *(volatile uint32_t *)arg = DWT_CYCCNT;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_dmaMem(void)
+{
+    if( dma_mem_ready ) return 0;
+    if( dma_alloc(DMA_REQ_MEM, &dma_mem_s) ) return -1;
+    dwt_enable_cycle_counter();
+    nvic_enable_irq(dma_mem_s.irqn);
+    dma_mem_ready = 1;
+    return 0;
+}
+
+const S_dmaStream *dma_mem_stream(void)
+{
+    return dma_mem_ready ? &dma_mem_s : 0;
+}
+
+void dma_mem_irq(void)
+{
+    uint32_t t = DWT_CYCCNT;
+    uint32_t dma = dma_mem_s.dma;
+    uint8_t st = dma_mem_s.stream;
+    S_dmaMemJob *j = &dma_mem_q[dma_mem_first];
+    F_dmaMemDone done;
+    void *arg;
+    int err = DMA_MEM_OK;
+
+    if( dma_get_interrupt_flag(dma, st, DMA_TEIF) )
+    {
+        DMA_SCR(dma, st) &= ~DMA_SxCR_EN;
+        dma_mem_st.errors++;
+        err = DMA_MEM_ERR_TRANSFER;
+    }
+    else if( !dma_get_interrupt_flag(dma, st, DMA_TCIF) ) return;
+    dma_clear_interrupt_flags(dma, st, DMA_MEM_FLAGS);
+    if( !dma_mem_n ) return;
+
+    if( !err )
+    {
+        dma_mem_st.dma_bytes += j->chunk;
+        j->dst += j->chunk;
+        if( j->src ) j->src += j->chunk;
+        j->len -= j->chunk;
+    }
+    if( !err && j->len )
+    {
+        dma_mem_st.chunks++;
+        dma_mem_run(j);
+    }
+    else
+    {
+        // pop before done() - it may queue the next job
+        dma_mem_st.dma_jobs++;
+        done = j->done;
+        arg = j->arg;
+        dma_mem_first = (dma_mem_first + 1) % DMA_MEM_QUEUE;
+        dma_mem_n--;
+        if( dma_mem_n ) dma_mem_run(&dma_mem_q[dma_mem_first]);
+        if( done ) done(arg, err);
+    }
+
+    t = DWT_CYCCNT - t;
+    dma_mem_irq_last = t;
+    if( t > dma_mem_st.irq_max ) dma_mem_st.irq_max = t;
+}
+
+int dma_memcpy(void *dst, const void *src, uint32_t len,
+               F_dmaMemDone done, void *arg)
+{
+    return dma_mem_queue(dst, src, 0, len, done, arg);
+}
+
+int dma_memset(void *dst, uint8_t c, uint32_t len,
+               F_dmaMemDone done, void *arg)
+{
+    return dma_mem_queue(dst, 0, c, len, done, arg);
+}
+
+uint32_t dma_mem_busy(void)
+{
+    return dma_mem_n;
+}
+
+void dma_mem_wait(void)
+{
+    while( dma_mem_n );
+}
+
+void dma_mem_set_threshold(uint32_t bytes)
+{
+    dma_mem_threshold = bytes;
+}
+
+const S_dmaMemStats *dma_mem_stats(void)
+{
+    return &dma_mem_st;
+}
+
+uint32_t dma_mem_bench(void *scratch, uint32_t size, S_dmaMemBench *out)
+{
+    S_dmaMemBench b;
+    uint8_t *src = scratch;
+    uint8_t *dst = src + (size / 2 & ~15u);
+    uint32_t k, r, n, t, c;
+    // written by the interrupt, read back through a volatile access
+    uint32_t end;
+
+    b.steps = 0;
+    b.crossover = 0;
+    dma_mem_wait();
+    if( !dma_mem_ready || dma_mem_in_ccm(scratch, size) )
+    {
+        // no DMA - everything stays on the CPU
+        dma_mem_threshold = UINT32_MAX;
+        if( out ) *out = b;
+        return dma_mem_threshold;
+    }
+
+    dma_mem_threshold = 0;
+    for(k = 0; k < DMA_MEM_BENCH_STEPS; k++)
+    {
+        S_dmaMemBenchPoint *p = &b.p[k];
+        n = 16u << k;
+        if( src + n > dst ) break;
+        p->size = n;
+        p->cpu = p->issue = p->latency = UINT32_MAX;
+
+        // best of 4 - an unrelated interrupt only makes a run longer
+        for(r = 0; r < 4; r++)
+        {
+            t = DWT_CYCCNT;
+            memcpy(dst, src, n);
+            c = DWT_CYCCNT - t;
+            if( c < p->cpu ) p->cpu = c;
+
+            *(volatile uint32_t *)&end = 0;
+            t = DWT_CYCCNT;
+            dma_memcpy(dst, src, n, dma_mem_bench_done, &end);
+            c = DWT_CYCCNT - t;
+            while( !*(volatile uint32_t *)&end );
+            c += dma_mem_irq_last;
+            if( c < p->issue ) p->issue = c;
+            c = end - t;
+            if( c < p->latency ) p->latency = c;
+        }
+        b.steps++;
+        if( !b.crossover && p->issue < p->cpu ) b.crossover = n;
+    }
+
+    // DMA never paid off - keep jobs up to the largest measured size on CPU
+    if( !b.crossover ) b.crossover = b.steps ? b.p[b.steps - 1].size * 2
+                                             : DMA_MEM_THRESHOLD;
+    dma_mem_threshold = b.crossover;
+    if( out ) *out = b;
+    return b.crossover;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,181 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Edge records from timer input capture and DMA - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "edge_cap.h"
+
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define EDGE_CAP_FLAGS      (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+// CCxS = 01 - ICx mapped on its own TIx
+static const enum tim_ic_input edge_cap_input[4] = {
+    TIM_IC_IN_TI1, TIM_IC_IN_TI2, TIM_IC_IN_TI3, TIM_IC_IN_TI4
+};
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void edge_cap_drain(S_edgeSrc *s);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// converts the captures written since the last drain - from edge_read()
+static void edge_cap_drain(S_edgeSrc *s)
+{
+    S_edgeCap *c = (S_edgeCap *)s;
+    uint32_t dma = c->s.dma;
+    uint8_t stream = c->s.stream;
+    uint32_t of = TIM_SR_CC1OF << (c->ch - 1);
+    uint32_t w, left, level, k, i, t;
+    uint16_t flags = 0;
+
+    // ring position and pin level of the same moment: an edge before the
+    // level sample reaches the ring within the filter + DMA latency, so the
+    // position is read EDGE_CAP_SETTLE later; an edge meanwhile changes the
+    // level and the pair is taken again
+    do
+    {
+        level = gpio_get(c->port, c->pin) != 0;
+        t = DWT_CYCCNT;
+        while( DWT_CYCCNT - t < EDGE_CAP_SETTLE );
+        w = c->wraps;
+        left = DMA_SNDTR(dma, stream);
+    } while( w != c->wraps || left != DMA_SNDTR(dma, stream)
+             || level != (gpio_get(c->port, c->pin) != 0) );
+
+    k = w * c->n + (c->n - left) - c->done;
+    // NDTR reloaded but the wrap not counted yet - next time
+    if( (int32_t)k <= 0 ) return;
+
+    if( TIM_SR(c->tim) & of )
+    {
+        TIM_SR(c->tim) = ~of;
+        c->stats.overcaptures++;
+        flags = EDGE_LOST;
+    }
+    if( k > c->n )
+    {
+        c->stats.lapped += k - c->n;
+        c->done += k - c->n;
+        k = c->n;
+        flags = EDGE_LOST;
+    }
+
+    for(i = 0; i < k; i++)
+    {
+        uint32_t cnt = c->raw[(c->done + i) & (c->n - 1)];
+        edge_push(s, cnt * EDGE_CAP_MUL + c->offset,
+                  level ^ ((k - 1 - i) & 1), i ? 0 : flags);
+    }
+    c->done += k;
+    c->stats.edges += k;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_edgeCap(S_edgeCap *c, S_edgeRing *r, uint8_t id, uint32_t tim,
+                  uint8_t ch, const S_dmaStream *s, uint32_t *raw, uint32_t n,
+                  uint32_t port, uint16_t pin)
+{
+    struct dma_stream_desc d = {0};
+    enum tim_ic_id ic = (enum tim_ic_id)(ch - 1);
+    uint32_t t0, c0;
+
+    c->tim = tim;
+    c->ch = ch;
+    c->s = *s;
+    c->port = port;
+    c->pin = pin;
+    c->raw = raw;
+    c->n = n;
+    c->wraps = 0;
+    c->done = 0;
+    c->stats = (S_edgeCapStats){0};
+
+    // free running over the full 32 bits, shared by the other channels
+    if( !(TIM_CR1(tim) & TIM_CR1_CEN) )
+    {
+        timer_set_prescaler(tim, 0);
+        timer_set_period(tim, 0xFFFFFFFF);
+        timer_generate_event(tim, TIM_EGR_UG);
+        timer_enable_counter(tim);
+    }
+
+    timer_ic_set_input(tim, ic, edge_cap_input[ic]);
+    timer_ic_set_filter(tim, ic, EDGE_CAP_FILTER);
+    // CCxP + CCxNP - both edges
+    TIM_CCER(tim) |= (TIM_CCER_CC1P | TIM_CCER_CC1NP | TIM_CCER_CC1E)
+                     << (4 * ic);
+
+    d.channel = s->channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_VERY_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_32BIT;
+    d.mem_size = DMA_SxCR_MSIZE_32BIT;
+    d.mode = DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    d.interrupts = DMA_SxCR_TCIE;
+    d.periph_address = (uint32_t)&TIM_CCR1(tim) + 4 * ic;
+    d.mem_address = (uint32_t)raw;
+    d.number = n;
+    dma_configure(s->dma, s->stream, &d);
+    dma_enable_stream(s->dma, s->stream);
+    nvic_enable_irq(s->irqn);
+
+    dwt_enable_cycle_counter();
+    bool masked = cm_mask_interrupts(true);
+    t0 = DWT_CYCCNT;
+    c0 = TIM_CNT(tim);
+    c->offset = t0 - c0 * EDGE_CAP_MUL;
+    cm_mask_interrupts(masked);
+
+    edge_src_add(r, &c->src, id, edge_cap_drain);
+    TIM_SR(tim) = ~(TIM_SR_CC1OF << ic);
+    timer_enable_irq(tim, TIM_DIER_CC1DE << ic);
+}
+
+void edge_cap_dma_irq(S_edgeCap *c)
+{
+    if( dma_get_interrupt_flag(c->s.dma, c->s.stream, DMA_TCIF) ) c->wraps++;
+    dma_clear_interrupt_flags(c->s.dma, c->s.stream, EDGE_CAP_FLAGS);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
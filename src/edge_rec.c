@@ -0,0 +1,157 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Timestamped edge records, EXTI source - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "edge_rec.h"
+
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/exti.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint8_t edge_exti_irqn(uint16_t pin);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint8_t edge_exti_irqn(uint16_t pin)
+{
+    uint32_t line = __builtin_ctz(pin);
+
+    if( line < 5 ) return NVIC_EXTI0_IRQ + line;
+    if( line < 10 ) return NVIC_EXTI9_5_IRQ;
+    return NVIC_EXTI15_10_IRQ;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_edgeRing(S_edgeRing *r, S_edge *buf, uint32_t size)
+{
+    r->buf = buf;
+    r->mask = size - 1;
+    r->head = r->tail = 0;
+    r->lost = 0;
+    r->drops = 0;
+    r->srcs = 0;
+    dwt_enable_cycle_counter();
+}
+
+void edge_src_add(S_edgeRing *r, S_edgeSrc *s, uint8_t id, F_edgeDrain drain)
+{
+    s->ring = r;
+    s->id = id;
+    s->drain = drain;
+
+    bool masked = cm_mask_interrupts(true);
+    s->next = r->srcs;
+    r->srcs = s;
+    cm_mask_interrupts(masked);
+}
+
+void edge_push(S_edgeSrc *s, uint32_t t, uint8_t level, uint16_t flags)
+{
+    S_edgeRing *r = s->ring;
+    S_edge *e;
+
+    // EXTI lines of different priorities share the ring
+    bool masked = cm_mask_interrupts(true);
+    if( r->head - r->tail > r->mask )
+    {
+        r->drops++;
+        r->lost = 1;
+    }
+    else
+    {
+        e = &r->buf[r->head & r->mask];
+        e->t = t;
+        e->src = s->id;
+        e->level = level;
+        e->flags = flags | (r->lost ? EDGE_LOST : 0);
+        r->lost = 0;
+        r->head++;
+    }
+    cm_mask_interrupts(masked);
+}
+
+uint32_t edge_read(S_edgeRing *r, S_edge *out, uint32_t max)
+{
+    S_edgeSrc *s;
+    uint32_t n = 0;
+    uint32_t tail = r->tail;
+
+    for(s = r->srcs; s; s = s->next)
+        if( s->drain ) s->drain(s);
+
+    while( n < max && tail != r->head )
+        out[n++] = r->buf[tail++ & r->mask];
+    r->tail = tail;
+    return n;
+}
+
+void INIT_edgeExti(S_edgeExti *e, S_edgeRing *r, uint8_t id, uint32_t port,
+                   uint16_t pin)
+{
+    uint8_t irqn = edge_exti_irqn(pin);
+
+    e->port = port;
+    e->pin = pin;
+    edge_src_add(r, &e->src, id, 0);
+
+    rcc_periph_clock_enable(RCC_SYSCFG);
+    exti_select_source(pin, port);
+    exti_set_trigger(pin, EXTI_TRIGGER_BOTH);
+    exti_reset_request(pin);
+    exti_enable_request(pin);
+    nvic_set_priority(irqn, EDGE_EXTI_PRIORITY);
+    nvic_enable_irq(irqn);
+}
+
+void edge_exti_irq(S_edgeExti *e)
+{
+    // stamp first - everything after it is latency of the next edge
+    uint32_t t = DWT_CYCCNT;
+
+    if( !exti_get_flag_status(e->pin) ) return;
+    exti_reset_request(e->pin);
+    edge_push(&e->src, t, gpio_get(e->port, e->pin) != 0, 0);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,218 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Fault handlers dumping into backup SRAM - see fault_dump.h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "fault_dump.h"
+#include "waitin.h"
+
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/mpu.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/stm32/memorymap.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/pwr.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define FAULT_DUMP          ((volatile S_faultDump *)BKPSRAM_BASE)
+// SRAM1+SRAM2, the linker puts both stacks there
+#define FAULT_RAM_START     0x20000000u
+#define FAULT_STR_(x)       #x
+#define FAULT_STR(x)        FAULT_STR_(x)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+// the fault handlers run here, the faulting stack may be overflowed
+static uint32_t fault_istack[FAULT_ISTACK_BYTES / 4] __attribute__((used));
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+// end of RAM, from the libopencm3 linker script
+extern unsigned _stack;
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t fault_checksum(volatile S_faultDump *d);
+static int fault_in_ram(uint32_t addr, uint32_t bytes);
+static void fault_capture(uint32_t *frame, uint32_t exc_return,
+                          uint32_t *r4_r11, uint32_t msp)
+    __attribute__((used, noreturn));
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t fault_checksum(volatile S_faultDump *d)
+{
+    volatile uint32_t *w = (volatile uint32_t *)d;
+    uint32_t n = sizeof(S_faultDump) / 4;
+    uint32_t sum = 0;
+    uint32_t i;
+    for(i = 0; i < n; i++)
+        if( &w[i] != &d->checksum ) sum += w[i];
+    return ~sum;
+}
+
+static int fault_in_ram(uint32_t addr, uint32_t bytes)
+{
+    uint32_t end = (uint32_t)&_stack;
+    return addr >= FAULT_RAM_START && addr <= end && bytes <= end - addr;
+}
+
+static void fault_capture(uint32_t *frame, uint32_t exc_return,
+                          uint32_t *r4_r11, uint32_t msp)
+{
+    volatile S_faultDump *d = FAULT_DUMP;
+    uint32_t fr = (uint32_t)frame;
+    uint32_t ipsr;
+    uint32_t psp;
+    uint32_t i;
+
+    __asm__ volatile("mrs %0, ipsr" : "=r" (ipsr));
+    __asm__ volatile("mrs %0, psp" : "=r" (psp));
+
+    // MemManage/BusFault/UsageFault run with the MPU on (only HardFault has
+    // it off) - the stack guard must not stop the stack copy below
+    MPU_CTRL = 0;
+    __asm__ volatile("dsb\n isb" ::: "memory");
+
+    // the fault may come before INIT_faultDump()
+    RCC_APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR_CR |= PWR_CR_DBP;
+    RCC_AHB1ENR |= RCC_AHB1ENR_BKPSRAMEN;
+
+    if( d->magic == FAULT_MAGIC && d->version == FAULT_VERSION
+        && d->checksum == fault_checksum(d) )
+        d->count++;
+    else
+        d->count = 1;
+
+    d->magic = FAULT_MAGIC;
+    d->version = FAULT_VERSION;
+    d->size = sizeof(S_faultDump);
+    d->acked = 0;
+    d->exc_number = ipsr & 0x1FF;
+    d->exc_return = exc_return;
+    d->msp = msp;
+    d->psp = psp;
+    d->cfsr = SCB_CFSR;
+    d->hfsr = SCB_HFSR;
+    d->mmfar = SCB_MMFAR;
+    d->bfar = SCB_BFAR;
+    d->shcsr = SCB_SHCSR;
+    d->cycle = DWT_CYCCNT;
+    d->tick = system_tick;
+    for(i = 0; i < 8; i++)
+        d->r4_r11[i] = r4_r11[i];
+
+    d->flags = (exc_return & (1 << 2)) ? FAULT_FRAME_PSP : 0;
+    if( !(exc_return & (1 << 4)) )
+        d->flags |= FAULT_FRAME_FPU;
+
+    d->stack_words = 0;
+    d->sp = fr;
+    // a failed exception entry (stack guard hit) left no usable frame
+    if( !(d->cfsr & (SCB_CFSR_MSTKERR | SCB_CFSR_STKERR))
+        && fault_in_ram(fr, 8 * 4) )
+    {
+        d->flags |= FAULT_FRAME_VALID;
+        for(i = 0; i < 8; i++)
+            d->frame[i] = frame[i];
+        // SP before stacking: basic 8 or extended 26 words + alignment pad
+        d->sp = fr + ((d->flags & FAULT_FRAME_FPU) ? 26 * 4 : 8 * 4)
+              + ((frame[7] & (1 << 9)) ? 4 : 0);
+        for(i = 0; i < FAULT_STACK_WORDS; i++)
+        {
+            if( !fault_in_ram(d->sp + i * 4, 4) ) break;
+            d->stack[i] = ((uint32_t *)d->sp)[i];
+        }
+        d->stack_words = i;
+    }
+    else
+    {
+        for(i = 0; i < 8; i++)
+            d->frame[i] = 0;
+    }
+
+    d->checksum = fault_checksum(d);
+    scb_reset_system();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+const volatile S_faultDump *INIT_faultDump(void)
+{
+    volatile S_faultDump *d = FAULT_DUMP;
+
+    rcc_periph_clock_enable(RCC_PWR);
+    pwr_disable_backup_domain_write_protect();
+    rcc_periph_clock_enable(RCC_BKPSRAM);
+    // keep the content on VBAT too
+    PWR_CSR |= PWR_CSR_BRE;
+
+    SCB_SHCSR |= SCB_SHCSR_USGFAULTENA | SCB_SHCSR_BUSFAULTENA
+               | SCB_SHCSR_MEMFAULTENA;
+
+    if( d->magic != FAULT_MAGIC || d->version != FAULT_VERSION ) return 0;
+    if( d->checksum != fault_checksum(d) ) return 0;
+    if( d->acked ) return 0;
+    return d;
+}
+
+void fault_dump_ack(void)
+{
+    volatile S_faultDump *d = FAULT_DUMP;
+    if( d->magic != FAULT_MAGIC ) return;
+    d->acked = 1;
+    d->checksum = fault_checksum(d);
+}
+
+// grab the frame, move to fault_istack, push r4-r11 and never come back
+void __attribute__((naked)) hard_fault_handler(void)
+{
+    __asm__ volatile(
+        "tst    lr, #4          \n"
+        "ite    eq              \n"
+        "mrseq  r0, msp         \n"
+        "mrsne  r0, psp         \n"
+        "mov    r1, lr          \n"
+        "mrs    r3, msp         \n"
+        "ldr    r12, =fault_istack\n"
+        "add    r12, r12, #" FAULT_STR(FAULT_ISTACK_BYTES) "\n"
+        "mov    sp, r12         \n"
+        "push   {r4-r11}        \n"
+        "mov    r2, sp          \n"
+        "b      fault_capture   \n"
+    );
+}
+
+void mem_manage_handler(void) __attribute__((alias("hard_fault_handler")));
+void bus_fault_handler(void) __attribute__((alias("hard_fault_handler")));
+void usage_fault_handler(void) __attribute__((alias("hard_fault_handler")));
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,285 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Frequency and duty cycle measurement - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "freq_meas.h"
+#include "waitin.h"
+
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t freq_meas_isqrt(uint64_t x);
+static void freq_meas_div(S_freqReport *r, uint64_t num, uint32_t den);
+static void freq_meas_start(S_freqMeas *f, E_freqRange range);
+static void freq_meas_period(S_freqMeas *f);
+static void freq_meas_count(S_freqMeas *f);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t freq_meas_isqrt(uint64_t x)
+{
+    uint64_t r = 0;
+    uint64_t b = (uint64_t)1 << 62;
+
+    while( b > x ) b >>= 2;
+    while( b )
+    {
+        if( x >= r + b )
+        {
+            x -= r + b;
+            r = (r >> 1) + b;
+        }
+        else
+            r >>= 1;
+        b >>= 2;
+    }
+    return r;
+}
+
+// num / den [Hz] into hz + mhz
+static void freq_meas_div(S_freqReport *r, uint64_t num, uint32_t den)
+{
+    r->hz = num / den;
+    r->mhz = (num % den) * 1000 / den;
+}
+
+static void freq_meas_start(S_freqMeas *f, E_freqRange range)
+{
+    uint32_t tim = FREQ_MEAS_TIM;
+
+    timer_disable_counter(tim);
+    TIM_CCER(tim) &= ~(TIM_CCER_CC1E | TIM_CCER_CC2E);
+    TIM_SMCR(tim) = 0;
+
+    if( range == FREQ_RANGE_PERIOD )
+    {
+        // IC1 - rising edges of TI1, IC2 - falling edges of the same TI1
+        timer_ic_set_input(tim, TIM_IC1, TIM_IC_IN_TI1);
+        timer_ic_set_input(tim, TIM_IC2, TIM_IC_IN_TI1);
+        timer_ic_set_filter(tim, TIM_IC1, FREQ_MEAS_FILTER);
+        TIM_CCER(tim) &= ~(TIM_CCER_CC1P | TIM_CCER_CC1NP | TIM_CCER_CC2NP);
+        TIM_CCER(tim) |= TIM_CCER_CC2P | TIM_CCER_CC1E | TIM_CCER_CC2E;
+        // the rising edge restarts the count of the next period
+        timer_slave_set_trigger(tim, TIM_SMCR_TS_IT1FP1);
+        timer_slave_set_mode(tim, TIM_SMCR_SMS_RM);
+        f->primed = 0;
+    }
+    else
+    {
+        // external clock mode 2, no ETR filter - it would cap the rate
+        timer_slave_set_polarity(tim, TIM_ET_RISING);
+        timer_slave_set_prescaler(tim, f->psc == 8 ? TIM_IC_PSC_8
+                                                   : TIM_IC_PSC_OFF);
+        TIM_SMCR(tim) |= TIM_SMCR_ECE;
+    }
+
+    timer_set_counter(tim, 0);
+    TIM_SR(tim) = 0;
+    timer_enable_counter(tim);
+
+    bool masked = cm_mask_interrupts(true);
+    f->cnt0 = TIM_CNT(tim);
+    f->cyc0 = DWT_CYCCNT;
+    cm_mask_interrupts(masked);
+    f->range = range;
+}
+
+static void freq_meas_period(S_freqMeas *f)
+{
+    uint32_t tim = FREQ_MEAS_TIM;
+    S_freqReport *r = &f->rep;
+    uint32_t sr = TIM_SR(tim);
+    uint32_t p, h;
+
+    r->t = DWT_CYCCNT;
+    if( sr & TIM_SR_UIF )
+    {
+        // 2^32 ticks (51 s) without a rising edge
+        TIM_SR(tim) = ~(TIM_SR_UIF | TIM_SR_CC1OF);
+        if( f->primed >= 2 ) f->stats.lost++;
+        f->primed = 0;
+    }
+    else if( sr & TIM_SR_CC1IF )
+    {
+        // an overcapture means at least two edges since the last look
+        f->primed += (sr & TIM_SR_CC1OF) ? 2 : 1;
+        TIM_SR(tim) = ~TIM_SR_CC1OF;
+        // reading CCR1 clears CC1IF; CCR2 is the high time before it
+        do
+        {
+            h = TIM_CCR2(tim);
+            p = TIM_CCR1(tim);
+        } while( h != TIM_CCR2(tim) );
+
+        // the first capture is only the time since the range started
+        if( f->primed >= 2 && p )
+        {
+            f->primed = 2;
+            f->last = p;
+            freq_meas_div(r, FREQ_MEAS_TIM_HZ, p);
+            r->duty = h < p ? (uint64_t)h * 10000 / p : 10000;
+            r->err_ppm = (1000000 + p - 1) / p;
+        }
+    }
+    else if( f->primed >= 2 && TIM_CNT(tim) / 2 > f->last )
+    {
+        // no edge for two periods
+        f->stats.lost++;
+        f->primed = 0;
+    }
+
+    // without a new capture the last period is reported again
+    if( f->primed >= 2 )
+    {
+        r->flags = 0;
+        return;
+    }
+    r->hz = 0;
+    r->mhz = 0;
+    r->duty = 0;
+    r->err_ppm = 0;
+    r->flags = FREQ_NO_SIGNAL;
+}
+
+static void freq_meas_count(S_freqMeas *f)
+{
+    S_freqReport *r = &f->rep;
+    uint32_t cnt, cyc, n;
+
+    // both ends of the gate at the same moment
+    bool masked = cm_mask_interrupts(true);
+    cnt = TIM_CNT(FREQ_MEAS_TIM);
+    cyc = DWT_CYCCNT;
+    cm_mask_interrupts(masked);
+
+    n = cnt - f->cnt0;
+    r->t = cyc;
+    r->duty = 0;
+    r->flags = FREQ_NO_DUTY;
+    if( !n )
+    {
+        r->hz = 0;
+        r->mhz = 0;
+        r->err_ppm = 0;
+        r->flags |= FREQ_NO_SIGNAL;
+    }
+    else
+    {
+        freq_meas_div(r, (uint64_t)n * f->psc * FREQ_MEAS_SYSCLK_HZ,
+                      cyc - f->cyc0);
+        r->err_ppm = (1000000 + n - 1) / n;
+    }
+    f->cnt0 = cnt;
+    f->cyc0 = cyc;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_freqMeas(S_freqMeas *f, uint32_t rate_ms)
+{
+    uint32_t tim = FREQ_MEAS_TIM;
+    // crossover of the two errors for this gate
+    uint32_t fx = freq_meas_isqrt((uint64_t)FREQ_MEAS_TIM_HZ * 1000 / rate_ms);
+
+    f->rate = rate_ms;
+    f->up = 2 * fx;
+    f->down = fx / 2;
+    f->psc = 1;
+    f->last = 0;
+    f->rep = (S_freqReport){0};
+    f->stats = (S_freqMeasStats){0};
+    dwt_enable_cycle_counter();
+
+    timer_disable_counter(tim);
+    timer_set_prescaler(tim, 0);
+    timer_set_period(tim, 0xFFFFFFFF);
+    // UIF only from the overflow, not from the slave resets
+    timer_update_on_overflow(tim);
+    timer_generate_event(tim, TIM_EGR_UG);
+
+    freq_meas_start(f, FREQ_RANGE_PERIOD);
+    f->due = system_tick + rate_ms;
+}
+
+uint8_t freq_meas_poll(S_freqMeas *f)
+{
+    S_freqReport *r = &f->rep;
+    uint32_t now = system_tick;
+    uint32_t hz;
+
+    if( (int32_t)(now - f->due) < 0 ) return 0;
+    f->due += f->rate;
+    if( (int32_t)(now - f->due) >= 0 ) f->due = now + f->rate;
+
+    r->range = f->range;
+    if( f->range == FREQ_RANGE_PERIOD )
+        freq_meas_period(f);
+    else
+        freq_meas_count(f);
+    r->seq++;
+
+    hz = r->hz;
+    if( f->range == FREQ_RANGE_PERIOD )
+    {
+        if( hz > f->up )
+        {
+            f->psc = hz > FREQ_MEAS_ETR_UP ? 8 : 1;
+            freq_meas_start(f, FREQ_RANGE_COUNT);
+            f->stats.switches++;
+        }
+    }
+    else if( hz < f->down )
+    {
+        freq_meas_start(f, FREQ_RANGE_PERIOD);
+        f->stats.switches++;
+    }
+    else if( (f->psc == 1 && hz > FREQ_MEAS_ETR_UP)
+          || (f->psc == 8 && hz < FREQ_MEAS_ETR_DOWN) )
+    {
+        // a new gate with the other prescaler
+        f->psc = f->psc == 1 ? 8 : 1;
+        freq_meas_start(f, FREQ_RANGE_COUNT);
+        f->stats.psc_switches++;
+    }
+    return 1;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
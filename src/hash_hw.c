@@ -0,0 +1,599 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Incremental SHA-1 / MD5 / HMAC on the HASH unit - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "hash_hw.h"
+
+#include <libopencm3/stm32/hash.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/dwt.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define HASH_HW_FLAGS       (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// longest DMA span, NDTR counts the words written to HASH_DIN
+#define HASH_HW_DMA_BYTES   (0xFFFFu * 4)
+// HMAC pads (RFC 2104)
+#define HASH_HW_IPAD        0x36
+#define HASH_HW_OPAD        0x5C
+#define HASH_HW_ROL(x, n)   (((x) << (n)) | ((x) >> (32 - (n))))
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+
+// SHA-1 and MD5 (first four) initial state
+static const uint32_t hash_sw_iv[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+// MD5 round constants, floor(abs(sin(i + 1)) * 2^32)
+static const uint32_t hash_sw_md5_k[64] = {
+    0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE,
+    0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+    0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE,
+    0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+    0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA,
+    0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+    0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED,
+    0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+    0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C,
+    0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+    0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05,
+    0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+    0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039,
+    0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+    0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1,
+    0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391
+};
+
+// MD5 rotations, 4 per round
+static const uint8_t hash_sw_md5_r[16] = {
+    7, 12, 17, 22,  5, 9, 14, 20,  4, 11, 16, 23,  6, 10, 15, 21
+};
+
+static S_dmaStream hash_hw_s;
+// message holding the unit
+static S_hashHw *volatile hash_hw_owner = 0;
+static S_hashHwStats hash_hw_st;
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void hash_sw_sha1(uint32_t *h, const uint8_t *b);
+static void hash_sw_md5(uint32_t *h, const uint8_t *b);
+static void hash_sw_begin(S_hashSw *s, E_hashHwAlgo algo);
+static void hash_sw_update(S_hashSw *s, const uint8_t *b, uint32_t len);
+static void hash_sw_final(S_hashSw *s, uint8_t *out);
+static void hash_sw_key(S_hashSw *s, const S_hashHw *c, uint8_t pad);
+static void hash_hw_start(S_hashHw *c, E_hashHwAlgo algo, uint8_t unit);
+static void hash_hw_dcal(uint32_t bits);
+static void hash_hw_key(const uint8_t *key, uint32_t klen);
+static void hash_hw_feed(S_hashHw *c, const uint8_t *b, uint32_t len);
+static void hash_hw_result(S_hashHw *c, uint8_t *out);
+static void hash_hw_bench_done(void *arg, int err);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static void hash_sw_sha1(uint32_t *h, const uint8_t *b)
+{
+    uint32_t w[16], a, bb, c, d, e, f, k, t;
+    uint8_t i;
+
+    for(i = 0; i < 16; i++, b += 4)
+        w[i] = (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16
+             | (uint32_t)b[2] << 8 | b[3];
+    a = h[0]; bb = h[1]; c = h[2]; d = h[3]; e = h[4];
+    for(i = 0; i < 80; i++)
+    {
+        // the schedule in a 16-word ring
+        if( i >= 16 )
+        {
+            t = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15]
+              ^ w[i & 15];
+            w[i & 15] = HASH_HW_ROL(t, 1);
+        }
+        if( i < 20 )
+        {
+            f = (bb & c) | (~bb & d);
+            k = 0x5A827999;
+        }
+        else if( i < 40 )
+        {
+            f = bb ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if( i < 60 )
+        {
+            f = (bb & c) | (bb & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = bb ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        t = HASH_HW_ROL(a, 5) + f + e + k + w[i & 15];
+        e = d;
+        d = c;
+        c = HASH_HW_ROL(bb, 30);
+        bb = a;
+        a = t;
+    }
+    h[0] += a; h[1] += bb; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void hash_sw_md5(uint32_t *h, const uint8_t *b)
+{
+    uint32_t m[16], a, bb, c, d, f, t;
+    uint8_t i, g;
+
+    for(i = 0; i < 16; i++, b += 4)
+        m[i] = b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16
+             | (uint32_t)b[3] << 24;
+    a = h[0]; bb = h[1]; c = h[2]; d = h[3];
+    for(i = 0; i < 64; i++)
+    {
+        if( i < 16 )
+        {
+            f = (bb & c) | (~bb & d);
+            g = i;
+        }
+        else if( i < 32 )
+        {
+            f = (d & bb) | (~d & c);
+            g = (5 * i + 1) & 15;
+        }
+        else if( i < 48 )
+        {
+            f = bb ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        }
+        else
+        {
+            f = c ^ (bb | ~d);
+            g = (7 * i) & 15;
+        }
+        t = a + f + hash_sw_md5_k[i] + m[g];
+        a = d;
+        d = c;
+        c = bb;
+        bb += HASH_HW_ROL(t, hash_sw_md5_r[(i >> 4) * 4 + (i & 3)]);
+    }
+    h[0] += a; h[1] += bb; h[2] += c; h[3] += d;
+}
+
+static void hash_sw_begin(S_hashSw *s, E_hashHwAlgo algo)
+{
+    s->algo = algo;
+    memcpy(s->h, hash_sw_iv, sizeof(s->h));
+    s->len = 0;
+}
+
+static void hash_sw_update(S_hashSw *s, const uint8_t *b, uint32_t len)
+{
+    uint32_t k = s->len & (HASH_HW_BLOCK - 1);
+    uint32_t n;
+
+    s->len += len;
+    if( k )
+    {
+        n = HASH_HW_BLOCK - k;
+        if( n > len ) n = len;
+        memcpy(s->blk + k, b, n);
+        b += n;
+        len -= n;
+        if( k + n < HASH_HW_BLOCK ) return;
+        if( s->algo == HASH_HW_SHA1 ) hash_sw_sha1(s->h, s->blk);
+        else hash_sw_md5(s->h, s->blk);
+    }
+    for(; len >= HASH_HW_BLOCK; len -= HASH_HW_BLOCK, b += HASH_HW_BLOCK)
+    {
+        if( s->algo == HASH_HW_SHA1 ) hash_sw_sha1(s->h, b);
+        else hash_sw_md5(s->h, b);
+    }
+    memcpy(s->blk, b, len);
+}
+
+static void hash_sw_final(S_hashSw *s, uint8_t *out)
+{
+    uint8_t pad[HASH_HW_BLOCK + 8] = {0x80};
+    uint32_t k = s->len & (HASH_HW_BLOCK - 1);
+    uint32_t bits[2] = {s->len << 3, s->len >> 29};
+    uint32_t n, i;
+
+    // 0x80, zeros up to 8 bytes before a block end, bit length
+    n = (k < HASH_HW_BLOCK - 8 ? HASH_HW_BLOCK - 8 : 2 * HASH_HW_BLOCK - 8)
+      - k;
+    for(i = 0; i < 8; i++)
+    {
+        if( s->algo == HASH_HW_SHA1 )
+            pad[n + i] = bits[1 - i / 4] >> (24 - 8 * (i & 3));
+        else
+            pad[n + i] = bits[i / 4] >> (8 * (i & 3));
+    }
+    hash_sw_update(s, pad, n + 8);
+
+    for(i = 0; i < HASH_HW_LEN(s->algo); i++)
+    {
+        if( s->algo == HASH_HW_SHA1 )
+            out[i] = s->h[i / 4] >> (24 - 8 * (i & 3));
+        else
+            out[i] = s->h[i / 4] >> (8 * (i & 3));
+    }
+}
+
+// starts an inner / outer HMAC hash with the padded key block
+static void hash_sw_key(S_hashSw *s, const S_hashHw *c, uint8_t pad)
+{
+    uint8_t k0[HASH_HW_BLOCK] = {0};
+    uint8_t i;
+
+    if( c->klen > HASH_HW_BLOCK )
+    {
+        hash_sw_begin(s, c->algo);
+        hash_sw_update(s, c->key, c->klen);
+        hash_sw_final(s, k0);
+    }
+    else memcpy(k0, c->key, c->klen);
+    for(i = 0; i < HASH_HW_BLOCK; i++) k0[i] ^= pad;
+    hash_sw_begin(s, c->algo);
+    hash_sw_update(s, k0, HASH_HW_BLOCK);
+}
+
+static void hash_hw_start(S_hashHw *c, E_hashHwAlgo algo, uint8_t unit)
+{
+    c->algo = algo;
+    c->hw = 0;
+    c->npart = 0;
+    c->busy = 0;
+
+    bool masked = cm_mask_interrupts(true);
+    if( HASH_HW_UNIT && unit
+        && (!hash_hw_owner || hash_hw_owner == c) )
+    {
+        hash_hw_owner = c;
+        c->hw = 1;
+    }
+    cm_mask_interrupts(masked);
+
+    if( !c->hw )
+    {
+        hash_hw_st.sw++;
+        if( c->hmac ) hash_sw_key(&c->sw, c, HASH_HW_IPAD);
+        else hash_sw_begin(&c->sw, algo);
+        return;
+    }
+    hash_hw_st.hw++;
+    hash_set_data_type(HASH_DATA_8BIT);
+    hash_set_algorithm(algo == HASH_HW_SHA1 ? HASH_ALGO_SHA1 : HASH_ALGO_MD5);
+    hash_set_mode(c->hmac ? HASH_MODE_HMAC : HASH_MODE_HASH);
+    // a long key is hashed by the unit first
+    hash_set_key_length(c->klen > HASH_HW_BLOCK ? HASH_KEY_LONG
+                                                : HASH_KEY_SHORT);
+    hash_init();
+    if( c->hmac )
+    {
+        hash_hw_key(c->key, c->klen);
+        while( HASH_SR & HASH_SR_BUSY ) ;
+    }
+}
+
+// ends a phase: valid bits of the last word written, calculation started
+static void hash_hw_dcal(uint32_t bits)
+{
+    HASH_SR = ~HASH_SR_DCIS;
+    hash_set_last_word_valid_bits(bits);
+    hash_digest();
+}
+
+// HMAC key phase, words are read as bytes - any alignment
+static void hash_hw_key(const uint8_t *key, uint32_t klen)
+{
+    uint32_t w;
+
+    for(; klen >= 4; klen -= 4, key += 4)
+    {
+        memcpy(&w, key, 4);
+        hash_add_data(w);
+    }
+    if( klen )
+    {
+        w = 0;
+        memcpy(&w, key, klen);
+        hash_add_data(w);
+    }
+    hash_hw_dcal(klen * 8);
+}
+
+static void hash_hw_feed(S_hashHw *c, const uint8_t *b, uint32_t len)
+{
+    uint32_t w;
+
+    // finish the word left over from the previous span
+    if( c->npart )
+    {
+        while( len && c->npart < 4 )
+        {
+            c->part[c->npart++] = *b++;
+            len--;
+        }
+        if( c->npart < 4 ) return;
+        memcpy(&w, c->part, 4);
+        hash_add_data(w);
+        c->npart = 0;
+    }
+    // a full FIFO stalls the bus until the unit takes a block
+    for(; len >= 4; len -= 4, b += 4)
+    {
+        memcpy(&w, b, 4);
+        hash_add_data(w);
+    }
+    memcpy(c->part, b, len);
+    c->npart = len;
+}
+
+// message phase started - outer key (HMAC), digest, unit released
+static void hash_hw_result(S_hashHw *c, uint8_t *out)
+{
+    uint32_t h[5];
+    uint8_t i;
+
+    if( c->hmac )
+    {
+        while( HASH_SR & HASH_SR_BUSY ) ;
+        hash_hw_key(c->key, c->klen);
+    }
+    while( !(HASH_SR & HASH_SR_DCIS) ) ;
+    hash_get_result(h);
+    hash_hw_owner = 0;
+    for(i = 0; i < HASH_HW_LEN(c->algo); i++)
+        out[i] = h[i / 4] >> (24 - 8 * (i & 3));
+}
+
+static void hash_hw_bench_done(void *arg, int err)
+{
+    (void)err;
+    *(volatile uint32_t *)arg = DWT_CYCCNT;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_hashHw(const S_dmaStream *s)
+{
+    if( HASH_HW_UNIT ) rcc_periph_clock_enable(RCC_HASH);
+    dwt_enable_cycle_counter();
+    hash_hw_s = (S_dmaStream){0};
+    if( !s ) return;
+    hash_hw_s = *s;
+    nvic_set_priority(s->irqn, HASH_HW_PRIORITY);
+    nvic_enable_irq(s->irqn);
+}
+
+void hash_hw_begin(S_hashHw *c, E_hashHwAlgo algo)
+{
+    c->hmac = 0;
+    c->key = 0;
+    c->klen = 0;
+    hash_hw_start(c, algo, 1);
+}
+
+void hash_hw_hmac_begin(S_hashHw *c, E_hashHwAlgo algo,
+                        const void *key, uint32_t klen)
+{
+    c->hmac = 1;
+    c->key = key;
+    c->klen = klen;
+    hash_hw_start(c, algo, 1);
+}
+
+int hash_hw_update(S_hashHw *c, const void *p, uint32_t len)
+{
+    if( c->busy ) return -1;
+    if( c->hw ) hash_hw_feed(c, p, len);
+    else hash_sw_update(&c->sw, p, len);
+    return 0;
+}
+
+int hash_hw_final(S_hashHw *c, uint8_t *digest)
+{
+    uint8_t inner[HASH_HW_SHA1_LEN];
+    uint32_t w = 0;
+
+    if( c->busy ) return -1;
+    if( c->hw )
+    {
+        if( c->npart )
+        {
+            memcpy(&w, c->part, c->npart);
+            hash_add_data(w);
+        }
+        hash_hw_dcal(c->npart * 8);
+        hash_hw_result(c, digest);
+        return 0;
+    }
+    if( !c->hmac )
+    {
+        hash_sw_final(&c->sw, digest);
+        return 0;
+    }
+    hash_sw_final(&c->sw, inner);
+    hash_sw_key(&c->sw, c, HASH_HW_OPAD);
+    hash_sw_update(&c->sw, inner, HASH_HW_LEN(c->algo));
+    hash_sw_final(&c->sw, digest);
+    return 0;
+}
+
+int hash_hw_finish(S_hashHw *c, const void *p, uint32_t len,
+                   uint8_t *digest, F_hashHwDone done, void *arg)
+{
+    struct dma_stream_desc d = {0};
+    const uint8_t *b = p;
+    uint32_t k;
+
+    if( c->busy ) return -1;
+    if( !c->hw || !hash_hw_s.dma || len < HASH_HW_DMA_MIN )
+    {
+        hash_hw_update(c, b, len);
+        hash_hw_final(c, digest);
+        if( done ) done(arg, HASH_HW_OK);
+        return 0;
+    }
+
+    // the DMA words have to start on a word of the message
+    k = (4 - c->npart) & 3;
+    hash_hw_feed(c, b, k);
+    b += k;
+    len -= k;
+    // the DMA takes the end of a longer span
+    if( len > HASH_HW_DMA_BYTES )
+    {
+        k = (len - HASH_HW_DMA_BYTES + 3) & ~3u;
+        hash_hw_feed(c, b, k);
+        b += k;
+        len -= k;
+    }
+
+    c->out = digest;
+    c->done = done;
+    c->arg = arg;
+    c->busy = 1;
+    hash_hw_st.dma++;
+
+    d.channel = hash_hw_s.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_PERIPHERAL;
+    d.priority = DMA_SxCR_PL_MEDIUM;
+    d.periph_size = DMA_SxCR_PSIZE_32BIT;
+    // the FIFO packs unaligned bytes into the words
+    d.mem_size = ((uint32_t)b & 3) ? DMA_SxCR_MSIZE_8BIT
+                                   : DMA_SxCR_MSIZE_32BIT;
+    d.mode = DMA_SxCR_MINC;
+    d.interrupts = DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.fifo = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH_4_4_FULL;
+    d.periph_address = (uint32_t)&HASH_DIN;
+    d.mem_address = (uint32_t)b;
+    // NDTR counts HASH_DIN words: a partial last word is read whole, up to
+    // 3 bytes after the span - NBLW makes the unit drop them. The tail
+    // cannot go by the CPU instead, the F41x unit starts the digest at the
+    // DMA terminal count (no MDMAT)
+    d.number = (len + 3) >> 2;
+    dma_configure(hash_hw_s.dma, hash_hw_s.stream, &d);
+
+    // the unit starts the digest itself after the last DMA word
+    HASH_SR = ~HASH_SR_DCIS;
+    hash_set_last_word_valid_bits((len & 3) * 8);
+    HASH_CR |= HASH_CR_DMAE;
+    dma_enable_stream(hash_hw_s.dma, hash_hw_s.stream);
+    return 0;
+}
+
+void hash_hw_irq(void)
+{
+    S_hashHw *c = hash_hw_owner;
+    uint32_t dma = hash_hw_s.dma;
+    uint8_t stream = hash_hw_s.stream;
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+    int err = HASH_HW_OK;
+
+    dma_clear_interrupt_flags(dma, stream, HASH_HW_FLAGS);
+    if( !c || !c->busy ) return;
+
+    if( te )
+    {
+        // the message is lost, the unit is reset by the next begin
+        DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+        while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+        HASH_CR &= ~HASH_CR_DMAE;
+        hash_hw_st.errors++;
+        hash_hw_owner = 0;
+        err = HASH_HW_ERR_TRANSFER;
+    }
+    else if( !tc ) return;
+    // the last block and the padding (and the outer key) - a few hundred
+    // cycles at most, not worth a second interrupt
+    else hash_hw_result(c, c->out);
+    c->busy = 0;
+    if( c->done ) c->done(c->arg, err);
+}
+
+const S_hashHwStats *hash_hw_stats(void)
+{
+    return &hash_hw_st;
+}
+
+int hash_hw_bench(const void *p, uint32_t len, S_hashHwBench *out)
+{
+    S_hashHwBench b = {0};
+    S_hashHw c;
+    uint8_t ref[HASH_HW_SHA1_LEN], dig[HASH_HW_SHA1_LEN];
+    uint32_t end = 0;
+    uint32_t t;
+    int r = 0;
+
+    b.len = len;
+    c.hmac = 0;
+    c.klen = 0;
+    t = DWT_CYCCNT;
+    hash_hw_start(&c, HASH_HW_SHA1, 0);
+    hash_hw_update(&c, p, len);
+    hash_hw_final(&c, ref);
+    b.sw = DWT_CYCCNT - t;
+
+    if( HASH_HW_UNIT )
+    {
+        t = DWT_CYCCNT;
+        hash_hw_begin(&c, HASH_HW_SHA1);
+        hash_hw_update(&c, p, len);
+        hash_hw_final(&c, dig);
+        b.cpu = DWT_CYCCNT - t;
+        if( !c.hw || memcmp(ref, dig, sizeof(dig)) ) r = -1;
+
+        if( hash_hw_s.dma && len >= HASH_HW_DMA_MIN )
+        {
+            t = DWT_CYCCNT;
+            hash_hw_begin(&c, HASH_HW_SHA1);
+            hash_hw_finish(&c, p, len, dig, hash_hw_bench_done, &end);
+            while( c.busy ) ;
+            b.dma = *(volatile uint32_t *)&end - t;
+            if( !c.hw || memcmp(ref, dig, sizeof(dig)) ) r = -1;
+        }
+    }
+    if( out ) *out = b;
+    return r;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
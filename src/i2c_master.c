@@ -0,0 +1,514 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Interrupt driven I2C master with a queue and DMA - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "i2c_master.h"
+#include "waitin.h"
+
+#include <libopencm3/stm32/i2c.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define I2C_MASTER_DMA_FLAGS    (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                                | DMA_FEIF)
+
+#define I2C_MASTER_SR1_ERR      (I2C_SR1_SMBALERT | I2C_SR1_TIMEOUT \
+                                | I2C_SR1_PECERR | I2C_SR1_OVR | I2C_SR1_AF \
+                                | I2C_SR1_ARLO | I2C_SR1_BERR)
+
+// polls of CR1.STOP before the STOP counts as stuck (a few bit times)
+#define I2C_MASTER_STOP_SPIN    2000
+
+// half of a recovery SCL period [DWT cycles] - 100 kHz at 168 MHz
+#define I2C_MASTER_HALF_BIT     840
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void i2c_master_setup(S_i2cMaster *m);
+static void i2c_master_start(S_i2cMaster *m, uint32_t first);
+static void i2c_master_dma(S_i2cMaster *m, const S_dmaStream *s,
+                           uint32_t dir, const void *buf, uint16_t len);
+static void i2c_master_halt(S_i2cMaster *m);
+static void i2c_master_addr(S_i2cMaster *m, S_i2cXfer *x);
+static void i2c_master_wr_end(S_i2cMaster *m, S_i2cXfer *x);
+static void i2c_master_end(S_i2cMaster *m, int err);
+static void i2c_master_pin_mode(uint32_t port, uint16_t pin, uint32_t mode);
+static void i2c_master_half_bit(void);
+static void i2c_master_recover(S_i2cMaster *m);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// SWRST, timing and PE - the state of a freshly reset master
+static void i2c_master_setup(S_i2cMaster *m)
+{
+    uint32_t i2c = m->i2c;
+    uint32_t pclk = I2C_MASTER_PCLK_MHZ * 1000000;
+    uint32_t ccr;
+
+    // SWRST also drops a BUSY flag latched by a glitch on the bus
+    I2C_CR1(i2c) = I2C_CR1_SWRST;
+    I2C_CR1(i2c) = 0;
+    I2C_CR2(i2c) = I2C_MASTER_PCLK_MHZ;
+    if( m->speed > 100000 )
+    {
+        // Tlow:Thigh = 2:1 - 42 MHz / (3 * 35) is 400 kHz exactly
+        ccr = (pclk + 3 * m->speed - 1) / (3 * m->speed);
+        if( ccr < 1 ) ccr = 1;
+        I2C_CCR(i2c) = I2C_CCR_FS | ccr;
+        I2C_TRISE(i2c) = I2C_MASTER_PCLK_MHZ * 300 / 1000 + 1;
+    }
+    else
+    {
+        ccr = (pclk + 2 * m->speed - 1) / (2 * m->speed);
+        if( ccr < 4 ) ccr = 4;
+        I2C_CCR(i2c) = ccr;
+        I2C_TRISE(i2c) = I2C_MASTER_PCLK_MHZ + 1;
+    }
+    I2C_CR1(i2c) = I2C_CR1_PE;
+}
+
+// START for the head transaction (again after an arbitration loss)
+static void i2c_master_start(S_i2cMaster *m, uint32_t first)
+{
+    S_i2cXfer *x = m->head;
+
+    if( first )
+    {
+        m->started = system_tick;
+        m->tries = 0;
+    }
+    m->reading = (x->wlen == 0 && x->rlen != 0);
+    m->dma = 0;
+    m->n = 0;
+    m->state = I2C_MASTER_START;
+    I2C_CR2(m->i2c) |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+    I2C_CR1(m->i2c) |= I2C_CR1_START;
+}
+
+static void i2c_master_dma(S_i2cMaster *m, const S_dmaStream *s,
+                           uint32_t dir, const void *buf, uint16_t len)
+{
+    struct dma_stream_desc d = {0};
+
+    d.channel = s->channel;
+    d.direction = dir;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_8BIT;
+    d.mem_size = DMA_SxCR_MSIZE_8BIT;
+    d.mode = DMA_SxCR_MINC;
+    // a read ends on the RX transfer complete, a write on BTF
+    d.interrupts = (dir == DMA_SxCR_DIR_PERIPHERAL_TO_MEM)
+                 ? DMA_SxCR_TCIE | DMA_SxCR_TEIE : DMA_SxCR_TEIE;
+    d.periph_address = (uint32_t)&I2C_DR(m->i2c);
+    d.mem_address = (uint32_t)buf;
+    d.number = len;
+    dma_configure(s->dma, s->stream, &d);
+    dma_enable_stream(s->dma, s->stream);
+    m->dma = 1;
+    m->stats.dma_xfers++;
+}
+
+// DMA requests and buffer interrupts off, streams stopped
+static void i2c_master_halt(S_i2cMaster *m)
+{
+    I2C_CR2(m->i2c) &= ~(I2C_CR2_DMAEN | I2C_CR2_LAST | I2C_CR2_ITBUFEN);
+    if( m->dma )
+    {
+        DMA_SCR(m->rxs.dma, m->rxs.stream) &= ~DMA_SxCR_EN;
+        DMA_SCR(m->txs.dma, m->txs.stream) &= ~DMA_SxCR_EN;
+        dma_clear_interrupt_flags(m->rxs.dma, m->rxs.stream,
+                                  I2C_MASTER_DMA_FLAGS);
+        dma_clear_interrupt_flags(m->txs.dma, m->txs.stream,
+                                  I2C_MASTER_DMA_FLAGS);
+        m->dma = 0;
+    }
+}
+
+// the slave acknowledged its address - ADDR is cleared by the SR2 read
+static void i2c_master_addr(S_i2cMaster *m, S_i2cXfer *x)
+{
+    uint32_t i2c = m->i2c;
+
+    if( m->reading )
+    {
+        if( x->rlen == 1 )
+        {
+            // NACK the only byte, STOP right behind it (RM0090 27.3.3)
+            I2C_CR1(i2c) &= ~I2C_CR1_ACK;
+            (void)I2C_SR2(i2c);
+            I2C_CR1(i2c) |= I2C_CR1_STOP;
+            I2C_CR2(i2c) |= I2C_CR2_ITBUFEN;
+        }
+        else
+        {
+            // LAST - the peripheral NACKs the byte of the final request
+            I2C_CR1(i2c) |= I2C_CR1_ACK;
+            I2C_CR2(i2c) |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+            i2c_master_dma(m, &m->rxs, DMA_SxCR_DIR_PERIPHERAL_TO_MEM,
+                           x->rd, x->rlen);
+            (void)I2C_SR2(i2c);
+        }
+        m->state = I2C_MASTER_RX;
+    }
+    else if( !x->wlen )
+    {
+        // address probe
+        (void)I2C_SR2(i2c);
+        i2c_master_wr_end(m, x);
+    }
+    else
+    {
+        if( x->wlen >= I2C_MASTER_DMA_MIN )
+        {
+            I2C_CR2(i2c) |= I2C_CR2_DMAEN;
+            i2c_master_dma(m, &m->txs, DMA_SxCR_DIR_MEM_TO_PERIPHERAL,
+                           x->wr, x->wlen);
+        }
+        else I2C_CR2(i2c) |= I2C_CR2_ITBUFEN;
+        (void)I2C_SR2(i2c);
+        m->state = I2C_MASTER_TX;
+    }
+}
+
+// the last written byte is out - repeated START for the read or STOP
+static void i2c_master_wr_end(S_i2cMaster *m, S_i2cXfer *x)
+{
+    i2c_master_halt(m);
+    if( x->rlen )
+    {
+        m->reading = 1;
+        m->state = I2C_MASTER_START;
+        I2C_CR1(m->i2c) |= I2C_CR1_START;
+    }
+    else
+    {
+        I2C_CR1(m->i2c) |= I2C_CR1_STOP;
+        i2c_master_end(m, I2C_MASTER_OK);
+    }
+}
+
+// finishes the running transaction and starts the next one
+static void i2c_master_end(S_i2cMaster *m, int err)
+{
+    S_i2cXfer *x = m->head;
+    uint32_t i2c = m->i2c;
+    uint32_t spin = I2C_MASTER_STOP_SPIN;
+
+    i2c_master_halt(m);
+    m->stats.xfers++;
+    if( !err ) m->stats.bytes += x->wlen + x->rlen;
+    m->head = x->next;
+    if( !m->head ) m->tail = 0;
+
+    // CR1 must not be written before the hardware took the STOP
+    if( !m->recover )
+    {
+        while( (I2C_CR1(i2c) & I2C_CR1_STOP) && --spin ) ;
+        if( !spin )
+        {
+            m->stats.bus_errors++;
+            m->recover = 1;
+        }
+    }
+
+    if( m->recover || !m->head )
+    {
+        I2C_CR2(i2c) &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN);
+        m->state = m->recover ? I2C_MASTER_RECOVER : I2C_MASTER_IDLE;
+    }
+    else i2c_master_start(m, 1);
+    if( x->done ) x->done(x->arg, err);
+}
+
+// switches one pin between GPIO output and AF, pull-ups and AF number kept
+static void i2c_master_pin_mode(uint32_t port, uint16_t pin, uint32_t mode)
+{
+    uint32_t k = 2 * __builtin_ctz(pin);
+    GPIO_MODER(port) = (GPIO_MODER(port) & ~(3u << k)) | (mode << k);
+}
+
+static void i2c_master_half_bit(void)
+{
+    uint32_t t = DWT_CYCCNT;
+    while( DWT_CYCCNT - t < I2C_MASTER_HALF_BIT ) ;
+}
+
+// frees a bus held by a slave that lost track of the clock
+static void i2c_master_recover(S_i2cMaster *m)
+{
+    const S_i2cPins *p = &m->pins;
+    uint32_t i;
+
+    m->stats.recoveries++;
+    I2C_CR1(m->i2c) = 0;
+    gpio_set(p->scl_port, p->scl);
+    gpio_set(p->sda_port, p->sda);
+    i2c_master_pin_mode(p->scl_port, p->scl, GPIO_MODE_OUTPUT);
+    i2c_master_pin_mode(p->sda_port, p->sda, GPIO_MODE_OUTPUT);
+    i2c_master_half_bit();
+
+    // a slave in the middle of a read lets SDA go within 9 clocks
+    for(i = 0; i < 9 && !gpio_get(p->sda_port, p->sda); i++)
+    {
+        gpio_clear(p->scl_port, p->scl);
+        i2c_master_half_bit();
+        gpio_set(p->scl_port, p->scl);
+        i2c_master_half_bit();
+    }
+    if( i ) m->stats.sda_stuck++;
+
+    // STOP - SDA rises while SCL is high
+    gpio_clear(p->scl_port, p->scl);
+    i2c_master_half_bit();
+    gpio_clear(p->sda_port, p->sda);
+    i2c_master_half_bit();
+    gpio_set(p->scl_port, p->scl);
+    i2c_master_half_bit();
+    gpio_set(p->sda_port, p->sda);
+    i2c_master_half_bit();
+
+    i2c_master_pin_mode(p->scl_port, p->scl, GPIO_MODE_AF);
+    i2c_master_pin_mode(p->sda_port, p->sda, GPIO_MODE_AF);
+    i2c_master_setup(m);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_i2cMaster(S_i2cMaster *m, uint32_t i2c, uint32_t speed,
+                    const S_dmaStream *rx, const S_dmaStream *tx,
+                    const S_i2cPins *pins)
+{
+    uint8_t ev;
+
+    m->i2c = i2c;
+    m->rxs = *rx;
+    m->txs = *tx;
+    m->pins = *pins;
+    m->speed = speed;
+    m->head = m->tail = 0;
+    m->state = I2C_MASTER_IDLE;
+    m->dma = 0;
+    m->recover = 0;
+    m->stats = (S_i2cMasterStats){0};
+
+    dwt_enable_cycle_counter();
+    i2c_master_setup(m);
+
+    if( i2c == I2C1 ) ev = NVIC_I2C1_EV_IRQ;
+    else if( i2c == I2C2 ) ev = NVIC_I2C2_EV_IRQ;
+    else ev = NVIC_I2C3_EV_IRQ;
+    // ER is the vector right after EV on all three
+    nvic_set_priority(ev, I2C_MASTER_PRIORITY);
+    nvic_set_priority(ev + 1, I2C_MASTER_PRIORITY);
+    nvic_set_priority(rx->irqn, I2C_MASTER_PRIORITY);
+    nvic_set_priority(tx->irqn, I2C_MASTER_PRIORITY);
+    nvic_enable_irq(ev);
+    nvic_enable_irq(ev + 1);
+    nvic_enable_irq(rx->irqn);
+    nvic_enable_irq(tx->irqn);
+}
+
+void i2c_master_submit(S_i2cMaster *m, S_i2cXfer *x)
+{
+    x->next = 0;
+    bool masked = cm_mask_interrupts(true);
+    if( m->tail )
+    {
+        m->tail->next = x;
+        m->tail = x;
+    }
+    else
+    {
+        m->head = m->tail = x;
+        if( m->state == I2C_MASTER_IDLE && !m->recover )
+            i2c_master_start(m, 1);
+    }
+    cm_mask_interrupts(masked);
+}
+
+void i2c_master_ev_irq(S_i2cMaster *m)
+{
+    uint32_t i2c = m->i2c;
+    uint32_t sr1 = I2C_SR1(i2c);
+    S_i2cXfer *x = m->head;
+
+    switch( m->state )
+    {
+    case I2C_MASTER_START:
+        // SR1 read + DR write clears SB
+        if( sr1 & I2C_SR1_SB )
+        {
+            I2C_DR(i2c) = (x->addr << 1) | m->reading;
+            m->state = I2C_MASTER_ADDR;
+        }
+        break;
+    case I2C_MASTER_ADDR:
+        if( sr1 & I2C_SR1_ADDR ) i2c_master_addr(m, x);
+        break;
+    case I2C_MASTER_TX:
+        if( !m->dma && (sr1 & I2C_SR1_TxE) && m->n < x->wlen )
+        {
+            I2C_DR(i2c) = x->wr[m->n++];
+            if( m->n == x->wlen ) I2C_CR2(i2c) &= ~I2C_CR2_ITBUFEN;
+        }
+        else if( (sr1 & I2C_SR1_BTF)
+              && (m->dma ? !DMA_SNDTR(m->txs.dma, m->txs.stream)
+                         : m->n == x->wlen) )
+            i2c_master_wr_end(m, x);
+        break;
+    case I2C_MASTER_RX:
+        // single byte read, the STOP is already on its way
+        if( !m->dma && (sr1 & I2C_SR1_RxNE) )
+        {
+            x->rd[0] = I2C_DR(i2c);
+            i2c_master_end(m, I2C_MASTER_OK);
+        }
+        break;
+    case I2C_MASTER_IDLE:
+    case I2C_MASTER_RECOVER:
+    default:
+        // BTF left over from a START / STOP the hardware is still sending
+        break;
+    }
+}
+
+void i2c_master_er_irq(S_i2cMaster *m)
+{
+    uint32_t i2c = m->i2c;
+    uint32_t sr1 = I2C_SR1(i2c) & I2C_MASTER_SR1_ERR;
+    int err;
+
+    // rc_w0 - zeroes clear exactly the flags seen
+    I2C_SR1(i2c) = ~sr1 & I2C_MASTER_SR1_ERR;
+    if( !sr1 ) return;
+
+    if( sr1 & (I2C_SR1_BERR | I2C_SR1_OVR | I2C_SR1_TIMEOUT
+               | I2C_SR1_PECERR | I2C_SR1_SMBALERT) )
+    {
+        m->stats.bus_errors++;
+        m->recover = 1;
+        err = I2C_MASTER_ERR_BUS;
+    }
+    else if( sr1 & I2C_SR1_ARLO )
+    {
+        m->stats.arlo++;
+        err = I2C_MASTER_ERR_ARLO;
+    }
+    else
+    {
+        m->stats.nacks++;
+        err = I2C_MASTER_ERR_NACK;
+    }
+
+    if( m->state == I2C_MASTER_IDLE || m->state == I2C_MASTER_RECOVER )
+        return;
+
+    i2c_master_halt(m);
+    if( err == I2C_MASTER_ERR_ARLO && ++m->tries <= I2C_MASTER_RETRIES )
+    {
+        // the interface fell back to slave, START waits for a free bus
+        i2c_master_start(m, 0);
+        return;
+    }
+    if( err == I2C_MASTER_ERR_NACK ) I2C_CR1(i2c) |= I2C_CR1_STOP;
+    i2c_master_end(m, err);
+}
+
+void i2c_master_dma_irq(S_i2cMaster *m)
+{
+    int err = I2C_MASTER_OK;
+    uint32_t done = 0;
+
+    if( dma_get_interrupt_flag(m->txs.dma, m->txs.stream, DMA_TEIF) )
+        err = I2C_MASTER_ERR_DMA;
+    if( dma_get_interrupt_flag(m->rxs.dma, m->rxs.stream, DMA_TEIF) )
+        err = I2C_MASTER_ERR_DMA;
+    if( dma_get_interrupt_flag(m->rxs.dma, m->rxs.stream, DMA_TCIF) )
+        done = 1;
+    dma_clear_interrupt_flags(m->txs.dma, m->txs.stream,
+                              I2C_MASTER_DMA_FLAGS);
+    dma_clear_interrupt_flags(m->rxs.dma, m->rxs.stream,
+                              I2C_MASTER_DMA_FLAGS);
+
+    if( !m->dma ) return;
+    if( err || (done && m->state == I2C_MASTER_RX) )
+    {
+        // the last byte has been NACKed already (LAST)
+        I2C_CR1(m->i2c) |= I2C_CR1_STOP;
+        i2c_master_end(m, err);
+    }
+}
+
+void i2c_master_poll(S_i2cMaster *m)
+{
+    E_i2cState st;
+    bool masked = cm_mask_interrupts(true);
+
+    st = m->state;
+    if( st != I2C_MASTER_IDLE && st != I2C_MASTER_RECOVER
+        && _tocFrom(m->started) > I2C_MASTER_TIMEOUT_MS )
+    {
+        m->stats.timeouts++;
+        m->recover = 1;
+        i2c_master_end(m, I2C_MASTER_ERR_TIMEOUT);
+    }
+    else if( st == I2C_MASTER_IDLE && m->recover )
+        m->state = I2C_MASTER_RECOVER;
+    st = m->state;
+    cm_mask_interrupts(masked);
+    if( st != I2C_MASTER_RECOVER ) return;
+
+    // the queue is stopped and the I2C interrupts are off - no need to
+    // hold the others back for the ~100 us of bit banging
+    i2c_master_recover(m);
+
+    masked = cm_mask_interrupts(true);
+    m->recover = 0;
+    if( m->head ) i2c_master_start(m, 1);
+    else m->state = I2C_MASTER_IDLE;
+    cm_mask_interrupts(masked);
+}
+
+uint32_t i2c_master_busy(const S_i2cMaster *m)
+{
+    return m->head != 0 || m->state != I2C_MASTER_IDLE;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,213 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Periodic I2C read scheduler with batching - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "i2c_sched.h"
+#include "waitin.h"
+
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void i2c_sched_done(void *arg, int err);
+static void i2c_sched_queue(S_i2cSched *s, S_i2cRead *d);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// I2C master done callback - from the I2C / DMA interrupt
+static void i2c_sched_done(void *arg, int err)
+{
+    S_i2cRead *d = arg;
+    S_i2cSched *s = d->sched;
+    S_i2cReadStats *st = &d->stats;
+    uint32_t now = DWT_CYCCNT;
+    uint32_t lat = now - d->t_queued;
+
+    if( err )
+    {
+        st->errors++;
+        st->last_err = err;
+    }
+    else
+    {
+        uint32_t back = (d->seq + 1) & 1;
+        if( st->samples )
+        {
+            uint32_t ival = now - d->stamp[d->seq & 1];
+            if( !st->ival_min || ival < st->ival_min ) st->ival_min = ival;
+            if( ival > st->ival_max ) st->ival_max = ival;
+        }
+        d->stamp[back] = now;
+        // publish - the back half becomes the front one
+        d->seq++;
+        st->samples++;
+        if( d->sample ) d->sample(d->arg, d->buf + back * d->len, d->len);
+    }
+
+    st->lat_last = lat;
+    if( lat > st->lat_max ) st->lat_max = lat;
+    st->lat_avg += ((int32_t)(lat - st->lat_avg)) / 16;
+    d->busy = 0;
+
+    if( !--s->inflight )
+    {
+        uint32_t busy = now - s->t_batch;
+        s->stats.busy_last = busy;
+        if( busy > s->stats.busy_max ) s->stats.busy_max = busy;
+    }
+}
+
+// interrupts masked by the caller
+static void i2c_sched_queue(S_i2cSched *s, S_i2cRead *d)
+{
+    S_i2cXfer *x = &d->x;
+
+    x->addr = d->addr;
+    if( d->flags & I2C_READ_NOREG )
+    {
+        x->wr = 0;
+        x->wlen = 0;
+    }
+    else
+    {
+        x->wr = &d->reg;
+        x->wlen = 1;
+    }
+    // the DMA fills the back half, the front one stays readable
+    x->rd = d->buf + ((d->seq + 1) & 1) * d->len;
+    x->rlen = d->len;
+    x->done = i2c_sched_done;
+    x->arg = d;
+
+    d->busy = 1;
+    d->t_queued = DWT_CYCCNT;
+    if( !s->inflight++ ) s->t_batch = d->t_queued;
+    i2c_master_submit(s->m, x);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_i2cSched(S_i2cSched *s, S_i2cMaster *m)
+{
+    s->m = m;
+    s->list = 0;
+    s->inflight = 0;
+    s->t_batch = 0;
+    s->stats = (S_i2cSchedStats){0};
+    dwt_enable_cycle_counter();
+}
+
+void i2c_sched_add(S_i2cSched *s, S_i2cRead *d)
+{
+    S_i2cRead **p;
+
+    d->sched = s;
+    d->seq = 0;
+    d->busy = 0;
+    d->stats = (S_i2cReadStats){0};
+    d->due = system_tick + d->phase;
+    d->next = 0;
+
+    bool masked = cm_mask_interrupts(true);
+    // registration order is the order within a batch
+    for(p = &s->list; *p; p = &(*p)->next) ;
+    *p = d;
+    cm_mask_interrupts(masked);
+}
+
+uint32_t i2c_sched_tick(S_i2cSched *s)
+{
+    uint32_t now;
+    uint32_t n = 0;
+    S_i2cRead *d;
+
+    i2c_master_poll(s->m);
+
+    // the whole batch goes into the master's queue at once
+    bool masked = cm_mask_interrupts(true);
+    now = system_tick;
+    for(d = s->list; d; d = d->next)
+    {
+        if( !d->period || (int32_t)(now - d->due) < 0 ) continue;
+
+        d->due += d->period;
+        if( (int32_t)(now - d->due) >= 0 )
+        {
+            // more than a period late - realign instead of bursting
+            d->stats.skipped += (now - d->due) / d->period + 1;
+            d->due = now + d->period;
+        }
+        if( d->busy )
+        {
+            d->stats.skipped++;
+            continue;
+        }
+        i2c_sched_queue(s, d);
+        n++;
+    }
+    if( n )
+    {
+        s->stats.batches++;
+        s->stats.reads += n;
+        if( n > s->stats.batch_max ) s->stats.batch_max = n;
+    }
+    cm_mask_interrupts(masked);
+    return n;
+}
+
+uint32_t i2c_sched_get(const S_i2cRead *d, void *out, uint32_t *stamp)
+{
+    uint32_t seq;
+
+    do
+    {
+        seq = d->seq;
+        if( !seq ) return 0;
+        __asm__ volatile("" ::: "memory");
+        memcpy(out, d->buf + (seq & 1) * d->len, d->len);
+        if( stamp ) *stamp = d->stamp[seq & 1];
+        __asm__ volatile("" ::: "memory");
+        // a publish meanwhile may have started refilling this half
+    } while( seq != d->seq );
+    return seq;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -25,6 +25,9 @@
 #include "defines.h"
 #include "led_f4.h"
 #include "waitin.h"
+#include "profiler.h"
+#include "race_watch.h"
+#include "fault_dump.h"
 
 #include <libopencm3/stm32/rcc.h>
 
@@ -38,6 +41,9 @@
 //#define SYSCFG_BASE         (0x40013800U)
 
 #define MINE_SYSCFG_EXTICR(i)		MMIO32(SYSCFG_BASE + 0x08 + (i)*4)
+// button EXTI lines - below the USART (USART_BUF_PRIORITY 0x40); the F4
+// keeps only bits 7:4 of a priority, so it has to be a multiple of 0x10
+#define EXTI_BUTTON_PRIORITY		0x80
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // TYPE DEFINITIONS
 //____________________________________________________
@@ -117,7 +123,7 @@ void INIT_isr(uint32_t port, uint32_t exti, uint8_t irqn)
 {
 	/* Enable exti interrupt. */
 	nvic_enable_irq(irqn);
-	nvic_set_priority(irqn,10);
+	nvic_set_priority(irqn, EXTI_BUTTON_PRIORITY);
 // exti
 	MINE_exti_select_source(exti, port);
 	exti_set_trigger(exti, EXTI_TRIGGER_BOTH);
@@ -131,6 +137,11 @@ int main(void)
 {
 
     INIT_clk();
+    // a fault record from before the last reset stays in BKPSRAM
+    INIT_faultDump();
+#ifdef PROFILE_ENABLE
+    INIT_profiler(168000000);
+#endif
 	//rcc_clock_setup_hse_3v3(&hse_8mhz_3v3[CLOCK_3V3_168MHZ]);
     INIT_leds();
 
@@ -162,6 +173,15 @@ int main(void)
     INIT_isr(GPIOD, EXTI8, NVIC_EXTI9_5_IRQ);
     INIT_isr(GPIOE, EXTI9, NVIC_EXTI9_5_IRQ);
 
+#ifdef RACE_WATCH_ENABLE
+    // after all priorities are set - see race_watch.h
+    if( INIT_raceWatch() >= 2 )
+    {
+        race_watch_arm(0, &system_tick, sizeof(system_tick));
+        race_watch_arm(1, &tic_toc_start, sizeof(tic_toc_start));
+    }
+#endif
+
     //DBG_trySetup();
 
 
@@ -0,0 +1,173 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      MPU region presets applied before main - see mpu_guard.h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "mpu_guard.h"
+
+#include <libopencm3/cm3/mpu.h>
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/vector.h>
+
+// whole module only with "make MPU_GUARD=1" (default) - it takes over
+// pre_main_hook
+#ifdef MPU_GUARD_ENABLE
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define MPU_ATTR_FLASH      (MPU_RASR_ATTR_AP_PRO_URO | MPU_RASR_ATTR_SCB_NSH_WT)
+#define MPU_ATTR_RAM        (MPU_RASR_ATTR_AP_PRW_URW | MPU_RASR_ATTR_XN \
+                            | MPU_RASR_ATTR_SCB_NSH_WB)
+#define MPU_ATTR_DMA        (MPU_RASR_ATTR_AP_PRW_URW | MPU_RASR_ATTR_XN \
+                            | MPU_RASR_ATTR_TEX_NORMAL_NC | MPU_RASR_ATTR_S)
+#define MPU_ATTR_GUARD      (MPU_RASR_ATTR_AP_PNO_UNO | MPU_RASR_ATTR_XN)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static uint32_t mpu_guard_base;
+static uint32_t mpu_dma_used;
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+// end of .bss and end of RAM, from the libopencm3 linker script
+extern unsigned _ebss, _stack;
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t mpu_size_log2(uint32_t size);
+static uint32_t mpu_guard_place(void);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// 0 when size is not a power of 2 in 32 B .. 4 GB
+static uint32_t mpu_size_log2(uint32_t size)
+{
+    if( size < 32 || (size & (size - 1)) ) return 0;
+    return 31 - __builtin_clz(size);
+}
+
+static uint32_t mpu_guard_place(void)
+{
+    uint32_t ebss = (uint32_t)&_ebss;
+    uint32_t low = (ebss + MPU_GUARD_BYTES - 1) & ~(MPU_GUARD_BYTES - 1u);
+    uint32_t base = low;
+
+    if( MPU_STACK_BYTES )
+    {
+        base = ((uint32_t)&_stack - MPU_STACK_BYTES - MPU_GUARD_BYTES)
+             & ~(MPU_GUARD_BYTES - 1u);
+        if( base < low ) base = low;
+    }
+    return base;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+uint32_t INIT_mpuGuard(void)
+{
+    uint32_t base;
+
+    if( ((MPU_TYPE & MPU_TYPE_DREGION) >> MPU_TYPE_DREGION_LSB) < 8 )
+        return 0;
+
+    MPU_CTRL = 0;
+    mpu_region_set(MPU_REGION_FLASH, MPU_FLASH_BASE, MPU_FLASH_BYTES,
+                   MPU_ATTR_FLASH);
+    mpu_region_set(MPU_REGION_SRAM, MPU_SRAM_BASE, MPU_SRAM_BYTES,
+                   MPU_ATTR_RAM);
+    mpu_region_set(MPU_REGION_CCM, MPU_CCM_BASE, MPU_CCM_BYTES,
+                   MPU_ATTR_RAM);
+    for(base = MPU_REGION_DMA0; base < MPU_REGION_GUARD; base++)
+        mpu_region_disable(base);
+    mpu_dma_used = 0;
+
+    base = mpu_guard_place();
+    mpu_region_set(MPU_REGION_GUARD, base, MPU_GUARD_BYTES, MPU_ATTR_GUARD);
+    mpu_guard_base = base;
+
+    // HFNMIENA stays 0 - HardFault/NMI read past the guard, the other
+    // fault handlers turn the MPU off themselves (fault_dump.c)
+    MPU_CTRL = MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE;
+    SCB_SHCSR |= SCB_SHCSR_MEMFAULTENA;
+    __asm__ volatile("dsb\n isb" ::: "memory");
+    return base;
+}
+
+int mpu_region_set(uint32_t region, uint32_t base, uint32_t size,
+                   uint32_t attr)
+{
+    uint32_t n = mpu_size_log2(size);
+
+    if( region > 7 || !n || (base & (size - 1)) ) return -1;
+
+    bool masked = cm_mask_interrupts(true);
+    MPU_RNR = region;
+    MPU_RBAR = base & MPU_RBAR_ADDR;
+    MPU_RASR = attr | MPU_RASR_SIZE_LOG2(n) | MPU_RASR_ENABLE;
+    __asm__ volatile("dsb\n isb" ::: "memory");
+    cm_mask_interrupts(masked);
+    return 0;
+}
+
+void mpu_region_disable(uint32_t region)
+{
+    if( region > 7 ) return;
+    bool masked = cm_mask_interrupts(true);
+    MPU_RNR = region;
+    MPU_RASR = 0;
+    __asm__ volatile("dsb\n isb" ::: "memory");
+    cm_mask_interrupts(masked);
+}
+
+int mpu_dma_region(volatile void *buf, uint32_t size)
+{
+    uint32_t region;
+
+    if( mpu_dma_used >= MPU_REGION_DMA_COUNT ) return -1;
+    region = MPU_REGION_DMA0 + mpu_dma_used;
+    if( mpu_region_set(region, (uint32_t)buf, size, MPU_ATTR_DMA) ) return -1;
+    mpu_dma_used++;
+    return region;
+}
+
+uint32_t mpu_stack_limit(void)
+{
+    return mpu_guard_base ? mpu_guard_base + MPU_GUARD_BYTES : 0;
+}
+
+// called by reset_handler between pre_main() and main()
+void pre_main_hook(void)
+{
+    INIT_mpuGuard();
+}
+
+#endif // MPU_GUARD_ENABLE
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
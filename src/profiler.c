@@ -0,0 +1,180 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Cycle accurate function profiler - see profiler.h
+\descrptn
+    Nothing in here may be instrumented (the Makefile excludes this file and
+    every function is PROF_NOINSTR), and the hooks touch the DWT registers
+    directly instead of calling dwt_read_cycle_counter().
+    ISRs are nested inside whatever they preempted, so one shadow stack serves
+    all contexts - the preempted function gets the ISR in its inclusive time
+    but not in its exclusive time.
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "profiler.h"
+#include "defines.h"
+
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+typedef struct _S_profFrame{
+    uint32_t fn;
+    uint32_t start;         // CYCCNT at entry
+    uint32_t child;         // cycles spent in callees
+} S_profFrame;
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static S_profFrame prof_stack[PROF_STACK_DEPTH];
+// may exceed PROF_STACK_DEPTH - frames above it are only counted
+static uint32_t prof_depth;
+//____________________________________________________
+// other variables
+volatile S_profTable prof_table;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+PROF_NOINSTR static volatile S_profEntry *prof_lookup(uint32_t fn);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// Fibonacci hashing + linear probing, returns 0 when the table is full
+static volatile S_profEntry *prof_lookup(uint32_t fn)
+{
+    uint32_t i = (fn * 2654435761u) >> (32 - PROF_TABLE_BITS);
+    uint32_t n;
+    for(n = 0; n < PROF_TABLE_SIZE; n++)
+    {
+        volatile S_profEntry *e = &prof_table.entry[i];
+        if( e->fn == fn ) return e;
+        if( e->fn == 0 )
+        {
+            e->fn = fn;
+            return e;
+        }
+        i = (i + 1) & (PROF_TABLE_SIZE - 1);
+    }
+    return 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_profiler(uint32_t cpu_hz)
+{
+    prof_table.enabled = 0;
+    if( !dwt_enable_cycle_counter() ) return -1;
+
+    prof_table.magic = PROF_MAGIC;
+    prof_table.version = PROF_VERSION;
+    prof_table.size = PROF_TABLE_SIZE;
+    prof_table.cpu_hz = cpu_hz;
+    profiler_reset();
+    profiler_enable(1);
+    return 0;
+}
+
+void profiler_reset(void)
+{
+    uint32_t i;
+    bool masked = cm_mask_interrupts(true);
+    for(i = 0; i < PROF_TABLE_SIZE; i++)
+    {
+        prof_table.entry[i].fn = 0;
+        prof_table.entry[i].calls = 0;
+        prof_table.entry[i].incl = 0;
+        prof_table.entry[i].excl = 0;
+    }
+    prof_table.lost_full = 0;
+    prof_table.lost_depth = 0;
+    prof_table.max_depth = 0;
+    cm_mask_interrupts(masked);
+}
+
+void profiler_enable(uint32_t enable)
+{
+    bool masked = cm_mask_interrupts(true);
+    // frames pushed before disarming would never be popped
+    prof_depth = 0;
+    prof_table.enabled = enable;
+    cm_mask_interrupts(masked);
+}
+
+void __cyg_profile_func_enter(void *fn, void *call_site)
+{
+    UNUSED(call_site)
+    if( !prof_table.enabled ) return;
+
+    bool masked = cm_mask_interrupts(true);
+    uint32_t d = prof_depth++;
+    if( d < PROF_STACK_DEPTH )
+    {
+        S_profFrame *f = &prof_stack[d];
+        f->fn = (uint32_t)fn & ~1u;
+        f->child = 0;
+        if( d >= prof_table.max_depth ) prof_table.max_depth = d + 1;
+        // stamp as late as possible so the hook itself is not charged to fn
+        f->start = DWT_CYCCNT;
+    }
+    else
+        prof_table.lost_depth++;
+    cm_mask_interrupts(masked);
+}
+
+void __cyg_profile_func_exit(void *fn, void *call_site)
+{
+    uint32_t now = DWT_CYCCNT;
+    UNUSED(fn)
+    UNUSED(call_site)
+    if( !prof_table.enabled ) return;
+
+    bool masked = cm_mask_interrupts(true);
+    if( prof_depth == 0 )
+    {   // armed in the middle of a call chain - nothing to pop
+        cm_mask_interrupts(masked);
+        return;
+    }
+    uint32_t d = --prof_depth;
+    if( d < PROF_STACK_DEPTH )
+    {
+        S_profFrame *f = &prof_stack[d];
+        uint32_t elapsed = now - f->start;
+        volatile S_profEntry *e = prof_lookup(f->fn);
+        if( e )
+        {
+            e->calls++;
+            e->incl += elapsed;
+            e->excl += elapsed - f->child;
+        }
+        else
+            prof_table.lost_full++;
+        if( d > 0 ) prof_stack[d - 1].child += elapsed;
+    }
+    cm_mask_interrupts(masked);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
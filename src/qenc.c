@@ -0,0 +1,217 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Quadrature encoder, velocity estimate - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "qenc.h"
+
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/dwt.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define QENC_NO_ITR         0xFF
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint8_t qenc_itr(uint32_t tb, uint32_t tim);
+static int32_t qenc_diff(const S_qenc *q, uint32_t a, uint32_t b);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// TS of tb selecting the TRGO of tim, RM0090 internal trigger connection
+static uint8_t qenc_itr(uint32_t tb, uint32_t tim)
+{
+    if( tb == TIM2 )
+    {
+        if( tim == TIM1 ) return TIM_SMCR_TS_ITR0;
+        if( tim == TIM8 ) return TIM_SMCR_TS_ITR1;
+        if( tim == TIM3 ) return TIM_SMCR_TS_ITR2;
+        if( tim == TIM4 ) return TIM_SMCR_TS_ITR3;
+    }
+    else if( tb == TIM5 )
+    {
+        if( tim == TIM2 ) return TIM_SMCR_TS_ITR0;
+        if( tim == TIM3 ) return TIM_SMCR_TS_ITR1;
+        if( tim == TIM4 ) return TIM_SMCR_TS_ITR2;
+        if( tim == TIM8 ) return TIM_SMCR_TS_ITR3;
+    }
+    return QENC_NO_ITR;
+}
+
+// a - b of two counter values, in the counter width
+static int32_t qenc_diff(const S_qenc *q, uint32_t a, uint32_t b)
+{
+    if( q->wide ) return (int32_t)(a - b);
+    return (int16_t)(a - b);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_qenc(S_qenc *q, uint32_t tim, uint32_t tb, uint8_t tb_ch)
+{
+    uint8_t itr = tb ? qenc_itr(tb, tim) : QENC_NO_ITR;
+    enum tim_ic_id ic = (enum tim_ic_id)(tb_ch - 1);
+
+    q->tim = tim;
+    q->tb = itr == QENC_NO_ITR ? 0 : tb;
+    q->tb_ch = tb_ch;
+    q->wide = tim == TIM2 || tim == TIM5;
+    q->have = 0;
+    q->pos = 0;
+    q->vel = 0;
+    q->e_pos = 0;
+    q->stats = (S_qencStats){0};
+    dwt_enable_cycle_counter();
+
+    timer_disable_counter(tim);
+    timer_set_prescaler(tim, 0);
+    timer_set_period(tim, q->wide ? 0xFFFFFFFF : 0xFFFF);
+    timer_ic_set_input(tim, TIM_IC1, TIM_IC_IN_TI1);
+    timer_ic_set_input(tim, TIM_IC2, TIM_IC_IN_TI2);
+    timer_ic_set_filter(tim, TIM_IC1, QENC_FILTER);
+    timer_ic_set_filter(tim, TIM_IC2, QENC_FILTER);
+    // TI1FP1 / TI2FP2 not inverted, counting on both edges of both
+    TIM_CCER(tim) &= ~(TIM_CCER_CC1P | TIM_CCER_CC1NP
+                       | TIM_CCER_CC2P | TIM_CCER_CC2NP);
+    timer_slave_set_mode(tim, TIM_SMCR_SMS_EM3);
+    timer_generate_event(tim, TIM_EGR_UG);
+    timer_enable_counter(tim);
+    q->cnt = TIM_CNT(tim);
+
+    if( !q->tb )
+    {
+        q->t_edge = DWT_CYCCNT;
+        return;
+    }
+
+    // IC1 latches CNT on the rising A edge, its pulse goes to tb as TRGO
+    TIM_CCER(tim) |= TIM_CCER_CC1E;
+    timer_set_master_mode(tim, TIM_CR2_MMS_COMPARE_PULSE);
+
+    if( !(TIM_CR1(tb) & TIM_CR1_CEN) )
+    {
+        timer_set_prescaler(tb, 0);
+        timer_set_period(tb, 0xFFFFFFFF);
+        timer_generate_event(tb, TIM_EGR_UG);
+        timer_enable_counter(tb);
+    }
+    // slave mode stays off - TS only routes the trigger to TRC
+    timer_slave_set_trigger(tb, itr);
+    timer_ic_set_input(tb, ic, TIM_IC_IN_TRC);
+    TIM_CCER(tb) |= TIM_CCER_CC1E << (4 * ic);
+    q->t_edge = (&TIM_CCR1(tb))[ic];
+}
+
+int32_t qenc_poll(S_qenc *q)
+{
+    uint32_t hz = q->tb ? QENC_TB_HZ : QENC_SYSCLK_HZ;
+    // counts between two timed edges when nothing else is known
+    uint32_t step = q->tb ? 4 : 1;
+    uint32_t cnt, now, t = 0, c = 0, dt;
+    int32_t d, e;
+    uint8_t edge;
+
+    if( q->tb )
+    {
+        volatile uint32_t *ccr = &TIM_CCR1(q->tb) + (q->tb_ch - 1);
+        // both captures are latched by the same edge, read a matching pair
+        do
+        {
+            t = *ccr;
+            c = TIM_CCR1(q->tim);
+        } while( t != *ccr );
+        cnt = TIM_CNT(q->tim);
+        now = TIM_CNT(q->tb);
+    }
+    else
+    {
+        cnt = TIM_CNT(q->tim);
+        now = DWT_CYCCNT;
+    }
+
+    d = qenc_diff(q, cnt, q->cnt);
+    q->cnt = cnt;
+    q->pos += d;
+    q->stats.polls++;
+    if( (uint32_t)(d < 0 ? -d : d) > q->stats.step_max )
+        q->stats.step_max = d < 0 ? -d : d;
+
+    if( q->tb )
+    {
+        edge = t != q->t_edge;
+        e = q->pos - qenc_diff(q, cnt, c);
+    }
+    else
+    {
+        edge = d != 0;
+        t = now;
+        e = q->pos;
+    }
+
+    if( edge )
+    {
+        if( q->have )
+        {
+            dt = t - q->t_edge;
+            q->vel = ((int64_t)(e - q->e_pos) * hz << QENC_VEL_FRAC)
+                     / (int64_t)dt;
+            q->stats.edges++;
+        }
+        q->have = 1;
+        q->e_pos = e;
+        q->t_edge = t;
+    }
+    else if( q->have )
+    {
+        dt = now - q->t_edge;
+        if( dt > hz / 1000 * QENC_STOP_MS )
+        {
+            // the stamps would wrap - next edge starts over
+            if( q->vel ) q->stats.stops++;
+            q->vel = 0;
+            q->have = 0;
+        }
+        else
+        {
+            int64_t bound = ((int64_t)step * hz << QENC_VEL_FRAC) / dt;
+            if( q->vel > bound ) q->vel = bound;
+            if( q->vel < -bound ) q->vel = -bound;
+        }
+    }
+    return q->pos;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
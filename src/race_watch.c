@@ -0,0 +1,217 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      DWT write watchpoints logged from DebugMonitor - see race_watch.h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "race_watch.h"
+
+#include <libopencm3/cm3/scs.h>
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+// whole module only with "make RACE_WATCH=1" - it takes over DebugMonitor
+#ifdef RACE_WATCH_ENABLE
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+static uint32_t race_comps;
+//____________________________________________________
+// other variables
+volatile S_raceWatch race_watch[RACE_WATCH_COMPS];
+volatile S_raceHit race_ring[RACE_RING_SIZE];
+// head is written only by DebugMonitor, tail only by race_watch_read()
+volatile uint32_t race_ring_head;
+volatile uint32_t race_ring_tail;
+volatile uint32_t race_ring_dropped;
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void race_watch_record(uint32_t *frame, uint32_t exc_return)
+    __attribute__((used));
+static uint32_t race_watch_value(uint32_t addr, uint32_t size);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static uint32_t race_watch_value(uint32_t addr, uint32_t size)
+{
+    switch(size)
+    {
+        case 1:  return *(volatile uint8_t *)addr;
+        case 2:  return *(volatile uint16_t *)addr;
+        default: return *(volatile uint32_t *)addr;
+    }
+}
+
+// frame = stacked r0-r3, r12, lr, pc, xpsr of the interrupted writer
+static void race_watch_record(uint32_t *frame, uint32_t exc_return)
+{
+    uint32_t cycle = DWT_CYCCNT;
+    uint32_t context = frame[7] & 0x1FF;
+    uint32_t i;
+
+    for(i = 0; i < race_comps; i++)
+    {
+        // MATCHED clears on read
+        if( !(DWT_FUNCTION(i) & DWT_FUNCTIONx_MATCHED) ) continue;
+
+        volatile S_raceWatch *w = &race_watch[i];
+        w->writes++;
+        if( context ) w->handler_writes++;
+        if( context < 32 * RACE_CTX_WORDS )
+            w->ctx_seen[context / 32] |= 1u << (context % 32);
+
+        uint32_t head = race_ring_head;
+        if( head - race_ring_tail >= RACE_RING_SIZE )
+        {
+            race_ring_dropped++;
+            continue;
+        }
+        volatile S_raceHit *h = &race_ring[head & (RACE_RING_SIZE - 1)];
+        h->cycle = cycle;
+        h->pc = frame[6];
+        h->value = race_watch_value(w->addr, w->size);
+        h->context = context;
+        h->comp = i;
+        h->flags = (exc_return & (1 << 2)) ? RACE_HIT_PSP : 0;
+        race_ring_head = head + 1;
+    }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+uint32_t INIT_raceWatch(void)
+{
+    int32_t irqn;
+
+    if( SCS_DHCSR & SCS_DHCSR_C_DEBUGEN ) return 0;
+    if( !dwt_enable_cycle_counter() ) return 0;
+
+    race_comps = (DWT_CTRL & DWT_CTRL_NUMCOMP) >> DWT_CTRL_NUMCOMP_SHIFT;
+    if( race_comps > RACE_WATCH_COMPS ) race_comps = RACE_WATCH_COMPS;
+
+    // DebugMonitor alone in priority group 0 - it must preempt every writer
+    for(irqn = 0; irqn < NVIC_IRQ_COUNT; irqn++)
+        if( NVIC_IPR(irqn) < RACE_WATCH_MIN_PRIO )
+            NVIC_IPR(irqn) = RACE_WATCH_MIN_PRIO;
+    if( SCB_SHPR(SCB_SHPR_PRI_11_SVCALL) < RACE_WATCH_MIN_PRIO )
+        SCB_SHPR(SCB_SHPR_PRI_11_SVCALL) = RACE_WATCH_MIN_PRIO;
+    if( SCB_SHPR(SCB_SHPR_PRI_14_PENDSV) < RACE_WATCH_MIN_PRIO )
+        SCB_SHPR(SCB_SHPR_PRI_14_PENDSV) = RACE_WATCH_MIN_PRIO;
+    if( SCB_SHPR(SCB_SHPR_PRI_15_SYSTICK) < RACE_WATCH_MIN_PRIO )
+        SCB_SHPR(SCB_SHPR_PRI_15_SYSTICK) = RACE_WATCH_MIN_PRIO;
+    nvic_set_priority(DEBUG_MONITOR_IRQ, 0);
+
+    SCS_DEMCR |= SCS_DEMCR_TRCENA | SCS_DEMCR_VC_MON_EN;
+    return race_comps;
+}
+
+int race_watch_arm(uint32_t comp, volatile void *addr, uint32_t size)
+{
+    uint32_t mask;
+    uint32_t a = (uint32_t)addr;
+
+    if( comp >= race_comps ) return -1;
+    switch(size)
+    {
+        case 1: mask = 0; break;
+        case 2: mask = 1; break;
+        case 4: mask = 2; break;
+        default: return -1;
+    }
+    if( a & (size - 1) ) return -1;
+
+    bool masked = cm_mask_interrupts(true);
+    DWT_FUNCTION(comp) = DWT_FUNCTIONx_FUNCTION_DISABLED;
+    race_watch[comp].addr = a;
+    race_watch[comp].size = size;
+    DWT_COMP(comp) = a;
+    DWT_MASK(comp) = mask;
+    (void)DWT_FUNCTION(comp);   // drop a stale MATCHED flag
+    DWT_FUNCTION(comp) = DWT_FUNCTIONx_FUNCTION_DWATCH_W;
+    cm_mask_interrupts(masked);
+    return 0;
+}
+
+void race_watch_disarm(uint32_t comp)
+{
+    if( comp >= race_comps ) return;
+    DWT_FUNCTION(comp) = DWT_FUNCTIONx_FUNCTION_DISABLED;
+    race_watch[comp].addr = 0;
+}
+
+uint32_t race_watch_contexts(uint32_t comp)
+{
+    uint32_t n = 0;
+    uint32_t i;
+    if( comp >= RACE_WATCH_COMPS ) return 0;
+    for(i = 0; i < RACE_CTX_WORDS; i++)
+        n += __builtin_popcount(race_watch[comp].ctx_seen[i]);
+    return n;
+}
+
+uint32_t race_watch_read(S_raceHit *out, uint32_t max)
+{
+    uint32_t n = 0;
+    uint32_t tail = race_ring_tail;
+    while( n < max && tail != race_ring_head )
+    {
+        volatile S_raceHit *h = &race_ring[tail & (RACE_RING_SIZE - 1)];
+        out[n].cycle = h->cycle;
+        out[n].pc = h->pc;
+        out[n].value = h->value;
+        out[n].context = h->context;
+        out[n].comp = h->comp;
+        out[n].flags = h->flags;
+        n++;
+        tail++;
+    }
+    race_ring_tail = tail;
+    return n;
+}
+
+// picks the stack the writer used and hands its exception frame over
+void __attribute__((naked)) debug_monitor_handler(void)
+{
+    __asm__ volatile(
+        "tst    lr, #4          \n"
+        "ite    eq              \n"
+        "mrseq  r0, msp         \n"
+        "mrsne  r0, psp         \n"
+        "mov    r1, lr          \n"
+        "b      race_watch_record\n"
+    );
+}
+
+#endif // RACE_WATCH_ENABLE
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,210 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      SPI master on paired DMA streams with a queue - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "spi_dma.h"
+
+#include <libopencm3/stm32/spi.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/cortex.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define SPI_DMA_FLAGS       (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+// stand-ins for a missing tx / rx buffer (not incremented)
+static const uint16_t spi_dma_fill = 0xFFFF;
+static uint16_t spi_dma_sink;
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void spi_dma_start(S_spiDma *e, S_spiXfer *x);
+static void spi_dma_end(S_spiDma *e, int err);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static void spi_dma_start(S_spiDma *e, S_spiXfer *x)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t spi = e->spi;
+    uint32_t cr1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI
+                 | ((x->br & 7) << 3) | (x->mode & 3)
+                 | ((x->flags & SPI_XFER_16BIT) ? SPI_CR1_DFF_16BIT : 0)
+                 | ((x->flags & SPI_XFER_LSB_FIRST) ? SPI_CR1_LSBFIRST : 0);
+
+    // CPOL/CPHA/BR/DFF may change only with the SPI off
+    if( cr1 != e->cr1 )
+    {
+        SPI_CR1(spi) = cr1;
+        e->cr1 = cr1;
+        e->stats.reconfigs++;
+    }
+    if( x->cs_port ) gpio_clear(x->cs_port, x->cs_pin);
+
+    if( x->flags & SPI_XFER_16BIT )
+    {
+        d.periph_size = DMA_SxCR_PSIZE_16BIT;
+        d.mem_size = DMA_SxCR_MSIZE_16BIT;
+    }
+    else
+    {
+        d.periph_size = DMA_SxCR_PSIZE_8BIT;
+        d.mem_size = DMA_SxCR_MSIZE_8BIT;
+    }
+    d.periph_address = (uint32_t)&SPI_DR(spi);
+    d.number = x->len;
+
+    // RX first and on top, the TX stream then starts the clock
+    d.channel = e->rxs.channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_VERY_HIGH;
+    d.mode = x->rx ? DMA_SxCR_MINC : 0;
+    d.interrupts = DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.mem_address = x->rx ? (uint32_t)x->rx : (uint32_t)&spi_dma_sink;
+    dma_configure(e->rxs.dma, e->rxs.stream, &d);
+
+    d.channel = e->txs.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_PERIPHERAL;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.mode = x->tx ? DMA_SxCR_MINC : 0;
+    d.interrupts = DMA_SxCR_TEIE;
+    d.mem_address = x->tx ? (uint32_t)x->tx : (uint32_t)&spi_dma_fill;
+    dma_configure(e->txs.dma, e->txs.stream, &d);
+
+    SPI_CR1(spi) = cr1 | SPI_CR1_SPE;
+    dma_enable_stream(e->rxs.dma, e->rxs.stream);
+    dma_enable_stream(e->txs.dma, e->txs.stream);
+}
+
+// finishes the running transaction and starts the next one
+static void spi_dma_end(S_spiDma *e, int err)
+{
+    S_spiXfer *x = e->head;
+
+    if( err )
+    {
+        uint32_t spi = e->spi;
+
+        DMA_SCR(e->txs.dma, e->txs.stream) &= ~DMA_SxCR_EN;
+        DMA_SCR(e->rxs.dma, e->rxs.stream) &= ~DMA_SxCR_EN;
+        while( DMA_SCR(e->txs.dma, e->txs.stream) & DMA_SxCR_EN );
+        while( DMA_SCR(e->rxs.dma, e->rxs.stream) & DMA_SxCR_EN );
+        // the stop sets TCIF - it must not end the next transaction
+        dma_clear_interrupt_flags(e->txs.dma, e->txs.stream, SPI_DMA_FLAGS);
+        dma_clear_interrupt_flags(e->rxs.dma, e->rxs.stream, SPI_DMA_FLAGS);
+        // drain the SPI - an item left in DR (RXNE/OVR) would be the first
+        // RX item of the next transaction; spi_dma_start() sets SPE again
+        while( SPI_SR(spi) & SPI_SR_BSY );
+        SPI_CR1(spi) = e->cr1;
+        (void)SPI_DR(spi);
+        (void)SPI_SR(spi);
+        e->stats.errors++;
+    }
+    // the last RX item is in - the clock has stopped
+    if( x->cs_port && (err || !(x->flags & SPI_XFER_CS_HOLD)) )
+        gpio_set(x->cs_port, x->cs_pin);
+    e->stats.xfers++;
+    e->stats.items += x->len;
+
+    e->head = x->next;
+    if( !e->head ) e->tail = 0;
+    else spi_dma_start(e, e->head);
+    if( x->done ) x->done(x->arg, err);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_spiDma(S_spiDma *e, uint32_t spi, const S_dmaStream *rx,
+                 const S_dmaStream *tx)
+{
+    e->spi = spi;
+    e->rxs = *rx;
+    e->txs = *tx;
+    e->head = e->tail = 0;
+    e->stats = (S_spiDmaStats){0};
+
+    // software NSS held high - chip selects are plain GPIOs
+    e->cr1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;
+    SPI_CR1(spi) = e->cr1;
+    SPI_CR2(spi) = 0;
+    spi_enable_rx_dma(spi);
+    spi_enable_tx_dma(spi);
+
+    nvic_enable_irq(rx->irqn);
+    nvic_enable_irq(tx->irqn);
+}
+
+void spi_dma_submit(S_spiDma *e, S_spiXfer *x)
+{
+    x->next = 0;
+    bool masked = cm_mask_interrupts(true);
+    if( e->tail )
+    {
+        e->tail->next = x;
+        e->tail = x;
+    }
+    else
+    {
+        e->head = e->tail = x;
+        spi_dma_start(e, x);
+    }
+    cm_mask_interrupts(masked);
+}
+
+void spi_dma_irq(S_spiDma *e)
+{
+    int err = SPI_DMA_OK;
+    uint32_t done = 0;
+
+    if( dma_get_interrupt_flag(e->txs.dma, e->txs.stream, DMA_TEIF) )
+        err = SPI_DMA_ERR_TRANSFER;
+    if( dma_get_interrupt_flag(e->rxs.dma, e->rxs.stream, DMA_TEIF) )
+        err = SPI_DMA_ERR_TRANSFER;
+    if( dma_get_interrupt_flag(e->rxs.dma, e->rxs.stream, DMA_TCIF) )
+        done = 1;
+    dma_clear_interrupt_flags(e->txs.dma, e->txs.stream, SPI_DMA_FLAGS);
+    dma_clear_interrupt_flags(e->rxs.dma, e->rxs.stream, SPI_DMA_FLAGS);
+
+    if( e->head && (done || err) ) spi_dma_end(e, err);
+}
+
+uint32_t spi_dma_busy(const S_spiDma *e)
+{
+    return e->head != 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,133 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      ITM/TPIU/DWT setup for SWO profiling - see swo_trace.h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> project includes
+#include "swo_trace.h"
+
+#include <libopencm3/cm3/scs.h>
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/cm3/itm.h>
+#include <libopencm3/cm3/tpiu.h>
+#include <libopencm3/stm32/dbgmcu.h>
+#include <libopencm3/stm32/rcc.h>
+#include <libopencm3/stm32/gpio.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static uint32_t swo_sample_bits(uint32_t sample_period, uint32_t *bits);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// CYCTAP selects CYCCNT[6] or CYCCNT[10] as the sampling tick, POSTPRESET
+// divides it by 1..16 -> periods 64..1024 step 64 and 1024..16384 step 1024
+static uint32_t swo_sample_bits(uint32_t sample_period, uint32_t *bits)
+{
+    uint32_t tap = (sample_period > 1024) ? 1024 : 64;
+    uint32_t n = (sample_period + tap/2) / tap;
+    if( n < 1 ) n = 1;
+    if( n > 16 ) n = 16;
+
+    *bits = ((n - 1) << DWT_CTRL_POSTPRESET_SHIFT)
+          | ((n - 1) << DWT_CTRL_POSTCNT_SHIFT)
+          | ((tap == 1024) ? DWT_CTRL_CYCTAP : 0);
+    return n * tap;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+uint32_t INIT_swoTrace(uint32_t cpu_hz, uint32_t swo_baud, uint32_t sample_period)
+{
+    uint32_t bits = 0;
+    uint32_t period = 0;
+
+    // TRACESWO = PB3 AF0
+    rcc_periph_clock_enable(RCC_GPIOB);
+    gpio_mode_setup(GPIOB, GPIO_MODE_AF, GPIO_PUPD_NONE, GPIO3);
+    gpio_set_output_options(GPIOB, GPIO_OTYPE_PP, GPIO_OSPEED_100MHZ, GPIO3);
+    gpio_set_af(GPIOB, GPIO_AF0, GPIO3);
+
+    //____________________________________________________
+    // trace clock + asynchronous pin
+    SCS_DEMCR |= SCS_DEMCR_TRCENA;
+    DBGMCU_CR = (DBGMCU_CR & ~DBGMCU_CR_TRACE_MODE_MASK)
+              | DBGMCU_CR_TRACE_IOEN | DBGMCU_CR_TRACE_MODE_ASYNC;
+
+    //____________________________________________________
+    // TPIU - NRZ, formatter bypassed (only ITM is traced)
+    TPIU_LAR = SCS_LAR_KEY;
+    TPIU_CSPSR = 1;
+    TPIU_ACPR = (cpu_hz + swo_baud/2) / swo_baud - 1;
+    TPIU_SPPR = TPIU_SPPR_ASYNC_NRZ;
+    TPIU_FFCR = TPIU_FFCR_TRIGIN;
+
+    //____________________________________________________
+    // ITM - forward DWT packets, local timestamps in core cycles
+    ITM_LAR = SCS_LAR_KEY;
+    ITM_TCR = (SWO_TRACE_BUS_ID << 16) | ITM_TCR_TSPRESCALE_NONE
+            | ITM_TCR_TXENA | ITM_TCR_SYNCENA | ITM_TCR_TSENA
+            | ITM_TCR_ITMENA;
+    ITM_TPR = 0;
+    ITM_TER[0] = (1 << 0) | (1 << SWO_PORT_MARK);
+
+    //____________________________________________________
+    // DWT - exception trace, PC sampling, sync packets every 2^28 cycles
+    if( sample_period )
+        period = swo_sample_bits(sample_period, &bits);
+    DWT_CTRL = (DWT_CTRL & ~(DWT_CTRL_POSTPRESET | DWT_CTRL_POSTCNT
+                           | DWT_CTRL_CYCTAP | DWT_CTRL_SYNCTAP
+                           | DWT_CTRL_PCSAMPLENA))
+             | bits | DWT_CTRL_SYNCTAP_BIT28 | DWT_CTRL_EXCTRCENA
+             | DWT_CTRL_CYCCNTENA;
+    if( period )
+        DWT_CTRL |= DWT_CTRL_PCSAMPLENA;
+
+    return period;
+}
+
+void swo_trace_stop(void)
+{
+    DWT_CTRL &= ~(DWT_CTRL_PCSAMPLENA | DWT_CTRL_EXCTRCENA);
+}
+
+void swo_mark(uint32_t value)
+{
+    if( !(ITM_TCR & ITM_TCR_ITMENA) ) return;
+    if( !(ITM_TER[0] & (1 << SWO_PORT_MARK)) ) return;
+    while( !(ITM_STIM32(SWO_PORT_MARK) & ITM_STIM_FIFOREADY) );
+    ITM_STIM32(SWO_PORT_MARK) = value;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
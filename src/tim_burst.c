@@ -0,0 +1,289 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      PWM waveforms by the timer DMA burst - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "tim_burst.h"
+
+#include <libopencm3/stm32/timer.h>
+#include <libopencm3/cm3/nvic.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define TIM_BURST_FLAGS     (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+// sin 0..90 deg in 64 steps, Q15
+static const int16_t tim_burst_sin_tab[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void tim_burst_halt(S_timBurst *b);
+static void tim_burst_pad(S_timBurst *b, uint32_t idle);
+static int32_t tim_burst_sin(uint16_t a);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+static void tim_burst_halt(S_timBurst *b)
+{
+    timer_disable_irq(b->tim, TIM_DIER_UDE);
+    DMA_SCR(b->s.dma, b->s.stream) &= ~DMA_SxCR_EN;
+    b->busy = 0;
+}
+
+// every frame of the idle half = the last frame of the other one
+static void tim_burst_pad(S_timBurst *b, uint32_t idle)
+{
+    uint32_t fsize = b->len * b->item;
+    uint8_t *dst = b->buf + idle * b->half * fsize;
+    const uint8_t *last = b->buf + ((1 - idle) * b->half + b->half - 1)
+                          * fsize;
+    uint32_t i;
+
+    for(i = 0; i < b->half; i++)
+        memcpy(dst + i * fsize, last, fsize);
+}
+
+// a - full circle = 65536, Q15 result
+static int32_t tim_burst_sin(uint16_t a)
+{
+    uint32_t q = a >> 14;
+    uint32_t i = a & 0x3FFF;
+    uint32_t k, f;
+    int32_t v;
+
+    if( q & 1 ) i = 0x4000 - i;
+    k = i >> 8;
+    f = i & 0xFF;
+    v = tim_burst_sin_tab[k];
+    if( k < 64 )
+        v += ((tim_burst_sin_tab[k + 1] - v) * (int32_t)f) >> 8;
+    return q & 2 ? -v : v;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+void INIT_timBurst(S_timBurst *b, uint32_t tim, const S_dmaStream *s,
+                   uint8_t dba, uint8_t len)
+{
+    uint8_t r;
+
+    b->tim = tim;
+    b->s = *s;
+    b->dba = dba;
+    b->len = len;
+    b->item = (tim == TIM2 || tim == TIM5) ? 4 : 2;
+    b->busy = 0;
+    b->stats = (S_timBurstStats){0};
+
+    // a frame takes effect at the update after it was written, all at once
+    timer_enable_preload(tim);
+    for(r = dba; r < dba + len; r++)
+        if( r >= TIM_BURST_CCR1 && r < TIM_BURST_CCR1 + 4 )
+            timer_enable_oc_preload(tim,
+                (enum tim_oc_id)(TIM_OC1 + 2 * (r - TIM_BURST_CCR1)));
+
+    nvic_enable_irq(s->irqn);
+}
+
+int tim_burst_play(S_timBurst *b, void *buf, uint32_t frames,
+                   E_timBurstMode mode, F_timBurstFill fill, void *arg)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t dma = b->s.dma;
+    uint8_t stream = b->s.stream;
+
+    if( b->busy || !frames || frames * b->len > 0xFFFF ) return -1;
+    if( mode == TIM_BURST_STREAM && ((frames & 1) || !fill) ) return -1;
+
+    b->mode = mode;
+    b->buf = buf;
+    b->half = frames / 2;
+    b->fill = fill;
+    b->arg = arg;
+    b->ending = 0;
+
+    if( mode == TIM_BURST_STREAM )
+    {
+        if( !fill(arg, b->buf, b->half) )
+        {
+            tim_burst_pad(b, 1);
+            b->ending = 2;
+        }
+        else if( !fill(arg, b->buf + b->half * b->len * b->item, b->half) )
+            b->ending = 1;
+    }
+
+    timer_disable_irq(b->tim, TIM_DIER_UDE);
+    DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+    while( DMA_SCR(dma, stream) & DMA_SxCR_EN ) ;
+    dma_clear_interrupt_flags(dma, stream, TIM_BURST_FLAGS);
+
+    d.channel = b->s.channel;
+    d.direction = DMA_SxCR_DIR_MEM_TO_PERIPHERAL;
+    // a late burst shows as a stretched PWM period
+    d.priority = DMA_SxCR_PL_VERY_HIGH;
+    d.periph_size = b->item == 4 ? DMA_SxCR_PSIZE_32BIT : DMA_SxCR_PSIZE_16BIT;
+    d.mem_size = b->item == 4 ? DMA_SxCR_MSIZE_32BIT : DMA_SxCR_MSIZE_16BIT;
+    d.mode = DMA_SxCR_MINC | (mode == TIM_BURST_ONCE ? 0 : DMA_SxCR_CIRC);
+    d.interrupts = DMA_SxCR_TEIE;
+    if( mode == TIM_BURST_ONCE ) d.interrupts |= DMA_SxCR_TCIE;
+    if( mode == TIM_BURST_STREAM )
+        d.interrupts |= DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+    d.periph_address = (uint32_t)&TIM_DMAR(b->tim);
+    d.mem_address = (uint32_t)buf;
+    d.number = frames * b->len;
+    dma_configure(dma, stream, &d);
+
+    // writing DCR also restarts the burst at DBA
+    TIM_DCR(b->tim) = ((uint32_t)(b->len - 1) << 8) | b->dba;
+    b->busy = 1;
+    b->stats.plays++;
+    dma_enable_stream(dma, stream);
+    timer_enable_irq(b->tim, TIM_DIER_UDE);
+    return 0;
+}
+
+void tim_burst_stop(S_timBurst *b)
+{
+    tim_burst_halt(b);
+    dma_clear_interrupt_flags(b->s.dma, b->s.stream, TIM_BURST_FLAGS);
+}
+
+void tim_burst_irq(S_timBurst *b)
+{
+    uint32_t dma = b->s.dma;
+    uint8_t stream = b->s.stream;
+    uint8_t ht = dma_get_interrupt_flag(dma, stream, DMA_HTIF);
+    uint8_t tc = dma_get_interrupt_flag(dma, stream, DMA_TCIF);
+    uint8_t te = dma_get_interrupt_flag(dma, stream, DMA_TEIF);
+    uint32_t idle;
+
+    dma_clear_interrupt_flags(dma, stream, TIM_BURST_FLAGS);
+    if( !b->busy ) return;
+
+    if( te )
+    {
+        b->stats.errors++;
+        tim_burst_halt(b);
+        return;
+    }
+    if( b->mode == TIM_BURST_ONCE )
+    {
+        if( tc ) tim_burst_halt(b);
+        return;
+    }
+    if( b->mode != TIM_BURST_STREAM || !(ht || tc) ) return;
+    if( ht && tc ) b->stats.late++;
+
+    // the half the DMA is not in - NDTR counts down
+    idle = DMA_SNDTR(dma, stream) > b->half * b->len ? 1 : 0;
+    switch( b->ending )
+    {
+    case 0:
+        b->stats.refills++;
+        if( !b->fill(b->arg, b->buf + idle * b->half * b->len * b->item,
+                     b->half) )
+            b->ending = 1;
+        break;
+    case 1:
+        // the last half is playing, anything after it repeats its end
+        tim_burst_pad(b, idle);
+        b->ending = 2;
+        break;
+    default:
+        tim_burst_halt(b);
+        break;
+    }
+}
+
+void tim_burst_led_start(S_timBurstLed *l, const uint8_t *grb,
+                         uint32_t leds)
+{
+    l->grb = grb;
+    l->bits = leds * 24;
+    l->bit = 0;
+    l->reset = TIM_BURST_LED_RESET;
+}
+
+uint8_t tim_burst_led_fill(void *arg, void *half, uint32_t frames)
+{
+    S_timBurstLed *l = arg;
+    uint16_t *ccr = half;
+    uint32_t i;
+
+    for(i = 0; i < frames; i++)
+    {
+        if( l->bit < l->bits )
+        {
+            uint8_t one = l->grb[l->bit >> 3] & (0x80 >> (l->bit & 7));
+            ccr[i] = one ? TIM_BURST_LED_T1H : TIM_BURST_LED_T0H;
+            l->bit++;
+        }
+        else
+        {
+            ccr[i] = 0;
+            if( l->reset ) l->reset--;
+        }
+    }
+    return l->bit < l->bits || l->reset;
+}
+
+void tim_burst_sine(uint16_t *tab, uint32_t frames, uint8_t phases,
+                    uint16_t arr, uint16_t amp)
+{
+    uint32_t i, k;
+
+    for(i = 0; i < frames; i++)
+        for(k = 0; k < phases; k++)
+        {
+            uint16_t a = (uint16_t)((i * 65536) / frames
+                                    + (k * 65536) / phases);
+            *tab++ = arr / 2 + ((int32_t)amp * tim_burst_sin(a)) / 65536;
+        }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES
@@ -0,0 +1,317 @@
+/***********
+\project    MRBT - Robotick den 2014
+\author 	xdavid10, xslizj00, xdvora0u @ FEEC-VUTBR
+\filename	.c
+\contacts	Bc. Daniel DAVIDEK	<danieldavidek@gmail.com>
+            Bc. Jiri SLIZ       <xslizj00@stud.feec.vutbr.cz>
+            Bc. Michal Dvorak   <xdvora0u@stud.feec.vutbr.cz>
+\date		2014_03_30
+\brief      Interrupt driven USART with ring buffers - see .h
+\descrptn
+\license    LGPL License Terms \ref lgpl_license
+***********/
+/* DOCSTYLE: gr4viton_2014_A <goo.gl/1deDBa> */
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INCLUDES
+//_________> system includes
+#include <string.h>
+//_________> project includes
+#include "usart_buf.h"
+
+#include <libopencm3/stm32/usart.h>
+#include <libopencm3/cm3/nvic.h>
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// MACRO DEFINITIONS
+#define USART_BUF_ERRORS    (USART_SR_ORE | USART_SR_NE | USART_SR_FE \
+                            | USART_SR_PE)
+#define USART_BUF_DMA_FLAGS (DMA_TCIF | DMA_HTIF | DMA_TEIF | DMA_DMEIF \
+                            | DMA_FEIF)
+// NDTR is 16 bits
+#define USART_BUF_DMA_MAX   32768u
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// TYPE DEFINITIONS
+//____________________________________________________
+// enumerations
+//____________________________________________________
+// structs
+//____________________________________________________
+// unions
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// VARIABLE DEFINITIONS
+//____________________________________________________
+// static variables
+//____________________________________________________
+// other variables
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL VARIABLE DECLARATIONS
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DECLARATIONS
+static void usart_buf_errors(S_usartBuf *u, uint32_t sr);
+static void usart_buf_rx_update(S_usartBuf *u);
+static void usart_buf_rx_clamp(S_usartBuf *u);
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// STATIC FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+// rare path - kept out of the byte loop
+static void usart_buf_errors(S_usartBuf *u, uint32_t sr)
+{
+    if( sr & USART_SR_ORE ) u->stats.overrun++;
+    if( sr & USART_SR_FE ) u->stats.framing++;
+    if( sr & USART_SR_NE ) u->stats.noise++;
+    if( sr & USART_SR_PE ) u->stats.parity++;
+}
+
+// DMA RX mode - moves rx_head up to the DMA write position; called from the
+// USART and the DMA interrupt, which share one priority
+static void usart_buf_rx_update(S_usartBuf *u)
+{
+    uint32_t pos = u->rx_mask + 1 - DMA_SNDTR(u->rxs.dma, u->rxs.stream);
+    uint32_t n = (pos - u->rx_pos) & u->rx_mask;
+
+    u->rx_pos = pos & u->rx_mask;
+    u->rx_head += n;
+    u->stats.rx += n;
+}
+
+// DMA RX mode - a lapped reader skips to the oldest byte still in the ring
+static void usart_buf_rx_clamp(S_usartBuf *u)
+{
+    uint32_t n = u->rx_head - u->rx_tail;
+    if( n > u->rx_mask + 1 )
+    {
+        u->stats.rx_dropped += n - (u->rx_mask + 1);
+        u->rx_tail = u->rx_head - (u->rx_mask + 1);
+    }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// INLINE FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// OTHER FUNCTION DEFINITIONS - doxygen description should be in HEADERFILE
+
+int INIT_usartBuf(S_usartBuf *u, uint32_t usart, uint8_t irqn, uint32_t baud,
+                  uint8_t *rx, uint32_t rx_size, uint8_t *tx, uint32_t tx_size)
+{
+    if( !rx_size || (rx_size & (rx_size - 1)) ) return -1;
+    if( !tx_size || (tx_size & (tx_size - 1)) ) return -1;
+
+    memset(u, 0, sizeof(*u));
+    u->usart = usart;
+    u->rx = rx;
+    u->rx_mask = rx_size - 1;
+    u->tx = tx;
+    u->tx_mask = tx_size - 1;
+
+    usart_disable(usart);
+    usart_set_baudrate(usart, baud);
+    usart_set_databits(usart, 8);
+    usart_set_stopbits(usart, USART_STOPBITS_1);
+    usart_set_parity(usart, USART_PARITY_NONE);
+    usart_set_flow_control(usart, USART_FLOWCONTROL_NONE);
+    usart_set_mode(usart, USART_MODE_TX_RX);
+    usart_enable_rx_interrupt(usart);
+
+    nvic_set_priority(irqn, USART_BUF_PRIORITY);
+    nvic_enable_irq(irqn);
+    usart_enable(usart);
+    return 0;
+}
+
+void usart_buf_irq(S_usartBuf *u)
+{
+    uint32_t usart = u->usart;
+    uint32_t sr = USART_SR(usart);
+
+    if( u->rx_dma )
+    {
+        // the DMA owns DR; an SR + DR read clears IDLE and the error flags
+        if( sr & (USART_SR_IDLE | USART_BUF_ERRORS) )
+        {
+            (void)USART_DR(usart);
+            if( sr & USART_BUF_ERRORS ) usart_buf_errors(u, sr);
+        }
+        if( sr & USART_SR_IDLE )
+        {
+            uint32_t len;
+            usart_buf_rx_update(u);
+            len = u->rx_head - u->frame_start;
+            u->frame_start = u->rx_head;
+            if( len )
+            {
+                u->stats.frames++;
+                if( u->frame ) u->frame(u->frame_arg, len);
+            }
+        }
+        sr = 0;
+    }
+
+    // RXNE (and ORE, which comes with RXNEIE) - the SR read above plus the
+    // DR read clear the error flags
+    while( sr & (USART_SR_RXNE | USART_SR_ORE) )
+    {
+        uint8_t c = USART_DR(usart);
+        uint32_t head = u->rx_head;
+        if( sr & USART_BUF_ERRORS ) usart_buf_errors(u, sr);
+        if( sr & USART_SR_RXNE )
+        {
+            if( head - u->rx_tail > u->rx_mask ) u->stats.rx_dropped++;
+            else
+            {
+                u->rx[head & u->rx_mask] = c;
+                u->rx_head = head + 1;
+                u->stats.rx++;
+            }
+        }
+        sr = USART_SR(usart);
+    }
+
+    if( (USART_SR(usart) & USART_SR_TXE)
+        && (USART_CR1(usart) & USART_CR1_TXEIE) )
+    {
+        uint32_t tail = u->tx_tail;
+        if( tail == u->tx_head )
+            USART_CR1(usart) &= ~USART_CR1_TXEIE;
+        else
+        {
+            USART_DR(usart) = u->tx[tail & u->tx_mask];
+            u->tx_tail = tail + 1;
+            u->stats.tx++;
+        }
+    }
+}
+
+uint32_t usart_buf_read(S_usartBuf *u, uint8_t *buf, uint32_t len)
+{
+    uint32_t tail, n, at, first;
+
+    usart_buf_rx_clamp(u);
+    tail = u->rx_tail;
+    n = u->rx_head - tail;
+    if( n > len ) n = len;
+    if( !n ) return 0;
+    at = tail & u->rx_mask;
+    first = u->rx_mask + 1 - at;
+    if( first > n ) first = n;
+    memcpy(buf, &u->rx[at], first);
+    memcpy(buf + first, u->rx, n - first);
+    // the slots must be read before the interrupt may refill them
+    __asm__ volatile("" ::: "memory");
+    u->rx_tail = tail + n;
+    return n;
+}
+
+uint32_t usart_buf_write(S_usartBuf *u, const uint8_t *buf, uint32_t len)
+{
+    uint32_t head = u->tx_head;
+    uint32_t n = u->tx_mask + 1 - (head - u->tx_tail);
+    uint32_t at, first;
+
+    if( n > len ) n = len;
+    if( !n ) return 0;
+    at = head & u->tx_mask;
+    first = u->tx_mask + 1 - at;
+    if( first > n ) first = n;
+    memcpy(&u->tx[at], buf, first);
+    memcpy(u->tx, buf + first, n - first);
+    // the data must be in the ring before the interrupt sees the new head
+    __asm__ volatile("" ::: "memory");
+    u->tx_head = head + n;
+
+    // the interrupt only ever clears TXEIE, on an empty ring - setting it
+    // here cannot lose the bytes just queued
+    usart_enable_tx_interrupt(u->usart);
+    return n;
+}
+
+uint32_t usart_buf_rx_span(S_usartBuf *u, const uint8_t **p)
+{
+    uint32_t n, at;
+
+    usart_buf_rx_clamp(u);
+    n = u->rx_head - u->rx_tail;
+    at = u->rx_tail & u->rx_mask;
+    if( n > u->rx_mask + 1 - at ) n = u->rx_mask + 1 - at;
+    *p = &u->rx[at];
+    return n;
+}
+
+void usart_buf_rx_consume(S_usartBuf *u, uint32_t n)
+{
+    // the slots must be read before the interrupt may refill them
+    __asm__ volatile("" ::: "memory");
+    u->rx_tail += n;
+}
+
+int usart_buf_rx_dma(S_usartBuf *u, const S_dmaStream *s,
+                     F_usartFrame frame, void *arg)
+{
+    struct dma_stream_desc d = {0};
+    uint32_t usart = u->usart;
+
+    if( u->rx_mask + 1 > USART_BUF_DMA_MAX ) return -1;
+
+    usart_disable_rx_interrupt(usart);
+    u->rxs = *s;
+    u->frame = frame;
+    u->frame_arg = arg;
+    // the DMA starts at ring index 0
+    u->rx_head = u->rx_tail = u->frame_start = 0;
+    u->rx_pos = 0;
+
+    d.channel = s->channel;
+    d.direction = DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+    d.priority = DMA_SxCR_PL_HIGH;
+    d.periph_size = DMA_SxCR_PSIZE_8BIT;
+    d.mem_size = DMA_SxCR_MSIZE_8BIT;
+    d.mode = DMA_SxCR_MINC | DMA_SxCR_CIRC;
+    d.interrupts = DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    d.periph_address = (uint32_t)&USART_DR(usart);
+    d.mem_address = (uint32_t)u->rx;
+    d.number = u->rx_mask + 1;
+    dma_configure(s->dma, s->stream, &d);
+
+    // same priority as the USART - rx_update never preempts itself
+    nvic_set_priority(s->irqn, USART_BUF_PRIORITY);
+    nvic_enable_irq(s->irqn);
+    u->rx_dma = 1;
+    (void)USART_SR(usart);
+    (void)USART_DR(usart);
+    usart_enable_rx_dma(usart);
+    usart_enable_error_interrupt(usart);
+    USART_CR1(usart) |= USART_CR1_IDLEIE;
+    dma_enable_stream(s->dma, s->stream);
+    return 0;
+}
+
+void usart_buf_dma_irq(S_usartBuf *u)
+{
+    uint32_t dma = u->rxs.dma;
+    uint8_t st = u->rxs.stream;
+
+    if( dma_get_interrupt_flag(dma, st, DMA_TEIF) ) u->stats.dma_errors++;
+    dma_clear_interrupt_flags(dma, st, USART_BUF_DMA_FLAGS);
+    usart_buf_rx_update(u);
+}
+
+uint32_t usart_buf_rx_count(const S_usartBuf *u)
+{
+    uint32_t n = u->rx_head - u->rx_tail;
+    return n > u->rx_mask + 1 ? u->rx_mask + 1 : n;
+}
+
+uint32_t usart_buf_tx_free(const S_usartBuf *u)
+{
+    return u->tx_mask + 1 - (u->tx_head - u->tx_tail);
+}
+
+void usart_buf_flush(S_usartBuf *u)
+{
+    while( u->tx_head != u->tx_tail );
+    while( !(USART_SR(u->usart) & USART_SR_TC) );
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// EXTERNAL REFERENCES